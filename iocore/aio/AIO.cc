@@ -27,7 +27,7 @@
 
 #include "P_AIO.h"
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
 #define AIO_PERIOD                                -HRTIME_MSECONDS(10)
 #else
 
@@ -46,7 +46,7 @@ volatile int num_filedes = 1;
 static ink_mutex insert_mutex;
 
 int thread_is_created = 0;
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE == AIO_MODE_THREAD
 RecInt cache_config_threads_per_disk = 12;
 RecInt api_config_threads_per_disk = 12;
 
@@ -58,6 +58,27 @@ uint64_t aio_bytes_read = 0;
 uint64_t aio_num_write = 0;
 uint64_t aio_bytes_written = 0;
 
+#if AIO_MODE == AIO_MODE_IO_URING
+#define AIO_MAX_BUFFERS 256
+#define AIO_MAX_DISKS   256
+
+RecRawStatBlock *aio_disk_rsb = NULL;
+
+// Buffers and disks are only ever appended, so readers don't need the lock.
+static ink_mutex aio_register_mutex;
+
+struct AIOBuffer
+{
+  char *buf;
+  size_t len;
+};
+static AIOBuffer aio_buffers[AIO_MAX_BUFFERS];
+static volatile int aio_num_buffers = 0;
+
+static int aio_disk_fds[AIO_MAX_DISKS];
+static volatile int aio_num_disks = 0;
+#endif
+
 /*
  * Stats
  */
@@ -159,9 +180,12 @@ ink_aio_init(ModuleVersion v)
   RecRegisterRawStat(aio_rsb, RECT_PROCESS,
                      "proxy.process.cache.KB_write_per_sec",
                      RECD_FLOAT, RECP_PERSISTENT, (int) AIO_STAT_KB_WRITE_PER_SEC, aio_stats_cb);
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_THREAD
   memset(&aio_reqs, 0, MAX_DISKS_POSSIBLE * sizeof(AIO_Reqs *));
   ink_mutex_init(&insert_mutex, NULL);
+#elif AIO_MODE == AIO_MODE_IO_URING
+  aio_disk_rsb = RecAllocateRawStatBlock(AIO_MAX_DISKS * AIO_DISK_STAT_COUNT);
+  ink_mutex_init(&aio_register_mutex, NULL);
 #endif
   REC_ReadConfigInteger(cache_config_threads_per_disk, "proxy.config.cache.threads_per_disk");
 }
@@ -176,7 +200,69 @@ ink_aio_start()
   return 0;
 }
 
-#if  AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_IO_URING
+void
+ink_aio_register_buffer(void *buf, size_t len)
+{
+  ink_mutex_acquire(&aio_register_mutex);
+  if (aio_num_buffers < AIO_MAX_BUFFERS) {
+    aio_buffers[aio_num_buffers].buf = (char *) buf;
+    aio_buffers[aio_num_buffers].len = len;
+    INK_WRITE_MEMORY_BARRIER;
+    aio_num_buffers++;
+  }
+  ink_mutex_release(&aio_register_mutex);
+}
+
+void
+ink_aio_register_disk(int fd, const char *path)
+{
+  char name[256];
+  int disk, id;
+
+  ink_mutex_acquire(&aio_register_mutex);
+  if ((disk = aio_num_disks) < AIO_MAX_DISKS) {
+    id = disk * AIO_DISK_STAT_COUNT;
+    snprintf(name, sizeof(name), "proxy.process.cache.disk_%d.aio_queue_depth", disk);
+    RecRegisterRawStat(aio_disk_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT,
+                       id + AIO_DISK_STAT_QUEUE_DEPTH, RecRawStatSyncSum);
+    snprintf(name, sizeof(name), "proxy.process.cache.disk_%d.aio_ops", disk);
+    RecRegisterRawStat(aio_disk_rsb, RECT_PROCESS, name, RECD_COUNTER, RECP_NON_PERSISTENT,
+                       id + AIO_DISK_STAT_OPS, RecRawStatSyncCount);
+    snprintf(name, sizeof(name), "proxy.process.cache.disk_%d.aio_latency", disk);
+    RecRegisterRawStat(aio_disk_rsb, RECT_PROCESS, name, RECD_FLOAT, RECP_NON_PERSISTENT,
+                       id + AIO_DISK_STAT_LATENCY, RecRawStatSyncMHrTimeAvg);
+    Debug("aio", "disk_%d is %s", disk, path);
+
+    aio_disk_fds[disk] = fd;
+    INK_WRITE_MEMORY_BARRIER;
+    aio_num_disks++;
+  }
+  ink_mutex_release(&aio_register_mutex);
+}
+
+static inline int
+aio_disk_index(int fd)
+{
+  for (int i = 0; i < aio_num_disks; ++i) {
+    if (aio_disk_fds[i] == fd)
+      return i;
+  }
+  return -1;
+}
+#else
+void
+ink_aio_register_buffer(void * /* buf ATS_UNUSED */, size_t /* len ATS_UNUSED */)
+{
+}
+
+void
+ink_aio_register_disk(int /* fd ATS_UNUSED */, const char * /* path ATS_UNUSED */)
+{
+}
+#endif
+
+#if AIO_MODE == AIO_MODE_THREAD
 
 static void *aio_thread_main(void *arg);
 
@@ -514,7 +600,7 @@ aio_thread_main(void *arg)
   }
   return 0;
 }
-#else
+#elif AIO_MODE == AIO_MODE_NATIVE
 int
 DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e) {
   SET_HANDLER(&DiskHandler::mainAIOEvent);
@@ -662,4 +748,224 @@ ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
   }
   return 1;
 }
-#endif // AIO_MODE != AIO_MODE_NATIVE
+#else // AIO_MODE == AIO_MODE_IO_URING
+DiskHandler::DiskHandler()
+  : trigger_event(NULL), submit_event(NULL), inflight(0), buffers_generation(0), num_buffers(0)
+{
+  SET_HANDLER(&DiskHandler::startAIOEvent);
+  memset(&ring, 0, sizeof(ring));
+  int ret = io_uring_queue_init(MAX_AIO_EVENTS, &ring, 0);
+  if (ret < 0) {
+    Fatal("could not set up io_uring: %s (%d)", strerror(-ret), -ret);
+  }
+}
+
+int
+DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e) {
+  SET_HANDLER(&DiskHandler::mainAIOEvent);
+#if HAVE_EVENTFD
+  // Completions wake up the thread like any other signal, so they are
+  // reaped right away instead of at the next poll timeout.
+  int ret = io_uring_register_eventfd(&ring, e->ethread->evfd);
+  if (ret < 0) {
+    Debug("aio", "io_uring_register_eventfd failed: %s (%d)", strerror(-ret), -ret);
+  }
+#endif
+  e->schedule_every(AIO_PERIOD);
+  trigger_event = e;
+  return EVENT_CONT;
+}
+
+int
+DiskHandler::mainAIOEvent(int event, Event *e) {
+  AIOCallback *op = NULL;
+
+  if (e == submit_event) {
+    submit_event = NULL;
+  }
+
+  reap();
+  // (Re)registering the buffers waits for all IO to finish, only do it
+  // when there is none.
+  if (buffers_generation != aio_num_buffers && inflight == 0) {
+    register_buffers();
+  }
+  submit();
+
+  while ((op = complete_list.dequeue()) != NULL) {
+    op->handleEvent(event, e);
+  }
+  return EVENT_CONT;
+}
+
+void
+DiskHandler::register_buffers() {
+  struct iovec iov[AIO_MAX_BUFFERS];
+  int n = aio_num_buffers;
+  int ret;
+
+  for (int i = 0; i < n; ++i) {
+    iov[i].iov_base = aio_buffers[i].buf;
+    iov[i].iov_len = aio_buffers[i].len;
+  }
+  if (num_buffers > 0) {
+    io_uring_unregister_buffers(&ring);
+    num_buffers = 0;
+  }
+  if ((ret = io_uring_register_buffers(&ring, iov, n)) < 0) {
+    // Most likely RLIMIT_MEMLOCK, the buffers just won't be fixed.
+    Debug("aio", "could not register %d buffers: %s (%d)", n, strerror(-ret), -ret);
+  } else {
+    num_buffers = n;
+  }
+  buffers_generation = n;
+}
+
+void
+DiskHandler::submit() {
+  AIOCallbackInternal *op;
+  struct io_uring_sqe *sqe;
+  EThread *t = this_ethread();
+  ink_hrtime now = ink_get_hrtime();
+  int n = 0;
+
+  while (inflight + n < MAX_AIO_EVENTS && (op = (AIOCallbackInternal *) ready_list.head) != NULL) {
+    if ((sqe = io_uring_get_sqe(&ring)) == NULL) {
+      break;
+    }
+    ready_list.dequeue();
+
+    ink_aiocb_t *a = &op->aiocb;
+    char *buf = (char *) a->aio_buf;
+    int fixed = -1;
+
+    for (int i = 0; i < num_buffers; ++i) {
+      if (buf >= aio_buffers[i].buf && buf + a->aio_nbytes <= aio_buffers[i].buf + aio_buffers[i].len) {
+        fixed = i;
+        break;
+      }
+    }
+
+    if (a->aio_lio_opcode == LIO_READ) {
+      if (fixed >= 0) {
+        io_uring_prep_read_fixed(sqe, a->aio_fildes, buf, a->aio_nbytes, a->aio_offset, fixed);
+      } else {
+        io_uring_prep_read(sqe, a->aio_fildes, buf, a->aio_nbytes, a->aio_offset);
+      }
+      aio_num_read++;
+      aio_bytes_read += a->aio_nbytes;
+    } else {
+      if (fixed >= 0) {
+        io_uring_prep_write_fixed(sqe, a->aio_fildes, buf, a->aio_nbytes, a->aio_offset, fixed);
+      } else {
+        io_uring_prep_write(sqe, a->aio_fildes, buf, a->aio_nbytes, a->aio_offset);
+      }
+      aio_num_write++;
+      aio_bytes_written += a->aio_nbytes;
+    }
+    io_uring_sqe_set_data(sqe, op);
+
+    op->submit_time = now;
+    if ((op->disk = aio_disk_index(a->aio_fildes)) >= 0) {
+      RecIncrRawStat(aio_disk_rsb, t, op->disk * AIO_DISK_STAT_COUNT + AIO_DISK_STAT_QUEUE_DEPTH, 1);
+    }
+    ++n;
+  }
+  inflight += n;
+
+  // This also retries whatever a failed submit left in the ring.
+  if (io_uring_sq_ready(&ring) > 0) {
+    int ret = io_uring_submit(&ring);
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY && ret != -EINTR) {
+      Debug("aio", "io_uring_submit failed: %s (%d)", strerror(-ret), -ret);
+    }
+  }
+}
+
+void
+DiskHandler::reap() {
+  struct io_uring_cqe *cqes[256];
+  AIOCallbackInternal *op;
+  EThread *t = this_ethread();
+  ink_hrtime now = ink_get_hrtime();
+  unsigned n;
+
+  while ((n = io_uring_peek_batch_cqe(&ring, cqes, countof(cqes))) > 0) {
+    for (unsigned i = 0; i < n; ++i) {
+      op = (AIOCallbackInternal *) io_uring_cqe_get_data(cqes[i]);
+      op->aio_result = cqes[i]->res;
+      ink_assert(op->action.continuation);
+      if (op->disk >= 0) {
+        int id = op->disk * AIO_DISK_STAT_COUNT;
+        RecIncrRawStat(aio_disk_rsb, t, id + AIO_DISK_STAT_QUEUE_DEPTH, -1);
+        RecIncrRawStat(aio_disk_rsb, t, id + AIO_DISK_STAT_OPS, 1);
+        RecIncrRawStat(aio_disk_rsb, t, id + AIO_DISK_STAT_LATENCY, now - op->submit_time);
+      }
+      complete_list.enqueue(op);
+    }
+    io_uring_cq_advance(&ring, n);
+    inflight -= n;
+  }
+}
+
+// Queue the request, it is submitted along with everything else that gets
+// queued until the thread gets back to the event loop.
+static void
+aio_queue_req(AIOCallback *op, int opcode)
+{
+  EThread *t = this_ethread();
+  DiskHandler *dh = t->diskHandler;
+
+  op->aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
+  op->aiocb.aio_lio_opcode = opcode;
+  dh->ready_list.enqueue(op);
+  if (!dh->submit_event) {
+    dh->submit_event = t->schedule_imm_local(dh);
+  }
+}
+
+static int
+aio_queue_vec(AIOCallback *op, int opcode)
+{
+  AIOCallback *io = op;
+  int sz = 0;
+
+  while (io) {
+    aio_queue_req(io, opcode);
+    ++sz;
+    io = io->then;
+  }
+
+  if (sz > 1) {
+    ink_assert(op->action.continuation);
+    AIOVec *vec = new AIOVec(sz, op);
+    while (--sz >= 0) {
+      op->action = vec;
+      op = op->then;
+    }
+  }
+  return 1;
+}
+
+int
+ink_aio_read(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
+  aio_queue_req(op, LIO_READ);
+  return 1;
+}
+
+int
+ink_aio_write(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
+  aio_queue_req(op, LIO_WRITE);
+  return 1;
+}
+
+int
+ink_aio_readv(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
+  return aio_queue_vec(op, LIO_READ);
+}
+
+int
+ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */) {
+  return aio_queue_vec(op, LIO_WRITE);
+}
+#endif // AIO_MODE == AIO_MODE_IO_URING
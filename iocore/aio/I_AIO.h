@@ -45,9 +45,12 @@
 
 #define AIO_MODE_THREAD          0
 #define AIO_MODE_NATIVE          1
+#define AIO_MODE_IO_URING        2
 
 #if TS_USE_LINUX_NATIVE_AIO
 #define AIO_MODE                 AIO_MODE_NATIVE
+#elif TS_USE_IO_URING
+#define AIO_MODE                 AIO_MODE_IO_URING
 #else
 #define AIO_MODE                 AIO_MODE_THREAD
 #endif
@@ -84,7 +87,9 @@ typedef struct ink_aiocb
   int aio__pad[1];              /* extension padding */
 } ink_aiocb_t;
 
+#if AIO_MODE == AIO_MODE_THREAD
 bool ink_aio_thread_num_set(int thread_num);
+#endif
 
 #endif
 
@@ -111,7 +116,7 @@ struct AIOCallback: public Continuation
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
 
 struct AIOVec: public Continuation
 {
@@ -129,6 +134,10 @@ struct AIOVec: public Continuation
   int mainEvent(int event, Event *e);
 };
 
+#endif
+
+#if AIO_MODE == AIO_MODE_NATIVE
+
 struct DiskHandler: public Continuation
 {
   Event *trigger_event;
@@ -147,6 +156,34 @@ struct DiskHandler: public Continuation
     }
   }
 };
+
+#elif AIO_MODE == AIO_MODE_IO_URING
+
+#include <liburing.h>
+
+#define MAX_AIO_EVENTS 1024
+
+// One io_uring per event thread. Requests are queued on ready_list and
+// submitted in one go from the thread's event loop, completions are
+// reaped from the completion queue every time around the loop, and the
+// ring signals the thread's eventfd so a completion wakes up the thread.
+struct DiskHandler: public Continuation
+{
+  Event *trigger_event;
+  Event *submit_event;          // pending immediate submit of ready_list
+  struct io_uring ring;
+  int inflight;                 // submitted, not yet reaped
+  int buffers_generation;       // of the buffers registered with the ring
+  int num_buffers;              // registered with the ring
+  Que(AIOCallback, link) ready_list;
+  Que(AIOCallback, link) complete_list;
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+  void register_buffers();
+  void submit();
+  void reap();
+  DiskHandler();
+};
 #endif
 
 void ink_aio_init(ModuleVersion version);
@@ -158,4 +195,10 @@ int ink_aio_write(AIOCallback *op, int fromAPI = 0);
 int ink_aio_readv(AIOCallback *op, int fromAPI = 0);   // fromAPI is a boolean to indicate if this is from a API call such as upload proxy feature
 int ink_aio_writev(AIOCallback *op, int fromAPI = 0);
 AIOCallback *new_AIOCallback(void);
+
+// Optional hints for the backends which can make use of them (io_uring):
+// buffers which are used for IO over and over again, and the disks whose
+// queue depth and latency are to be tracked.
+void ink_aio_register_buffer(void *buf, size_t len);
+void ink_aio_register_disk(int fd, const char *path);
 #endif
@@ -48,16 +48,24 @@ AIOCallback::ok()
   return (off_t) aiocb.aio_nbytes == (off_t) aio_result;
 }
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
 
 extern Continuation *aio_err_callbck;
 
 struct AIOCallbackInternal: public AIOCallback
 {
+#if AIO_MODE == AIO_MODE_IO_URING
+  ink_hrtime submit_time;
+  int disk;                     // index of the registered disk, -1 if none
+#endif
   int io_complete(int event, void *data);
   AIOCallbackInternal()
   {
     memset ((char *) &(this->aiocb), 0, sizeof(this->aiocb));
+#if AIO_MODE == AIO_MODE_IO_URING
+    submit_time = 0;
+    disk = -1;
+#endif
     SET_HANDLER(&AIOCallbackInternal::io_complete);
   }
 };
@@ -93,7 +101,7 @@ AIOVec::mainEvent(int /* event */, Event *) {
   return EVENT_ERROR;
 }
 
-#else /* AIO_MODE != AIO_MODE_NATIVE */
+#else /* AIO_MODE == AIO_MODE_THREAD */
 
 struct AIO_Reqs;
 
@@ -141,7 +149,7 @@ struct AIO_Reqs
   volatile int requests_queued;
 };
 
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE != AIO_MODE_THREAD
 #ifdef AIO_STATS
 class AIOTestData:public Continuation
 {
@@ -171,4 +179,14 @@ enum aio_stat_enum
 };
 extern RecRawStatBlock *aio_rsb;
 
+// per disk stats, see ink_aio_register_disk()
+enum aio_disk_stat_enum
+{
+  AIO_DISK_STAT_QUEUE_DEPTH,
+  AIO_DISK_STAT_OPS,
+  AIO_DISK_STAT_LATENCY,
+  AIO_DISK_STAT_COUNT
+};
+extern RecRawStatBlock *aio_disk_rsb;
+
 #endif
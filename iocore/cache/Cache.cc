@@ -67,9 +67,13 @@ int cache_config_permit_pinning = 0;
 int cache_config_vary_on_user_agent = 0;
 int cache_config_select_alternate = 1;
 int cache_config_max_doc_size = 0;
+int cache_config_admission_enabled = 0;
+int cache_config_admission_threshold = 2;
+int64_t cache_config_admission_sketch_entries = 1048576;
 int cache_config_min_average_object_size = ESTIMATED_OBJECT_SIZE;
 int64_t cache_config_ram_cache_cutoff = AGG_SIZE;
 int cache_config_max_disk_errors = 5;
+int cache_config_key_hash = CACHE_KEY_HASH_MMH;
 int cache_config_hit_evacuate_percent = 10;
 int cache_config_hit_evacuate_size_limit = 0;
 int cache_config_force_sector_size = 0;
@@ -79,6 +83,9 @@ int cache_config_enable_checksum = 0;
 int cache_config_alt_rewrite_max_size = 4096;
 int cache_config_read_while_writer = 0;
 int cache_config_mutex_retry_delay = 2;
+int cache_config_vol_assignment = VOL_ASSIGN_RING;
+int64_t cache_config_max_stripe_size = 0;
+int cache_config_agg_write_buffers = 1;
 #ifdef HTTP_CACHE
 static int enable_cache_empty_http_doc = 0;
 /// Fix up a specific known problem with the 4.2.0 release.
@@ -150,7 +157,7 @@ struct VolInitInfo
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
 struct VolInit : public Continuation
 {
   Vol *vol;
@@ -600,7 +607,7 @@ CacheProcessor::start_internal(int flags)
   ink_assert((int)TS_EVENT_CACHE_SCAN_OPERATION_FAILED == (int)CACHE_EVENT_SCAN_OPERATION_FAILED);
   ink_assert((int)TS_EVENT_CACHE_SCAN_DONE == (int)CACHE_EVENT_SCAN_DONE);
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
   int etype = ET_NET;
   int n_netthreads = eventProcessor.n_threads_for_type[etype];
   EThread **netthreads = eventProcessor.eventthread[etype];
@@ -743,6 +750,7 @@ CacheProcessor::start_internal(int flags)
 
         gdisks[gndisks] = new CacheDisk();
         gdisks[gndisks]->forced_volume_num = sd->forced_volume_num;
+        gdisks[gndisks]->agg_write_buffers = sd->agg_write_buffers;
         if (sd->hash_base_string)
           gdisks[gndisks]->hash_base_string = ats_strdup(sd->hash_base_string);
 
@@ -762,7 +770,7 @@ CacheProcessor::start_internal(int flags)
 
         off_t skip = ROUND_TO_STORE_BLOCK((sd->offset < START_POS ? START_POS + sd->alignment : sd->offset));
         blocks = blocks - (skip >> STORE_BLOCK_SHIFT);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
         eventProcessor.schedule_imm(new DiskInit(gdisks[gndisks], path, blocks, skip, sector_size, fd, clear));
 #else
         gdisks[gndisks]->open(path, blocks, skip, sector_size, fd, clear);
@@ -963,6 +971,24 @@ CacheProcessor::cacheInitialized()
       cacheProcessor.max_stripe_version = v->header->version;
   }
 
+  // Keys made with one hash can't be found with another, so a cache
+  // keeps the hash it was written with until its stripes are cleared.
+  // Stripes cleared just now already hold the configured hash.
+  for (i = 0; i < gnvol; i++) {
+    Vol *v = gvol[i];
+    // Before version 23 the field was not there, and keys were MMH
+    CacheKeyHash h = v->header->version.ink_major < 23 ? CACHE_KEY_HASH_MMH : (CacheKeyHash) v->header->key_hash;
+
+    if (h != cache_config_key_hash) {
+      Warning("cache stripe '%s' was written with key hash %d, not the configured %d; "
+              "keeping it until the cache is cleared", v->hash_text.get(), h, cache_config_key_hash);
+      cacheProcessor.key_hash = h;
+      break;
+    }
+  }
+  for (i = 0; i < gnvol; i++)
+    gvol[i]->header->key_hash = cacheProcessor.key_hash;
+
 
   if (caches_ready) {
     Debug("cache_init", "CacheProcessor::cacheInitialized - caches_ready=0x%0X, gnvol=%d", (unsigned int) caches_ready,
@@ -981,6 +1007,9 @@ CacheProcessor::cacheInitialized()
           case RAM_CACHE_ALGORITHM_LRU:
             gvol[i]->ram_cache = new_RamCacheLRU();
             break;
+          case RAM_CACHE_ALGORITHM_S3FIFO:
+            gvol[i]->ram_cache = new_RamCacheS3FIFO();
+            break;
         }
       }
       // let us calculate the Size
@@ -1094,6 +1123,7 @@ CacheProcessor::cacheInitialized()
       GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_total_stat, total_direntries);
       GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_used_stat, used_direntries);
       dir_sync_init();
+      ram_cache_index_init();
       cache_init_ok = 1;
     } else
       Warning("cache unable to open any vols, disabled");
@@ -1224,6 +1254,7 @@ vol_clear_init(Vol *d)
   d->header->cycle = 0;
   d->header->create_time = time(NULL);
   d->header->dirty = 0;
+  d->header->key_hash = cacheProcessor.key_hash;
   d->sector_size = d->header->sector_size = d->disk->hw_sector_size;
   *d->footer = *d->header;
 
@@ -1266,6 +1297,28 @@ Vol::clear_dir()
   return 0;
 }
 
+void
+Vol::init_agg_buffers()
+{
+  agg_buffer_count = disk->agg_write_buffers ? disk->agg_write_buffers : cache_config_agg_write_buffers;
+  if (agg_buffer_count < 1)
+    agg_buffer_count = 1;
+  else if (agg_buffer_count > AGG_WRITE_BUFFERS_MAX)
+    agg_buffer_count = AGG_WRITE_BUFFERS_MAX;
+  agg_buffers = new AggBuffer[agg_buffer_count];
+  for (int i = 0; i < agg_buffer_count; i++) {
+    AggBuffer *b = &agg_buffers[i];
+    b->vol = this;
+    b->mutex = mutex;
+    b->buf = (char *)ats_memalign(ats_pagesize(), AGG_SIZE);
+    memset(b->buf, 0, AGG_SIZE);
+    ink_aio_register_buffer(b->buf, AGG_SIZE);
+  }
+  agg_cur = 0;
+  agg_in_flight = 0;
+  agg_buffer = agg_buffers[0].buf;
+}
+
 int
 Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
 {
@@ -1283,6 +1336,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   path = ats_strdup(s);
   len = blocks * STORE_BLOCK_SIZE;
   ink_assert(len <= MAX_VOL_SIZE);
+  init_agg_buffers();
   skip = dir_skip;
   prev_recover_pos = 0;
 
@@ -1303,6 +1357,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   dir = (Dir *) (raw_dir + vol_headerlen(this));
   header = (VolHeaderFooter *) raw_dir;
   footer = (VolHeaderFooter *) (raw_dir + vol_dirlen(this) - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
+  dir_seq = (volatile uint32_t *)ats_calloc(segments, sizeof(uint32_t));
 
 #if TS_USE_INTERIM_CACHE == 1
   num_interim_vols = good_interim_disks;
@@ -1345,7 +1400,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
     aio->thread = AIO_CALLBACK_THREAD_ANY;
     aio->then = (i < 3) ? &(init_info->vol_aio[i + 1]) : 0;
   }
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
   ink_assert(ink_aio_readv(init_info->vol_aio));
 #else
   ink_assert(ink_aio_read(init_info->vol_aio));
@@ -1652,8 +1707,10 @@ Ldone:{
       return handle_recover_write_dir(EVENT_IMMEDIATE, 0);
     }
 
-    recover_pos += EVACUATION_SIZE;   // safely cover the max write size
-    if (recover_pos < header->write_pos && (recover_pos + EVACUATION_SIZE >= header->write_pos)) {
+    // safely cover the max write size, and the aggregation buffers
+    // that may have been written out of order after recover_pos
+    recover_pos += RECOVERY_CLEAR_SIZE;
+    if (recover_pos < header->write_pos && (recover_pos + RECOVERY_CLEAR_SIZE >= header->write_pos)) {
       Debug("cache_init", "Head Pos: %" PRIu64 ", Rec Pos: %" PRIu64 ", Wrapped:%d", header->write_pos, recover_pos, recover_wrapped);
       Warning("no valid directory found while recovering '%s', clearing", hash_text.get());
       goto Lclear;
@@ -1703,7 +1760,7 @@ Ldone:{
     init_info->vol_aio[2].aiocb.aio_offset = ss + dirlen - footerlen;
 
     SET_HANDLER(&Vol::handle_recover_write_dir);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
     ink_assert(ink_aio_writev(init_info->vol_aio));
 #else
     ink_assert(ink_aio_write(init_info->vol_aio));
@@ -1797,6 +1854,7 @@ Vol::dir_init_done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */ )
     int vol_no = ink_atomic_increment(&gnvol, 1);
     ink_assert(!gvol[vol_no]);
     gvol[vol_no] = this;
+    agg_write_pos = header->write_pos;
     SET_HANDLER(&Vol::aggWrite);
     if (fd == -1)
       cache->vol_initialized(0);
@@ -2021,32 +2079,15 @@ Lfinish:
 }
 #endif
 
-// explicit pair for random table in build_vol_hash_table
-struct rtable_pair {
-  unsigned int rval; ///< relative value, used to sort.
-  unsigned int idx; ///< volume mapping table index.
-};
-
-// comparison operator for random table in build_vol_hash_table
-// sorts based on the randomly assigned rval
-static int
-cmprtable(const void *aa, const void *bb) {
-  rtable_pair *a = (rtable_pair*)aa;
-  rtable_pair *b = (rtable_pair*)bb;
-  if (a->rval < b->rval) return -1;
-  if (a->rval > b->rval) return 1;
-  return 0;
-}
-
 void
 build_vol_hash_table(CacheHostRecord *cp)
 {
   int num_vols = cp->num_vols;
   unsigned int *mapping = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
-  Vol **p = (Vol **)ats_malloc(sizeof(Vol *) * num_vols);
+  CryptoHash *ids = (CryptoHash *)ats_malloc(sizeof(CryptoHash) * num_vols);
+  int64_t *lens = (int64_t *)ats_malloc(sizeof(int64_t) * num_vols);
 
   memset(mapping, 0, num_vols * sizeof(unsigned int));
-  memset(p, 0, num_vols * sizeof(Vol *));
   uint64_t total = 0;
   int bad_vols = 0;
   int map = 0;
@@ -2058,7 +2099,8 @@ build_vol_hash_table(CacheHostRecord *cp)
       continue;
     }
     mapping[map] = i;
-    p[map++] = cp->vols[i];
+    ids[map] = cp->vols[i]->hash_id;
+    lens[map++] = cp->vols[i]->len;
     total += (cp->vols[i]->len >> STORE_BLOCK_SHIFT);
   }
 
@@ -2071,59 +2113,30 @@ build_vol_hash_table(CacheHostRecord *cp)
     }
     cp->vol_hash_table = NULL;
     ats_free(mapping);
-    ats_free(p);
+    ats_free(ids);
+    ats_free(lens);
     return;
   }
 
   unsigned int *forvol = (unsigned int *) ats_malloc(sizeof(unsigned int) * num_vols);
   unsigned int *gotvol = (unsigned int *) ats_malloc(sizeof(unsigned int) * num_vols);
-  unsigned int *rnd = (unsigned int *) ats_malloc(sizeof(unsigned int) * num_vols);
   unsigned short *ttable = (unsigned short *)ats_malloc(sizeof(unsigned short) * VOL_HASH_TABLE_SIZE);
   unsigned short *old_table;
-  unsigned int *rtable_entries = (unsigned int *) ats_malloc(sizeof(unsigned int) * num_vols);
-  unsigned int rtable_size = 0;
 
   // estimate allocation
   for (int i = 0; i < num_vols; i++) {
-    forvol[i] = (VOL_HASH_TABLE_SIZE * (p[i]->len >> STORE_BLOCK_SHIFT)) / total;
+    forvol[i] = (VOL_HASH_TABLE_SIZE * (lens[i] >> STORE_BLOCK_SHIFT)) / total;
     used += forvol[i];
-    rtable_entries[i] = p[i]->len / VOL_HASH_ALLOC_SIZE;
-    rtable_size += rtable_entries[i];
     gotvol[i] = 0;
   }
   // spread around the excess
   int extra = VOL_HASH_TABLE_SIZE - used;
   for (int i = 0; i < extra; i++)
     forvol[i % num_vols]++;
-  // seed random number generator
-  for (int i = 0; i < num_vols; i++) {
-    uint64_t x = p[i]->hash_id.fold();
-    rnd[i] = (unsigned int) x;
-  }
-  // initialize table to "empty"
-  for (int i = 0; i < VOL_HASH_TABLE_SIZE; i++)
-    ttable[i] = VOL_HASH_EMPTY;
-  // generate random numbers proportaion to allocation
-  rtable_pair *rtable = (rtable_pair *)ats_malloc(sizeof(rtable_pair) * rtable_size);
-  int rindex = 0;
-  for (int i = 0; i < num_vols; i++)
-    for (int j = 0; j < (int)rtable_entries[i]; j++) {
-      rtable[rindex].rval = next_rand(&rnd[i]);
-      rtable[rindex].idx = i;
-      rindex++;
-    }
-  ink_assert(rindex == (int)rtable_size);
-  // sort (rand #, vol $ pairs)
-  qsort(rtable, rtable_size, sizeof(rtable_pair), cmprtable);
-  unsigned int width = (1LL << 32) / VOL_HASH_TABLE_SIZE;
-  unsigned int pos;  // target position to allocate
-  // select vol with closest random number for each bucket
-  int i = 0;  // index moving through the random numbers
+  vol_hash_table_fill(ttable, num_vols, ids, lens, cache_config_vol_assignment);
   for (int j = 0; j < VOL_HASH_TABLE_SIZE; j++) {
-    pos = width / 2 + j * width;  // position to select closest to
-    while (pos > rtable[i].rval && i < (int)rtable_size - 1) i++;
-    ttable[j] = mapping[rtable[i].idx];
-    gotvol[rtable[i].idx]++;
+    gotvol[ttable[j]]++;
+    ttable[j] = mapping[ttable[j]];
   }
   for (int i = 0; i < num_vols; i++) {
     Debug("cache_init", "build_vol_hash_table index %d mapped to %d requested %d got %d", i, mapping[i], forvol[i], gotvol[i]);
@@ -2132,12 +2145,10 @@ build_vol_hash_table(CacheHostRecord *cp)
   if (0 != (old_table = ink_atomic_swap(&(cp->vol_hash_table), ttable)))
     new_Freer(old_table, CACHE_MEM_FREE_TIMEOUT);
   ats_free(mapping);
-  ats_free(p);
+  ats_free(ids);
+  ats_free(lens);
   ats_free(forvol);
   ats_free(gotvol);
-  ats_free(rnd);
-  ats_free(rtable_entries);
-  ats_free(rtable);
 }
 
 void
@@ -2324,7 +2335,7 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */) {
             blocks = q->b->len;
 
             bool vol_clear = clear || d->cleared || q->new_block;
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
             eventProcessor.schedule_imm(new VolInit(cp->vols[vol_no], d->path, blocks, q->b->offset, vol_clear));
 #else
             cp->vols[vol_no]->init(d->path, blocks, q->b->offset, vol_clear);
@@ -2474,8 +2485,10 @@ CacheVC::handleReadDone(int event, Event *e)
       return EVENT_CONT;
   {
     MUTEX_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
-    if (!lock)
+    if (!lock) {
+      VOL_LOCK_MISS(vol, mutex->thread_holding);
       VC_SCHED_LOCK_RETRY();
+    }
     if ((!dir_valid(vol, &dir)) || (!io.ok())) {
       if (!io.ok()) {
         Debug("cache_disk_error", "Read error on disk %s\n \
@@ -2731,11 +2744,10 @@ LinterimRead:
 #endif
   // see if its in the aggregation buffer
   if (dir_agg_buf_valid(vol, &dir)) {
-    int agg_offset = vol_offset(vol, &dir) - vol->header->write_pos;
     buf = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
-    ink_assert((agg_offset + io.aiocb.aio_nbytes) <= (unsigned) vol->agg_buf_pos);
+    ink_assert((off_t)(vol_offset(vol, &dir) + io.aiocb.aio_nbytes) <= vol_agg_end(vol));
     char *doc = buf->data();
-    char *agg = vol->agg_buffer + agg_offset;
+    char *agg = vol->agg_buffer_data(vol_offset(vol, &dir));
     memcpy(doc, agg, io.aiocb.aio_nbytes);
     io.aio_result = io.aiocb.aio_nbytes;
     SET_HANDLER(&CacheVC::handleReadDone);
@@ -2823,8 +2835,10 @@ CacheVC::removeEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   set_io_not_in_progress();
   {
     MUTEX_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
-    if (!lock)
+    if (!lock) {
+      VOL_LOCK_MISS(vol, mutex->thread_holding);
       VC_SCHED_LOCK_RETRY();
+    }
     if (_action.cancelled) {
       if (od) {
         vol->close_write(this);
@@ -3110,8 +3124,7 @@ cplist_reconfigure()
         gdisks[i]->delete_all_volumes();
       }
       if (gdisks[i]->cleared) {
-        uint64_t free_space = gdisks[i]->free_space * STORE_BLOCK_SIZE;
-        int vols = (free_space / MAX_VOL_SIZE) + 1;
+        int vols = (gdisks[i]->free_space / cache_max_stripe_blocks()) + 1;
         for (int p = 0; p < vols; p++) {
           off_t b = gdisks[i]->free_space / (vols - p);
           Debug("cache_hosting", "blocks = %" PRId64, (int64_t)b);
@@ -3302,6 +3315,19 @@ cplist_reconfigure()
 }
 
 // This is some really bad code, and needs to be rewritten!
+// Each stripe has its own lock, directory and aggregation buffer, so
+// large spans are split to spread the locking.
+off_t
+cache_max_stripe_blocks()
+{
+  int64_t size = cache_config_max_stripe_size;
+  if (size <= 0 || size > MAX_VOL_SIZE)
+    size = MAX_VOL_SIZE;
+  if (size < VOL_BLOCK_SIZE)
+    size = VOL_BLOCK_SIZE;
+  return ROUND_DOWN_TO_VOL_BLOCK(size) >> STORE_BLOCK_SHIFT;
+}
+
 int
 create_volume(int volume_number, off_t size_in_blocks, int scheme, CacheVol *cp)
 {
@@ -3477,6 +3503,11 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("hdr_marshal_bytes", cache_hdr_marshal_bytes_stat);
   REG_INT("gc_bytes_evacuated", cache_gc_bytes_evacuated_stat);
   REG_INT("gc_frags_evacuated", cache_gc_frags_evacuated_stat);
+  REG_INT("admission.admitted", cache_admission_admitted_stat);
+  REG_INT("admission.rejected", cache_admission_rejected_stat);
+  REG_INT("ram_cache.prefetched", cache_ram_cache_prefetched_stat);
+  REG_INT("vol_lock.miss", cache_vol_lock_miss_stat);
+  REG_INT("vol_lock.miss_probed", cache_vol_lock_miss_probed_stat);
 }
 
 
@@ -3495,6 +3526,14 @@ ink_cache_init(ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress, "proxy.config.cache.ram_cache.compress");
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress_percent, "proxy.config.cache.ram_cache.compress_percent");
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_use_seen_filter, "proxy.config.cache.ram_cache.use_seen_filter");
+  REC_ReadConfigInt32(cache_config_ram_cache_index_enabled, "proxy.config.cache.ram_cache.index.enabled");
+  REC_ReadConfigInt32(cache_config_ram_cache_index_save_interval, "proxy.config.cache.ram_cache.index.save_interval");
+  REC_ReadConfigInt32(cache_config_ram_cache_index_prefetch_rate, "proxy.config.cache.ram_cache.index.prefetch_rate");
+  Debug("cache_init", "proxy.config.cache.ram_cache.index.enabled = %d, save_interval = %ds, prefetch_rate = %d/s",
+        cache_config_ram_cache_index_enabled, cache_config_ram_cache_index_save_interval,
+        cache_config_ram_cache_index_prefetch_rate);
+  REC_EstablishStaticConfigInt32(cache_config_inventory_rate, "proxy.config.cache.inventory.rate");
+  Debug("cache_init", "proxy.config.cache.inventory.rate = %dKB/s", cache_config_inventory_rate);
 
   REC_EstablishStaticConfigInt32(cache_config_http_max_alts, "proxy.config.cache.limits.http.max_alts");
   Debug("cache_init", "proxy.config.cache.limits.http.max_alts = %d", cache_config_http_max_alts);
@@ -3519,9 +3558,26 @@ ink_cache_init(ModuleVersion v)
   Debug("cache_init", "proxy.config.cache.max_doc_size = %d = %dMb",
         cache_config_max_doc_size, cache_config_max_doc_size / (1024 * 1024));
 
+  REC_ReadConfigInt32(cache_config_admission_enabled, "proxy.config.cache.admission.enabled");
+  REC_ReadConfigInteger(cache_config_admission_sketch_entries, "proxy.config.cache.admission.sketch_entries");
+  REC_EstablishStaticConfigInt32(cache_config_admission_threshold, "proxy.config.cache.admission.threshold");
+  Debug("cache_init", "proxy.config.cache.admission.enabled = %d, threshold = %d, sketch_entries = %" PRId64,
+        cache_config_admission_enabled, cache_config_admission_threshold, cache_config_admission_sketch_entries);
+  if (cache_config_admission_enabled)
+    cache_admission.init(cache_config_admission_sketch_entries);
+
   REC_EstablishStaticConfigInt32(cache_config_mutex_retry_delay, "proxy.config.cache.mutex_retry_delay");
   Debug("cache_init", "proxy.config.cache.mutex_retry_delay = %dms", cache_config_mutex_retry_delay);
 
+  REC_ReadConfigInt32(cache_config_vol_assignment, "proxy.config.cache.vol_assignment");
+  Debug("cache_init", "proxy.config.cache.vol_assignment = %d", cache_config_vol_assignment);
+
+  REC_ReadConfigInteger(cache_config_max_stripe_size, "proxy.config.cache.max_stripe_size");
+  Debug("cache_init", "proxy.config.cache.max_stripe_size = %" PRId64, cache_config_max_stripe_size);
+
+  REC_ReadConfigInt32(cache_config_agg_write_buffers, "proxy.config.cache.agg_write_buffers");
+  Debug("cache_init", "proxy.config.cache.agg_write_buffers = %d", cache_config_agg_write_buffers);
+
   REC_EstablishStaticConfigInt32(cache_config_hit_evacuate_percent, "proxy.config.cache.hit_evacuate_percent");
   Debug("cache_init", "proxy.config.cache.hit_evacuate_percent = %d", cache_config_hit_evacuate_percent);
 
@@ -3548,6 +3604,14 @@ ink_cache_init(ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_max_disk_errors, "proxy.config.cache.max_disk_errors");
   Debug("cache_init", "proxy.config.cache.max_disk_errors = %d", cache_config_max_disk_errors);
 
+  REC_ReadConfigInt32(cache_config_key_hash, "proxy.config.cache.key_hash");
+  if (cache_config_key_hash < CACHE_KEY_HASH_MMH || cache_config_key_hash > CACHE_KEY_HASH_MURMUR3) {
+    Warning("invalid proxy.config.cache.key_hash %d, using MMH", cache_config_key_hash);
+    cache_config_key_hash = CACHE_KEY_HASH_MMH;
+  }
+  cacheProcessor.key_hash = (CacheKeyHash) cache_config_key_hash;
+  Debug("cache_init", "proxy.config.cache.key_hash = %d", cache_config_key_hash);
+
   REC_EstablishStaticConfigInt32(cache_config_agg_write_backlog, "proxy.config.cache.agg_write_backlog");
   Debug("cache_init", "proxy.config.cache.agg_write_backlog = %d", cache_config_agg_write_backlog);
 
@@ -0,0 +1,176 @@
+/** @file
+
+  Admission filter for cache writes
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Cache.h"
+
+CacheAdmissionFilter cache_admission;
+
+#define COUNTER_MASK   ((uint64_t)0xF)
+#define COUNTER_SHIFT(_idx) (((_idx) & 15) << 2)
+
+void
+CacheAdmissionFilter::init(int64_t entries)
+{
+  int64_t counters = 256;
+
+  ink_release_assert(!table);
+  while (counters < entries && counters < ((int64_t)1 << 31))
+    counters <<= 1;
+
+  row_words = counters / 16;
+  row_mask = (uint32_t)(counters - 1);
+  sample_size = 10 * counters;
+  additions = 0;
+  table = (volatile uint64_t *)ats_calloc(CACHE_ADMISSION_ROWS * row_words, sizeof(uint64_t));
+}
+
+int
+CacheAdmissionFilter::frequency(const INK_MD5 & key) const
+{
+  int freq = CACHE_ADMISSION_MAX_COUNT;
+
+  for (int i = 0; i < CACHE_ADMISSION_ROWS; i++) {
+    uint32_t idx = key.slice32(i) & row_mask;
+    int count = (int)((table[i * row_words + (idx >> 4)] >> COUNTER_SHIFT(idx)) & COUNTER_MASK);
+
+    if (count < freq)
+      freq = count;
+  }
+
+  return freq;
+}
+
+int
+CacheAdmissionFilter::record(const INK_MD5 & key)
+{
+  volatile uint64_t *words[CACHE_ADMISSION_ROWS];
+  int shifts[CACHE_ADMISSION_ROWS];
+  int counts[CACHE_ADMISSION_ROWS];
+  int freq = CACHE_ADMISSION_MAX_COUNT;
+
+  for (int i = 0; i < CACHE_ADMISSION_ROWS; i++) {
+    uint32_t idx = key.slice32(i) & row_mask;
+
+    words[i] = table + i * row_words + (idx >> 4);
+    shifts[i] = COUNTER_SHIFT(idx);
+    counts[i] = (int)((*words[i] >> shifts[i]) & COUNTER_MASK);
+    if (counts[i] < freq)
+      freq = counts[i];
+  }
+
+  if (freq >= CACHE_ADMISSION_MAX_COUNT)
+    return freq;
+
+  // Conservative update, the counters above the minimum already
+  // over estimate this key.
+  for (int i = 0; i < CACHE_ADMISSION_ROWS; i++) {
+    if (counts[i] != freq)
+      continue;
+    for (;;) {
+      uint64_t old = *words[i];
+
+      if (((old >> shifts[i]) & COUNTER_MASK) >= CACHE_ADMISSION_MAX_COUNT ||
+          ink_atomic_cas(words[i], old, old + ((uint64_t)1 << shifts[i])))
+        break;
+    }
+  }
+
+  if (ink_atomic_increment(&additions, 1) + 1 == sample_size)
+    age();
+
+  return freq + 1;
+}
+
+// Halve every counter, one word (16 counters) at a time.
+void
+CacheAdmissionFilter::age()
+{
+  for (int64_t i = 0; i < CACHE_ADMISSION_ROWS * row_words; i++) {
+    for (;;) {
+      uint64_t old = table[i];
+
+      if (ink_atomic_cas(&table[i], old, (old >> 1) & (uint64_t)0x7777777777777777ULL))
+        break;
+    }
+  }
+  ink_atomic_increment(&additions, -(sample_size / 2));
+  Debug("cache_admission", "aged the admission sketch after %" PRId64 " sightings", sample_size);
+}
+
+#ifdef HTTP_CACHE
+//
+// Record a sighting of a document the cache doesn't have, and decide
+// whether it is popular enough to be written.
+//
+bool
+Cache::admit(CacheKey *key)
+{
+  int freq = cache_admission.record(*key);
+
+  if (freq >= cache_config_admission_threshold) {
+    GLOBAL_CACHE_SUM_DYN_STAT_THREAD(cache_admission_admitted_stat, 1);
+    return true;
+  }
+
+  GLOBAL_CACHE_SUM_DYN_STAT_THREAD(cache_admission_rejected_stat, 1);
+  Debug("cache_admission", "not admitting %X, seen %d times", key->slice32(0), freq);
+  return false;
+}
+#endif
+
+#if TS_HAS_TESTS
+#include "ts/TestBox.h"
+
+REGRESSION_TEST(cache_admission_sketch)(RegressionTest * t, int /* atype ATS_UNUSED */, int * pstatus)
+{
+  TestBox box(t, pstatus);
+  CacheAdmissionFilter filter;
+  INK_MD5 key, other;
+  int i;
+
+  box = REGRESSION_TEST_PASSED;
+
+  filter.init(1024);
+  MD5Context().hash_immediate(key, "http://example.com/a", 20);
+  MD5Context().hash_immediate(other, "http://example.com/b", 20);
+
+  box.check(filter.frequency(key) == 0, "new key has frequency %d", filter.frequency(key));
+  box.check(filter.record(key) == 1, "first sighting");
+  box.check(filter.record(key) == 2, "second sighting");
+  box.check(filter.frequency(other) == 0, "other key has frequency %d", filter.frequency(other));
+
+  for (i = 0; i < 2 * CACHE_ADMISSION_MAX_COUNT; i++)
+    filter.record(key);
+  box.check(filter.frequency(key) == CACHE_ADMISSION_MAX_COUNT, "counter saturates at %d", filter.frequency(key));
+
+  // Fill the sample with other keys, which ages the sketch.
+  for (i = 0; filter.frequency(key) == CACHE_ADMISSION_MAX_COUNT && i < 10 * 1024; i++) {
+    INK_MD5 k;
+
+    MD5Context().hash_immediate(k, &i, sizeof(i));
+    filter.record(k);
+  }
+  box.check(filter.frequency(key) == CACHE_ADMISSION_MAX_COUNT / 2, "aged frequency %d", filter.frequency(key));
+}
+
+#endif // TS_HAS_TESTS
@@ -171,6 +171,29 @@ OpenDirEntry::wait(CacheVC *cont, int msec)
 // Cache Directory
 //
 
+// Everything that changes a directory segment holds the vol lock, and
+// while it does the segment's sequence number is odd. This lets
+// dir_probe_miss_unlocked() tell whether it raced with a writer.
+// Nested writers (e.g. dir_insert -> freelist_clean) leave the number
+// to the outermost one.
+struct DirSegmentWrite
+{
+  volatile uint32_t *seq;
+  bool outer;
+
+  DirSegmentWrite(int s, Vol *d)
+    : seq(&d->dir_seq[s]), outer(!(*seq & 1))
+  {
+    if (outer)
+      ink_atomic_increment(seq, 1);
+  }
+  ~DirSegmentWrite()
+  {
+    if (outer)
+      ink_atomic_increment(seq, 1);
+  }
+};
+
 // return value 1 means no loop
 // zero indicates loop
 int
@@ -203,6 +226,7 @@ dir_bucket_loop_check(Dir *start_dir, Dir *seg)
 void
 dir_init_segment(int s, Vol *d)
 {
+  DirSegmentWrite w(s, d);
   d->header->freelist[s] = 0;
   Dir *seg = dir_segment(s, d);
   int l, b;
@@ -356,6 +380,7 @@ dir_clean_bucket(Dir *b, int s, Vol *vol)
 void
 dir_clean_segment(int s, Vol *d)
 {
+  DirSegmentWrite w(s, d);
   Dir *seg = dir_segment(s, d);
   for (int64_t i = 0; i < d->buckets; i++) {
     dir_clean_bucket(dir_bucket(i, seg), s, d);
@@ -466,14 +491,19 @@ dir_clean_range_interimvol(off_t start, off_t end, InterimCacheVol *svol)
 void
 dir_clear_range(off_t start, off_t end, Vol *vol)
 {
-  for (off_t i = 0; i < vol->buckets * DIR_DEPTH * vol->segments; i++) {
-    Dir *e = dir_index(vol, i);
-    if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
-      CACHE_DEC_DIR_USED(vol->mutex);
-      dir_set_offset(e, 0);     // delete
+  for (int s = 0; s < vol->segments; s++) {
+    DirSegmentWrite w(s, vol);
+    Dir *seg = dir_segment(s, vol);
+    for (off_t i = 0; i < vol->buckets * DIR_DEPTH; i++) {
+      Dir *e = dir_in_seg(seg, i);
+      if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
+        CACHE_DEC_DIR_USED(vol->mutex);
+        dir_set_offset(e, 0);     // delete
+      }
     }
+    dir_clean_segment(s, vol);
   }
-  dir_clean_vol(vol);
+  CHECK_DIR(vol);
 }
 
 void
@@ -491,6 +521,7 @@ check_bucket_not_contains(Dir *b, Dir *e, Dir *seg)
 void
 freelist_clean(int s, Vol *vol)
 {
+  DirSegmentWrite w(s, vol);
   dir_clean_segment(s, vol);
   if (vol->header->freelist[s])
     return;
@@ -632,6 +663,7 @@ Lagain:
 #endif
           return 1;
         } else {                // delete the invalid entry
+          DirSegmentWrite w(s, d);
           CACHE_DEC_DIR_USED(d->mutex);
           e = dir_delete_entry(e, p, s, d);
           continue;
@@ -653,6 +685,38 @@ Lagain:
   return 0;
 }
 
+// Probe the directory without the vol lock. Only a miss is reported,
+// and only if no writer changed the segment while the bucket was walked.
+// Any entry with a matching tag, valid or not, is left to dir_probe(),
+// and so is a key whose lookaside list is not empty.
+bool
+dir_probe_miss_unlocked(CacheKey *key, Vol *d)
+{
+  int s = key->slice32(0) % d->segments;
+  int b = key->slice32(1) % d->buckets;
+  EvacuationBlock *volatile *lookaside = &d->lookaside[key->slice32(3) % LOOKASIDE_SIZE].head;
+  volatile uint32_t *seq = &d->dir_seq[s];
+  // adding 0 is a load with a full barrier
+  uint32_t start = ink_atomic_increment(seq, 0);
+  if ((start & 1) || *lookaside)
+    return false;
+  Dir *seg = dir_segment(s, d);
+  Dir *e = dir_bucket(b, seg);
+  if (dir_offset(e)) {
+    // a torn read can link the bucket anywhere in the segment, bound the walk
+    for (int i = 0; i < DIR_DEPTH * d->buckets; i++) {
+      if (dir_compare_tag(e, key))
+        return false;
+      e = next_dir(e, seg);
+      if (!e)
+        break;
+    }
+    if (e)
+      return false;
+  }
+  return ink_atomic_increment(seq, 0) == start && !*lookaside;
+}
+
 int
 dir_insert(CacheKey *key, Vol *d, Dir *to_part)
 {
@@ -664,6 +728,7 @@ dir_insert(CacheKey *key, Vol *d, Dir *to_part)
   Dir *e = NULL;
   Dir *b = dir_bucket(bi, seg);
   Vol *vol = d;
+  DirSegmentWrite w(s, d);
 #if defined(DEBUG) && defined(DO_CHECK_DIR_FAST)
   unsigned int t = DIR_MASK_TAG(key->slice32(2));
   Dir *col = b;
@@ -731,6 +796,7 @@ dir_overwrite(CacheKey *key, Vol *d, Dir *dir, Dir *overwrite, bool must_overwri
   bool loop_possible = true;
 #endif
   Vol *vol = d;
+  DirSegmentWrite w(s, d);
   CHECK_DIR(d);
 
   ink_assert((unsigned int) dir_approx_size(dir) <= (unsigned int) (MAX_FRAG_SIZE + sizeofDoc));        // XXX - size should be unsigned
@@ -804,6 +870,7 @@ dir_delete(CacheKey *key, Vol *d, Dir *del)
   int loop_count = 0;
 #endif
   Vol *vol = d;
+  DirSegmentWrite w(s, d);
   CHECK_DIR(d);
 
   e = dir_bucket(b, seg);
@@ -1028,6 +1095,27 @@ sync_cache_dir_on_shutdown(void)
     d->hit_evacuate_window = (d->data_blocks * cache_config_hit_evacuate_percent) / 100;
 
 
+    // write again the agg buffers still in flight, the AIO threads may
+    // not get to them, oldest first
+    bool flushed = true;
+    while (d->agg_in_flight) {
+      AggBuffer *a = &d->agg_buffers[(d->agg_cur + d->agg_buffer_count - d->agg_in_flight) % d->agg_buffer_count];
+      ink_assert(d->header->write_pos == (off_t)a->io.aiocb.aio_offset);
+      int r = pwrite(d->fd, a->buf, a->io.aiocb.aio_nbytes, a->io.aiocb.aio_offset);
+      if (r != (int)a->io.aiocb.aio_nbytes) {
+        ink_assert(!"flusing agg buffer failed");
+        flushed = false;
+        break;
+      }
+      a->done = false;
+      d->agg_in_flight--;
+      d->header->last_write_pos = d->header->write_pos;
+      d->header->write_pos += a->io.aiocb.aio_nbytes;
+      d->header->write_serial++;
+    }
+    if (!flushed)
+      continue;
+
     // check if we have data in the agg buffer
     // dont worry about the cachevc s in the agg queue
     // directories have not been inserted for these writes
@@ -1046,6 +1134,7 @@ sync_cache_dir_on_shutdown(void)
       d->header->last_write_pos = d->header->write_pos;
       d->header->write_pos += d->agg_buf_pos;
       ink_assert(d->header->write_pos == d->header->agg_pos);
+      d->agg_write_pos = d->header->write_pos;
       d->agg_buf_pos = 0;
       d->header->write_serial++;
     }
@@ -1139,7 +1228,7 @@ Lrestart:
     return EVENT_CONT;
   }
   {
-    CACHE_TRY_LOCK(lock, gvol[vol]->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, gvol[vol], mutex->thread_holding);
     if (!lock) {
       trigger = eventProcessor.schedule_in(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
       return EVENT_CONT;
@@ -1167,7 +1256,7 @@ Lrestart:
         Debug("cache_dir_sync", "Dir %s not dirty", d->hash_text.get());
         goto Ldone;
       }
-      if (d->is_io_in_progress() || d->agg_buf_pos) {
+      if (d->is_io_in_progress() || d->agg_buf_pos || d->agg_in_flight) {
         Debug("cache_dir_sync", "Dir %s: waiting for agg buffer", d->hash_text.get());
         d->dir_sync_waiting = 1;
         if (!d->is_io_in_progress())
@@ -1441,7 +1530,7 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir) (RegressionTest *t, int /* atype ATS_UNUSED
   dir_set_head(&dir, true);
   dir_set_offset(&dir, 1);
 
-  d->header->agg_pos = d->header->write_pos += 1024;
+  d->header->agg_pos = d->agg_write_pos = d->header->write_pos += 1024;
 
   CacheKey key;
   rand_CacheKey(&key, thread->mutex);
@@ -1502,6 +1591,43 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir) (RegressionTest *t, int /* atype ATS_UNUSED
   if (us)
     rprintf(t, "probe rate = %d / second\n", (int) ((newfree * (uint64_t) 1000000) / us));
 
+  // test probe without the lock, it must never miss an entry
+  rprintf(t, "unlocked probe test\n");
+  regress_rand_init(13);
+  for (i = 0; i < newfree; i++) {
+    regress_rand_CacheKey(&key);
+    if (dir_probe_miss_unlocked(&key, d))
+      ret = REGRESSION_TEST_FAILED;
+  }
+  int sure_misses = 0;
+  for (i = 0; i < 100; i++) {
+    Dir *last_collision = 0, found;
+    rand_CacheKey(&key, thread->mutex);
+    if (!dir_probe(&key, d, &found, &last_collision) && dir_probe_miss_unlocked(&key, d))
+      sure_misses++;
+  }
+  rprintf(t, "sure misses: %d of 100\n", sure_misses);
+  if (sure_misses < 90)
+    ret = REGRESSION_TEST_FAILED;
+  {
+    // a segment being changed never gives a miss
+    int ks = key.slice32(0) % d->segments;
+    d->dir_seq[ks]++;
+    if (dir_probe_miss_unlocked(&key, d))
+      ret = REGRESSION_TEST_FAILED;
+    d->dir_seq[ks]++;
+  }
+  {
+    // nor does a key that may be in the lookaside
+    int kl = key.slice32(3) % LOOKASIDE_SIZE;
+    EvacuationBlock *b = new_EvacuationBlock(thread);
+    d->lookaside[kl].push(b);
+    if (dir_probe_miss_unlocked(&key, d))
+      ret = REGRESSION_TEST_FAILED;
+    d->lookaside[kl].remove(b);
+    free_EvacuationBlock(b, thread);
+  }
+
 
   for (int c = 0; c < vol_direntries(d) * 0.75; c++) {
     regress_rand_CacheKey(&key);
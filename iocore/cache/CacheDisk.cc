@@ -37,6 +37,7 @@ CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fil
   io.aiocb.aio_fildes = fd;
   io.aiocb.aio_reqprio = 0;
   io.action = this;
+  ink_aio_register_disk(fd, path);
   // determine header size and hence start point by successive approximation
   uint64_t l;
   for (int i = 0; i < 3; i++) {
@@ -212,7 +213,7 @@ CacheDisk::create_volume(int number, off_t size_in_blocks, int scheme)
   if (!q)
     return NULL;
 
-  off_t max_blocks = MAX_VOL_SIZE >> STORE_BLOCK_SHIFT;
+  off_t max_blocks = cache_max_stripe_blocks();
   size_in_blocks = (size_in_blocks <= max_blocks) ? size_in_blocks : max_blocks;
 
   int blocks_per_vol = VOL_BLOCK_SIZE / STORE_BLOCK_SIZE;
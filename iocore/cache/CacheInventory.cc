@@ -0,0 +1,478 @@
+/** @file
+
+  Cache inventory: a listing of the objects in the cache
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// Unlike Cache::scan(), which reads every byte of the stripes one after
+// the other, the inventory only reads the first fragment of each object,
+// whose header holds the alternates. The head entries of a directory
+// segment are taken under the stripe lock, then read in disk order
+// without it. All the stripes are done at the same time, each at its
+// share of the rate limit.
+//
+// The inventory is a text file, a line per object:
+//
+//   url <tab> size <tab> age <tab> alternates
+//
+// size is the body size summed over the alternates, age is the number of
+// seconds since the newest alternate was received. The file is written
+// under a temporary name and renamed when complete.
+
+#include "P_Cache.h"
+#include "I_Layout.h"
+
+#define INVENTORY_FILE            "cache_inventory.tsv"
+#define INVENTORY_READ_SIZE       (16 * 1024)   // holds the vector of most objects
+#define INVENTORY_OUT_SIZE        (64 * 1024)
+#define INVENTORY_MIN_DELAY       10            // msec, shortest pause for the rate limit
+
+int cache_config_inventory_rate = 16384;
+
+// Function in CacheDir.cc, as for make_vol_map().
+int dir_bucket_loop_fix(Dir *start_dir, int s, Vol *d);
+
+struct CacheInventoryVol;
+
+struct CacheInventory: public Continuation
+{
+  Action action;
+  ats_scoped_str path;
+  char tmp_path[PATH_NAME_MAX + 1];
+  int fd;
+  ink_mutex out_lock;
+  int KB_per_second;            // for each stripe
+  ink_hrtime start_time;
+  volatile int running;         // stripes not done
+  volatile int failed;
+  volatile int64_t objects;
+  volatile int64_t bytes;
+  int nvols;
+
+  bool write_out(const char *buf, int len);
+  void vol_done();
+  int finish(int event, Event *e);
+
+  CacheInventory(Continuation *cont)
+    : Continuation(cont->mutex), fd(-1), KB_per_second(0), start_time(0), running(0), failed(0),
+      objects(0), bytes(0), nvols(0)
+  {
+    action = cont;
+    tmp_path[0] = 0;
+    ink_mutex_init(&out_lock, "CacheInventory");
+    SET_HANDLER(&CacheInventory::finish);
+  }
+
+  ~CacheInventory()
+  {
+    ink_mutex_destroy(&out_lock);
+  }
+};
+
+// the inventory in progress, only one at a time, the lock keeps it from
+// being deleted while its progress is read
+static CacheInventory *cache_inventory = NULL;
+static ink_mutex cache_inventory_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+cache_inventory_clear()
+{
+  ink_mutex_acquire(&cache_inventory_lock);
+  cache_inventory = NULL;
+  ink_mutex_release(&cache_inventory_lock);
+}
+
+struct InventoryHead
+{
+  Dir dir;
+  int bucket;
+};
+
+static int
+cmp_head_offset(const void *a, const void *b)
+{
+  off_t oa = dir_offset(&((InventoryHead *)a)->dir);
+  off_t ob = dir_offset(&((InventoryHead *)b)->dir);
+  return oa < ob ? -1 : (oa > ob ? 1 : 0);
+}
+
+struct CacheInventoryVol: public Continuation
+{
+  CacheInventory *inv;
+  Vol *vol;
+  int segment;                  // next segment to take
+  InventoryHead *heads;
+  int nheads;
+  int max_heads;
+  int next;                     // next head to read
+  char *buf;
+  int buf_size;
+  AIOCallbackInternal io;
+  char *out;
+  int out_len;
+  int64_t pending;              // bytes read not yet paid for
+  int64_t objects;
+  int64_t bytes;
+#ifdef HTTP_CACHE
+  CacheHTTPInfoVector vector;
+#endif
+
+  int takeSegment(int event, Event *e);
+  int readHead(int event, Event *e);
+  int readHeadDone(int event, Event *e);
+  int done();
+  void add(Doc *doc);
+  bool flush();
+
+  CacheInventoryVol(CacheInventory *i, Vol *v)
+    : Continuation(new_ProxyMutex()), inv(i), vol(v), segment(0), heads(NULL), nheads(0), max_heads(0), next(0),
+      buf(NULL), buf_size(0), out(NULL), out_len(0), pending(0), objects(0), bytes(0)
+  {
+    out = (char *)ats_malloc(INVENTORY_OUT_SIZE);
+    SET_HANDLER(&CacheInventoryVol::takeSegment);
+  }
+
+  ~CacheInventoryVol()
+  {
+    ats_free(heads);
+    if (buf)
+      ats_memalign_free(buf);
+    ats_free(out);
+  }
+};
+
+int
+CacheInventoryVol::takeSegment(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  if (inv->action.cancelled || inv->failed)
+    return done();
+
+  VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
+  if (!lock) {
+    mutex->thread_holding->schedule_in_local(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
+    return EVENT_CONT;
+  }
+  // the head entries of the next segment with any, the documents still
+  // in the aggregation buffers are left for the next inventory
+  nheads = next = 0;
+  for (; segment < vol->segments && !nheads; segment++) {
+    Dir *seg = dir_segment(segment, vol);
+    for (int b = 0; b < vol->buckets; b++) {
+      Dir *e = dir_bucket(b, seg);
+      if (dir_bucket_loop_fix(e, segment, vol))
+        break;
+      for (; e; e = next_dir(e, seg)) {
+        if (dir_is_empty(e) || !dir_head(e) || !dir_agg_valid(vol, e) || dir_agg_buf_valid(vol, e))
+          continue;
+        if (nheads == max_heads) {
+          max_heads = max_heads ? max_heads * 2 : 1024;
+          heads = (InventoryHead *)ats_realloc(heads, max_heads * sizeof(InventoryHead));
+        }
+        dir_assign(&heads[nheads].dir, e);
+        heads[nheads].bucket = b;
+        nheads++;
+      }
+    }
+  }
+  if (!nheads)
+    return done();
+  // segment is already the one after these heads
+  qsort(heads, nheads, sizeof(InventoryHead), cmp_head_offset);
+  SET_HANDLER(&CacheInventoryVol::readHead);
+  return handleEvent(EVENT_IMMEDIATE, 0);
+}
+
+int
+CacheInventoryVol::readHead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  if (inv->action.cancelled || inv->failed)
+    return done();
+  if (next >= nheads) {
+    SET_HANDLER(&CacheInventoryVol::takeSegment);
+    return handleEvent(EVENT_IMMEDIATE, 0);
+  }
+  // pay for what was read so far
+  if (pending >= (int64_t)inv->KB_per_second * INVENTORY_MIN_DELAY) {
+    int delay = pending / inv->KB_per_second;
+    pending = 0;
+    mutex->thread_holding->schedule_in_local(this, HRTIME_MSECONDS(delay));
+    return EVENT_CONT;
+  }
+
+  Dir *dir = &heads[next].dir;
+  int len = dir_approx_size(dir);
+  if (len > INVENTORY_READ_SIZE)
+    len = INVENTORY_READ_SIZE;
+  io.aiocb.aio_offset = vol_offset(vol, dir);
+  io.aiocb.aio_nbytes = len;
+  return readHeadDone(EVENT_NONE, 0);
+}
+
+int
+CacheInventoryVol::readHeadDone(int event, Event * /* e ATS_UNUSED */)
+{
+  InventoryHead *h = &heads[next];
+  Doc *doc = (Doc *)buf;
+
+  if (event != AIO_EVENT_DONE) {
+    // issue the read set up in io.aiocb, the buffer grows as needed
+    if ((off_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len))
+      io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
+    if ((int)io.aiocb.aio_nbytes > buf_size) {
+      if (buf)
+        ats_memalign_free(buf);
+      buf_size = io.aiocb.aio_nbytes;
+      buf = (char *)ats_memalign(ats_pagesize(), buf_size);
+    }
+    io.aiocb.aio_fildes = vol->fd;
+    io.aiocb.aio_buf = buf;
+    io.action = this;
+    io.thread = AIO_CALLBACK_THREAD_ANY;
+    SET_HANDLER(&CacheInventoryVol::readHeadDone);
+    ink_assert(ink_aio_read(&io) >= 0);
+    return EVENT_CONT;
+  }
+
+  pending += io.aiocb.aio_nbytes;
+  if ((size_t)io.aio_result != (size_t)io.aiocb.aio_nbytes)
+    goto Lnext;
+  // the entry may have been overwritten since it was taken
+  if (doc->magic != DOC_MAGIC || doc->doc_type != CACHE_FRAG_TYPE_HTTP || !doc->hlen ||
+      !dir_compare_tag(&h->dir, &doc->first_key) || !(doc->first_key == doc->key) ||
+      (int)(doc->first_key.slice32(0) % vol->segments) != segment - 1 ||
+      (int)(doc->first_key.slice32(1) % vol->buckets) != h->bucket)
+    goto Lnext;
+  if (sizeofDoc + doc->hlen > io.aiocb.aio_nbytes) {
+    // a large vector, read all of the header
+    uint32_t l = ROUND_TO_CACHE_BLOCK(sizeofDoc + doc->hlen);
+    if (l > (uint32_t)dir_approx_size(&h->dir))
+      goto Lnext;
+    io.aiocb.aio_nbytes = l;
+    return readHeadDone(EVENT_NONE, 0);
+  }
+  add(doc);
+Lnext:
+  next++;
+  SET_HANDLER(&CacheInventoryVol::readHead);
+  return handleEvent(EVENT_IMMEDIATE, 0);
+}
+
+void
+CacheInventoryVol::add(Doc *doc)
+{
+#ifdef HTTP_CACHE
+  char *tmp = doc->hdr();
+  int len = doc->hlen;
+  while (len > 0) {
+    int r = HTTPInfo::unmarshal(tmp, len, NULL);
+    if (r < 0)
+      return;
+    len -= r;
+    tmp += r;
+  }
+  if (vector.get_handles(doc->hdr(), doc->hlen) != doc->hlen) {
+    vector.clear();
+    return;
+  }
+
+  int64_t size = 0;
+  time_t received = 0;
+  int url_len = 0;
+  char *url = NULL;
+  for (int i = 0; i < vector.count(); i++) {
+    CacheHTTPInfo *alt = vector.get(i);
+    if (!alt->valid())
+      continue;
+    if (!url)
+      url = alt->request_get()->url_get()->string_get(NULL, &url_len);
+    if (alt->object_size_get() > 0)
+      size += alt->object_size_get();
+    if (alt->response_received_time_get() > received)
+      received = alt->response_received_time_get();
+  }
+  if (url) {
+    char line[64];
+    int alts = vector.count();
+    int64_t age = received ? (int64_t)(ink_get_hrtime() / HRTIME_SECOND) - received : 0;
+    int l = snprintf(line, sizeof(line), "\t%" PRId64 "\t%" PRId64 "\t%d\n", size, age < 0 ? 0 : age, alts);
+    if (out_len + url_len + l > INVENTORY_OUT_SIZE)
+      flush();
+    if (url_len + l <= INVENTORY_OUT_SIZE) {
+      memcpy(out + out_len, url, url_len);
+      memcpy(out + out_len + url_len, line, l);
+      out_len += url_len + l;
+      objects++;
+      bytes += size;
+    }
+    ats_free(url);
+  }
+  vector.clear();
+#else
+  (void)doc;
+#endif
+}
+
+bool
+CacheInventoryVol::flush()
+{
+  bool ok = !out_len || inv->write_out(out, out_len);
+  out_len = 0;
+  return ok;
+}
+
+int
+CacheInventoryVol::done()
+{
+  if (!flush())
+    inv->failed = 1;
+  ink_atomic_increment(&inv->objects, objects);
+  ink_atomic_increment(&inv->bytes, bytes);
+  Debug("cache_inventory", "stripe %s: %" PRId64 " objects, %" PRId64 " bytes", vol->hash_text.get(), objects, bytes);
+  inv->vol_done();
+  mutex.clear();
+  delete this;
+  return EVENT_DONE;
+}
+
+bool
+CacheInventory::write_out(const char *buf, int len)
+{
+  bool ok = true;
+
+  ink_mutex_acquire(&out_lock);
+  while (len > 0) {
+    ssize_t n = write(fd, buf, len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      ok = false;
+      break;
+    }
+    buf += n;
+    len -= n;
+  }
+  ink_mutex_release(&out_lock);
+  return ok;
+}
+
+void
+CacheInventory::vol_done()
+{
+  if (ink_atomic_increment(&running, -1) == 1)
+    eventProcessor.schedule_imm(this, ET_CALL);
+}
+
+int
+CacheInventory::finish(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  char line[256];
+  int l = snprintf(line, sizeof(line), "# %" PRId64 " objects, %" PRId64 " bytes, %" PRId64 " seconds\n",
+                   objects, bytes, (int64_t)((ink_get_hrtime() - start_time) / HRTIME_SECOND));
+  if (!failed && !action.cancelled && !write_out(line, l))
+    failed = 1;
+  if (close(fd) < 0)
+    failed = 1;
+  fd = -1;
+  if (failed || action.cancelled || rename(tmp_path, path) < 0) {
+    if (!action.cancelled)
+      Warning("could not write the cache inventory %s: %s", (const char *)path, strerror(errno));
+    unlink(tmp_path);
+    failed = 1;
+  } else
+    Note("cache inventory %s: %" PRId64 " objects, %" PRId64 " bytes", (const char *)path, objects, bytes);
+
+  cache_inventory_clear();
+  if (!action.cancelled)
+    action.continuation->handleEvent(failed ? CACHE_EVENT_SCAN_FAILED : CACHE_EVENT_SCAN_DONE, NULL);
+  delete this;
+  return EVENT_DONE;
+}
+
+static char *
+cache_inventory_path()
+{
+  ats_scoped_str logdir(RecConfigReadLogDir());
+  return Layout::relative_to(logdir, INVENTORY_FILE);
+}
+
+Action *
+CacheProcessor::inventory(Continuation *cont, const char *path, int KB_per_second)
+{
+  static const char header[] = "# url\tsize\tage\talternates\n";
+
+  if (!CacheProcessor::IsCacheReady(CACHE_FRAG_TYPE_HTTP) || !gnvol) {
+    cont->handleEvent(CACHE_EVENT_SCAN_FAILED, 0);
+    return ACTION_RESULT_DONE;
+  }
+  CacheInventory *inv = new CacheInventory(cont);
+  inv->nvols = gnvol;
+  inv->running = inv->nvols;
+  ink_mutex_acquire(&cache_inventory_lock);
+  if (cache_inventory) {
+    ink_mutex_release(&cache_inventory_lock);
+    Debug("cache_inventory", "an inventory is already running");
+    delete inv;
+    cont->handleEvent(CACHE_EVENT_SCAN_FAILED, 0);
+    return ACTION_RESULT_DONE;
+  }
+  cache_inventory = inv;
+  ink_mutex_release(&cache_inventory_lock);
+  inv->path = path ? ats_strdup(path) : cache_inventory_path();
+  snprintf(inv->tmp_path, sizeof(inv->tmp_path), "%s.tmp", (const char *)inv->path);
+  if ((inv->fd = open(inv->tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0 ||
+      !inv->write_out(header, sizeof(header) - 1)) {
+    Warning("could not create the cache inventory %s: %s", inv->tmp_path, strerror(errno));
+    if (inv->fd >= 0) {
+      close(inv->fd);
+      unlink(inv->tmp_path);
+    }
+    cache_inventory_clear();
+    delete inv;
+    cont->handleEvent(CACHE_EVENT_SCAN_FAILED, 0);
+    return ACTION_RESULT_DONE;
+  }
+
+  if (KB_per_second <= 0)
+    KB_per_second = cache_config_inventory_rate;
+  inv->KB_per_second = KB_per_second / inv->nvols;
+  if (inv->KB_per_second < 1)
+    inv->KB_per_second = 1;
+  inv->start_time = ink_get_hrtime();
+  Note("cache inventory of %d stripes started, writing %s", inv->nvols, (const char *)inv->path);
+  for (int i = 0; i < inv->nvols; i++)
+    eventProcessor.schedule_imm(new CacheInventoryVol(inv, gvol[i]), ET_CALL);
+  return &inv->action;
+}
+
+bool
+cache_inventory_progress(int *vols_done, int *vols, int64_t *objects)
+{
+  CacheInventory *inv;
+
+  ink_mutex_acquire(&cache_inventory_lock);
+  if ((inv = cache_inventory)) {
+    // the counts are only updated as stripes finish
+    *vols = inv->nvols;
+    *vols_done = inv->nvols - inv->running;
+    *objects = inv->objects;
+  }
+  ink_mutex_release(&cache_inventory_lock);
+  return inv != NULL;
+}
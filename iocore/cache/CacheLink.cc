@@ -88,6 +88,8 @@ Cache::deref(Continuation * cont, CacheKey * key, CacheFragType type, char *host
   CacheVC *c = NULL;
   {
     MUTEX_TRY_LOCK(lock, vol->mutex, cont->mutex->thread_holding);
+    if (!lock)
+      VOL_LOCK_MISS(vol, cont->mutex->thread_holding);
     if (lock) {
       if (!dir_probe(key, vol, &result, &last_collision)) {
         cont->handleEvent(CACHE_EVENT_DEREF_FAILED, (void *) -ECACHE_NO_DOC);
@@ -146,7 +148,7 @@ CacheVC::derefRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   return free_CacheVC(this);
 
 Lcollision:{
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock) {
       mutex->thread_holding->schedule_in_local(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
       return EVENT_CONT;
@@ -54,6 +54,7 @@ struct ShowCache: public ShowCont {
   int lookup_regex_form(int event, Event *e);
   int delete_regex_form(int event, Event *e);
   int invalidate_regex_form(int event, Event *e);
+  int inventory(int event, Event *e);
 
   int lookup_url(int event, Event *e);
   int delete_url(int event, Event *e);
@@ -189,6 +190,8 @@ register_ShowCache(Continuation *c, HTTPHdr *h) {
     SET_CONTINUATION_HANDLER(theshowcache, &ShowCache::delete_regex);
   } else if (STREQ_PREFIX(path, "invalidate_regex")) {
     SET_CONTINUATION_HANDLER(theshowcache, &ShowCache::invalidate_regex);
+  } else if (STREQ_PREFIX(path, "inventory")) {
+    SET_CONTINUATION_HANDLER(theshowcache, &ShowCache::inventory);
   }
 
   if (theshowcache->mutex->thread_holding) {
@@ -207,7 +210,48 @@ ShowCache::showMain(int event, Event *e) {
                   "<H3><A HREF=\"./delete_url_form\">Delete url</A></H3>\n"
                   "<H3><A HREF=\"./lookup_regex_form\">Regex lookup</A></H3>\n"
                   "<H3><A HREF=\"./delete_regex_form\">Regex delete</A></H3>\n"
-                  "<H3><A HREF=\"./invalidate_regex_form\">Regex invalidate</A></H3>\n\n"));
+                  "<H3><A HREF=\"./invalidate_regex_form\">Regex invalidate</A></H3>\n"
+                  "<H3><A HREF=\"./inventory\">Inventory</A></H3>\n\n"));
+  return complete(event, e);
+}
+
+// Outlives the page that started the inventory, only notes the result.
+struct InventoryDone: public Continuation
+{
+  int handleEvent_done(int event, void * /* data ATS_UNUSED */)
+  {
+    Debug("cache_inspector", "inventory %s", event == CACHE_EVENT_SCAN_DONE ? "done" : "failed");
+    delete this;
+    return EVENT_DONE;
+  }
+
+  InventoryDone(): Continuation(new_ProxyMutex())
+  {
+    SET_HANDLER(&InventoryDone::handleEvent_done);
+  }
+};
+
+int
+ShowCache::inventory(int event, Event *e) {
+  int vols_done, vols;
+  int64_t objects;
+
+  CHECK_SHOW(begin("Cache Inventory"));
+  if (!cache_inventory_progress(&vols_done, &vols, &objects)) {
+    InventoryDone *c = new InventoryDone;
+    MUTEX_TRY_LOCK(lock, c->mutex, this_ethread());
+    if (cacheProcessor.inventory(c) == ACTION_RESULT_DONE) {
+      CHECK_SHOW(show("<P>Could not start the inventory, see diags.log</P>\n"));
+      return complete(event, e);
+    }
+  }
+  if (cache_inventory_progress(&vols_done, &vols, &objects)) {
+    CHECK_SHOW(show("<P>Inventory running: %d of %d stripes done, %" PRId64 " objects</P>\n"
+                    "<P>Reload for progress, the result goes to cache_inventory.tsv in the log directory</P>\n",
+                    vols_done, vols, objects));
+  } else {
+    CHECK_SHOW(show("<P>Inventory done, see cache_inventory.tsv in the log directory</P>\n"));
+  }
   return complete(event, e);
 }
 
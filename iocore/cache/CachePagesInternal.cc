@@ -248,7 +248,8 @@ ShowCacheInternal::showVolumes(int event, Event * e)
                   "<th>Write Agg Todo</th>"
                   "<th>Write Agg Todo Size</th>"
                   "<th>Write Agg Done</th>"
-                  "<th>Phase</th>" "<th>Create Time</th>" "<th>Sync Serial</th>" "<th>Write Serial</th>" "</tr>\n"));
+                  "<th>Phase</th>" "<th>Create Time</th>" "<th>Sync Serial</th>" "<th>Write Serial</th>"
+                  "<th>Lock Misses</th>" "</tr>\n"));
 
   SET_HANDLER(&ShowCacheInternal::showVolVolumes);
   CONT_SCHED_LOCK_RETRY_RET(this);
@@ -282,6 +283,7 @@ ShowCacheInternal::showVolVolumes(int event, Event * e)
                   "<td>%s</td>" // create time
                   "<td>%u</td>" // sync serial
                   "<td>%u</td>" // write serial
+                  "<td>%" PRId64 "</td>" // lock misses
                   "</tr>\n",
                   p->hash_text.get(),
                   (uint64_t)((p->len - (p->start - p->skip)) / CACHE_BLOCK_SIZE),
@@ -289,7 +291,8 @@ ShowCacheInternal::showVolVolumes(int event, Event * e)
                   (uint64_t)((p->header->write_pos - p->start) / CACHE_BLOCK_SIZE),
                   agg_todo,
                   p->agg_todo_size,
-                  agg_done, p->header->phase, ctime, p->header->sync_serial, p->header->write_serial));
+                  agg_done, p->header->phase, ctime, p->header->sync_serial, p->header->write_serial,
+                  (int64_t)p->lock_misses));
   CHECK_SHOW(show("</table>\n"));
   SET_HANDLER(&ShowCacheInternal::showSegments);
   return showSegments(event, e);
@@ -45,7 +45,11 @@ Cache::open_read(Continuation * cont, CacheKey * key, CacheFragType type, char *
   OpenDirEntry *od = NULL;
   CacheVC *c = NULL;
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
+    if (!lock && vol->probe_miss_unlocked(key)) {
+      CACHE_INCREMENT_DYN_STAT(cache_vol_lock_miss_probed_stat);
+      goto Lmiss;
+    }
     if (!lock || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c = new_CacheVC(cont);
       SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
@@ -107,7 +111,11 @@ Cache::open_read(Continuation * cont, CacheKey * key, CacheHTTPHdr * request,
   CacheVC *c = NULL;
 
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
+    if (!lock && vol->probe_miss_unlocked(key)) {
+      CACHE_INCREMENT_DYN_STAT(cache_vol_lock_miss_probed_stat);
+      goto Lmiss;
+    }
     if (!lock || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c = new_CacheVC(cont);
       c->first_key = c->key = c->earliest_key = *key;
@@ -311,7 +319,7 @@ CacheVC::openReadFromWriter(int event, Event * e)
     od = NULL; // only open for read so no need to close
     return free_CacheVC(this);
   }
-  CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+  VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
   if (!lock)
     VC_SCHED_LOCK_RETRY();
   od = vol->open_read(&first_key); // recheck in case the lock failed
@@ -521,7 +529,7 @@ CacheVC::openReadClose(int event, Event * /* e ATS_UNUSED */)
       return EVENT_CONT;
     set_io_not_in_progress();
   }
-  CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+  VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
   if (!lock)
     VC_SCHED_LOCK_RETRY();
   if (f.hit_evacuate && dir_valid(vol, &first_dir) && closed > 0) {
@@ -546,7 +554,7 @@ CacheVC::openReadReadDone(int event, Event * e)
     return EVENT_CONT;
   set_io_not_in_progress();
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock)
       VC_SCHED_LOCK_RETRY();
     if (event == AIO_EVENT_DONE && !io.ok()) {
@@ -751,7 +759,7 @@ Lread: {
     // EVENT_IMMEDIATE events. So, we have to cancel that trigger and set
     // a new EVENT_INTERVAL event.
     cancel_trigger();
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock) {
       SET_HANDLER(&CacheVC::openReadMain);
       VC_SCHED_LOCK_RETRY();
@@ -809,7 +817,7 @@ CacheVC::openReadStartEarliest(int /* event ATS_UNUSED */, Event * /* e ATS_UNUS
   if (_action.cancelled)
     return free_CacheVC(this);
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock)
       VC_SCHED_LOCK_RETRY();
     if (!buf)
@@ -967,7 +975,7 @@ CacheVC::openReadVecWrite(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */
   if (_action.cancelled)
     return openWriteCloseDir(EVENT_IMMEDIATE, 0);
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock)
       VC_SCHED_LOCK_RETRY();
     if (io.ok()) {
@@ -1019,9 +1027,15 @@ CacheVC::openReadStartHead(int event, Event * e)
   if (_action.cancelled)
     return free_CacheVC(this);
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
-    if (!lock)
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
+    if (!lock) {
+      // a fresh lookup or read can fail right away on a sure miss
+      if (!buf && !od && !last_collision && vol->probe_miss_unlocked(&key)) {
+        CACHE_INCREMENT_DYN_STAT(cache_vol_lock_miss_probed_stat);
+        goto Ldone;
+      }
       VC_SCHED_LOCK_RETRY();
+    }
     if (!buf)
       goto Lread;
     if (!io.ok())
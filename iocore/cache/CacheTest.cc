@@ -25,6 +25,7 @@
 #include "P_Cache.h"
 #include "P_CacheTest.h"
 #include "api/ts/ts.h"
+#include "ts/TestBox.h"
 
 CacheTestSM::CacheTestSM(RegressionTest *t) :
   RegressionSM(t),
@@ -487,3 +488,254 @@ REGRESSION_TEST(cache_disk_replacement_stability)(RegressionTest *t, int level,
   hr1.vols = 0;
   hr2.vols = 0;
 }
+
+// Fail one of the disks and check that with rendezvous assignment only the
+// keys of that disk move, spread over the others.
+//
+// run -r cache_vol_assignment_disk_failure
+
+REGRESSION_TEST(cache_vol_assignment_disk_failure)(RegressionTest *t, int /* level ATS_UNUSED */, int *pstatus) {
+  static int const NUM_VOLS = 12;
+  static int const failed_idx = 5;
+  CacheDisk disk, bad_disk;
+  CacheHostRecord hr1, hr2;
+  Vol vols[NUM_VOLS];
+  Vol* vol_ptrs[NUM_VOLS];
+  int saved_assignment = cache_config_vol_assignment;
+  char buff[2048];
+  TestBox box(t, pstatus);
+
+  box = REGRESSION_TEST_PASSED;
+  disk.num_errors = 0;
+  bad_disk.num_errors = 0;
+
+  for (int i = 0 ; i < NUM_VOLS ; ++i) {
+    vol_ptrs[i] = vols + i;
+    vols[i].disk = i == failed_idx ? &bad_disk : &disk;
+    vols[i].len = 1024ULL * 1024 * 1024 * (i % 2 ? 500 : 1000);
+    snprintf(buff, sizeof(buff), "/dev/sd%c 8192:%" PRIu64, 'a' + i, vols[i].len);
+    MD5Context().hash_immediate(vols[i].hash_id, buff, strlen(buff));
+  }
+
+  for (int algorithm = VOL_ASSIGN_RING; algorithm <= VOL_ASSIGN_RENDEZVOUS; algorithm++) {
+    int counts[NUM_VOLS], gained[NUM_VOLS];
+    int moved = 0, on_failed = 0, stray = 0;
+
+    cache_config_vol_assignment = algorithm;
+    bad_disk.num_errors = 0;
+    hr1.vol_hash_table = 0;
+    hr1.vols = vol_ptrs;
+    hr1.num_vols = NUM_VOLS;
+    build_vol_hash_table(&hr1);
+
+    bad_disk.num_errors = cache_config_max_disk_errors;
+    hr2.vol_hash_table = 0;
+    hr2.vols = vol_ptrs;
+    hr2.num_vols = NUM_VOLS;
+    build_vol_hash_table(&hr2);
+
+    memset(counts, 0, sizeof(counts));
+    memset(gained, 0, sizeof(gained));
+    for (int i = 0 ; i < VOL_HASH_TABLE_SIZE ; ++i) {
+      counts[hr1.vol_hash_table[i]]++;
+      if (hr1.vol_hash_table[i] == failed_idx)
+        ++on_failed;
+      if (hr1.vol_hash_table[i] != hr2.vol_hash_table[i]) {
+        ++moved;
+        ++gained[hr2.vol_hash_table[i]];
+        if (hr1.vol_hash_table[i] != failed_idx)
+          ++stray;
+      }
+    }
+    rprintf(t, "%s: %d of %d slots moved, %d were on the failed disk\n",
+            algorithm == VOL_ASSIGN_RING ? "ring" : "rendezvous", moved, VOL_HASH_TABLE_SIZE, on_failed);
+
+    if (algorithm == VOL_ASSIGN_RENDEZVOUS) {
+      box.check(stray == 0, "%d slots moved off working disks", stray);
+      for (int i = 0 ; i < NUM_VOLS ; ++i) {
+        // a big disk should get twice the share of a small one, +-10%
+        double expected = (double)VOL_HASH_TABLE_SIZE * (i % 2 ? 1 : 2) / (NUM_VOLS / 2 * 3);
+        box.check(counts[i] > expected * 0.9 && counts[i] < expected * 1.1,
+                  "disk %d has %d slots, expected %.0f", i, counts[i], expected);
+        if (i != failed_idx)
+          box.check(gained[i] > 0 && gained[i] < on_failed / 3,
+                    "disk %d took %d of the %d slots of the failed disk", i, gained[i], on_failed);
+      }
+    }
+
+    ats_free(hr1.vol_hash_table);
+    ats_free(hr2.vol_hash_table);
+    hr1.vol_hash_table = hr2.vol_hash_table = NULL;
+  }
+
+  cache_config_vol_assignment = saved_assignment;
+  hr1.vols = 0;
+  hr2.vols = 0;
+}
+
+// Replay a request trace against each of the RAM cache implementations,
+// a get() for every request and a put() for every miss, and report the hit
+// ratio, byte hit ratio and time per operation. The trace is read from the
+// file named by $TS_RAM_CACHE_TRACE, one "key size" request per line, or
+// if that isn't set a Zipf distributed trace with a scan of one time
+// objects in the middle is generated.
+//
+// run -R 3 -r ram_cache_replay
+
+struct RamCacheTraceRequest {
+  INK_MD5 key;
+  uint32_t size;
+};
+
+static int
+ram_cache_read_trace(const char *path, RamCacheTraceRequest **ret)
+{
+  RamCacheTraceRequest *trace = NULL;
+  int n = 0, max = 0;
+  char key[1024];
+  unsigned int size;
+  FILE *fp = fopen(path, "r");
+
+  if (!fp)
+    return -1;
+  while (fscanf(fp, "%1023s %u", key, &size) == 2) {
+    if (n == max) {
+      max = max ? max * 2 : 1024;
+      trace = (RamCacheTraceRequest *)ats_realloc(trace, max * sizeof(RamCacheTraceRequest));
+    }
+    MD5Context().hash_immediate(trace[n].key, key, strlen(key));
+    trace[n++].size = size;
+  }
+  fclose(fp);
+  *ret = trace;
+  return n;
+}
+
+static int
+ram_cache_make_trace(RamCacheTraceRequest **ret)
+{
+  static const int objects = 100000;
+  static const int requests = 1000000;
+  static const int scan = 200000;
+  double *cdf = (double *)ats_malloc(objects * sizeof(double));
+  RamCacheTraceRequest *trace = (RamCacheTraceRequest *)ats_malloc((requests + scan) * sizeof(RamCacheTraceRequest));
+  InkRand rng(13);
+  double sum = 0;
+  int i;
+
+  for (i = 0; i < objects; i++)
+    cdf[i] = (sum += 1.0 / pow(i + 1, 0.9));
+  for (i = 0; i < objects; i++)
+    cdf[i] /= sum;
+
+  for (i = 0; i < requests + scan; i++) {
+    if (i >= requests / 2 && i < requests / 2 + scan) {
+      int64_t k = -(int64_t)i;
+
+      MD5Context().hash_immediate(trace[i].key, &k, sizeof(k));
+    } else {
+      double u = rng.drandom();
+      int lo = 0, hi = objects - 1;
+      int64_t k;
+
+      while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cdf[mid] < u)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      k = lo;
+      MD5Context().hash_immediate(trace[i].key, &k, sizeof(k));
+    }
+    // 512 bytes to 32K, fixed per object
+    trace[i].size = 512 + (trace[i].key.slice32(1) % (32 * 1024));
+  }
+  ats_free(cdf);
+  *ret = trace;
+  return requests + scan;
+}
+
+static void
+ram_cache_replay(RegressionTest *t, const char *name, RamCache *cache, int64_t cache_size,
+                 RamCacheTraceRequest *trace, int n, char *buf)
+{
+  Vol *vol = gvol[0];
+  int64_t hits = 0, bytes = 0, hit_bytes = 0, ops = 0;
+  ink_hrtime elapsed = 0, start;
+
+  // The compressor of the CLFUS cache takes the Vol lock, and is waited for
+  // when the cache is deleted.
+  MUTEX_TAKE_LOCK(vol->mutex, this_ethread());
+  cache->init(cache_size, vol);
+  for (int i = 0; i < n; i++) {
+    Ptr<IOBufferData> data;
+
+    bytes += trace[i].size;
+    start = ink_get_hrtime_internal();
+    int hit = cache->get(&trace[i].key, &data);
+    elapsed += ink_get_hrtime_internal() - start;
+    ops++;
+    if (hit) {
+      hits++;
+      hit_bytes += trace[i].size;
+    } else {
+      data = new_constant_IOBufferData(buf, trace[i].size);
+      start = ink_get_hrtime_internal();
+      cache->put(&trace[i].key, data, trace[i].size);
+      elapsed += ink_get_hrtime_internal() - start;
+      ops++;
+    }
+  }
+  MUTEX_UNTAKE_LOCK(vol->mutex, this_ethread());
+  rprintf(t, "%-6s %5" PRId64 "MB: hit ratio %.3f, byte hit ratio %.3f, %.0f ns/op\n", name, cache_size >> 20,
+          (double)hits / n, (double)hit_bytes / bytes, (double)elapsed / ops);
+  delete cache;
+}
+
+REGRESSION_TEST(ram_cache_replay)(RegressionTest *t, int level, int *pstatus) {
+  RamCacheTraceRequest *trace = NULL;
+  const char *path = getenv("TS_RAM_CACHE_TRACE");
+  uint32_t max_size = 0;
+  int n;
+
+  // Only run at the highest levels.
+  if (REGRESSION_TEST_EXTENDED > level) {
+    *pstatus = REGRESSION_TEST_PASSED;
+    return;
+  }
+
+  if (cacheProcessor.IsCacheEnabled() != CACHE_INITIALIZED || gnvol < 1) {
+    rprintf(t, "cache not initialized");
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+
+  if (path)
+    n = ram_cache_read_trace(path, &trace);
+  else
+    n = ram_cache_make_trace(&trace);
+  if (n <= 0) {
+    rprintf(t, "could not read trace %s", path);
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+  for (int i = 0; i < n; i++)
+    if (trace[i].size > max_size)
+      max_size = trace[i].size;
+  rprintf(t, "replaying %d requests from %s\n", n, path ? path : "a generated trace");
+
+  // The caches hold on to the same, never written, buffer.
+  // The hits and misses are counted in the RAM cache stats of the process.
+  char *buf = (char *)ats_malloc(max_size ? max_size : 1);
+  for (int s = 24; s <= 28; s += 2) {
+    int64_t cache_size = 1LL << s;
+
+    ram_cache_replay(t, "LRU", new_RamCacheLRU(), cache_size, trace, n, buf);
+    ram_cache_replay(t, "CLFUS", new_RamCacheCLFUS(), cache_size, trace, n, buf);
+    ram_cache_replay(t, "S3FIFO", new_RamCacheS3FIFO(), cache_size, trace, n, buf);
+  }
+  ats_free(buf);
+  ats_free(trace);
+  *pstatus = REGRESSION_TEST_PASSED;
+}
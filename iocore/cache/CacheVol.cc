@@ -167,7 +167,7 @@ CacheVC::scanObject(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   if (_action.cancelled)
     return free_CacheVC(this);
 
-  CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+  VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
   if (!lock) {
     Debug("cache_scan_truss", "delay %p:scanObject", this);
     mutex->thread_holding->schedule_in_local(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
@@ -403,7 +403,7 @@ CacheVC::scanOpenWrite(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   }
   int ret = 0;
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock) {
       Debug("cache_scan", "vol->mutex %p:scanOpenWrite", this);
       VC_SCHED_LOCK_RETRY();
@@ -476,7 +476,7 @@ CacheVC::scanUpdateDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   Debug("cache_scan_truss", "inside %p:scanUpdateDone", this);
   cancel_trigger();
   // get volume lock
-  CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+  VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
   if (lock) {
     // insert a directory entry for the previous fragment
     dir_overwrite(&first_key, vol, &dir, &od->first_dir, false);
@@ -0,0 +1,152 @@
+/** @file
+
+  Assignment of cache keys to volumes
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// This file only depends on libts, so that tools can compute the same
+// tables as the cache (see vol_movement.cc).
+
+#include "P_CacheVolHash.h"
+#include <math.h>
+
+// the generator of next_rand() in P_CacheInternal.h
+static inline unsigned int
+vol_hash_rand(unsigned int *p)
+{
+  unsigned int seed = *p;
+  seed = 1103515145 * seed + 12345;
+  *p = seed;
+  return seed;
+}
+
+// explicit pair for random table in vol_hash_table_fill_ring
+struct rtable_pair {
+  unsigned int rval; ///< relative value, used to sort.
+  unsigned int idx; ///< volume mapping table index.
+};
+
+// comparison operator for random table in vol_hash_table_fill_ring
+// sorts based on the randomly assigned rval
+static int
+cmprtable(const void *aa, const void *bb) {
+  rtable_pair *a = (rtable_pair*)aa;
+  rtable_pair *b = (rtable_pair*)bb;
+  if (a->rval < b->rval) return -1;
+  if (a->rval > b->rval) return 1;
+  return 0;
+}
+
+static void
+vol_hash_table_fill_ring(unsigned short *ttable, int num_vols, const CryptoHash *ids, const int64_t *lens)
+{
+  unsigned int *rnd = (unsigned int *) ats_malloc(sizeof(unsigned int) * num_vols);
+  unsigned int *rtable_entries = (unsigned int *) ats_malloc(sizeof(unsigned int) * num_vols);
+  unsigned int rtable_size = 0;
+
+  for (int i = 0; i < num_vols; i++) {
+    rtable_entries[i] = lens[i] / VOL_HASH_ALLOC_SIZE;
+    rtable_size += rtable_entries[i];
+  }
+  // seed random number generator
+  for (int i = 0; i < num_vols; i++) {
+    uint64_t x = ids[i].fold();
+    rnd[i] = (unsigned int) x;
+  }
+  // generate random numbers proportaion to allocation
+  rtable_pair *rtable = (rtable_pair *)ats_malloc(sizeof(rtable_pair) * rtable_size);
+  int rindex = 0;
+  for (int i = 0; i < num_vols; i++)
+    for (int j = 0; j < (int)rtable_entries[i]; j++) {
+      rtable[rindex].rval = vol_hash_rand(&rnd[i]);
+      rtable[rindex].idx = i;
+      rindex++;
+    }
+  ink_assert(rindex == (int)rtable_size);
+  // sort (rand #, vol $ pairs)
+  qsort(rtable, rtable_size, sizeof(rtable_pair), cmprtable);
+  unsigned int width = (1LL << 32) / VOL_HASH_TABLE_SIZE;
+  unsigned int pos;  // target position to allocate
+  // select vol with closest random number for each bucket
+  int i = 0;  // index moving through the random numbers
+  for (int j = 0; j < VOL_HASH_TABLE_SIZE; j++) {
+    pos = width / 2 + j * width;  // position to select closest to
+    while (pos > rtable[i].rval && i < (int)rtable_size - 1) i++;
+    ttable[j] = rtable[i].idx;
+  }
+  ats_free(rnd);
+  ats_free(rtable_entries);
+  ats_free(rtable);
+}
+
+// 64 bit finalizer of MurmurHash3
+static inline uint64_t
+vol_hash_mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+//
+// Weighted rendezvous hashing: each slot goes to the volume with the
+// highest -len / ln(u), u a uniform (0,1) hash of the slot and the
+// volume. The score of a (slot, volume) pair never changes, so a slot
+// only moves when its volume goes away or a new volume beats it.
+//
+static void
+vol_hash_table_fill_rendezvous(unsigned short *ttable, int num_vols, const CryptoHash *ids, const int64_t *lens)
+{
+  uint64_t *seeds = (uint64_t *)ats_malloc(sizeof(uint64_t) * num_vols);
+  double *weights = (double *)ats_malloc(sizeof(double) * num_vols);
+
+  for (int i = 0; i < num_vols; i++) {
+    seeds[i] = ids[i].fold();
+    weights[i] = (double)lens[i];
+  }
+  for (int j = 0; j < VOL_HASH_TABLE_SIZE; j++) {
+    uint64_t slot = vol_hash_mix((uint64_t)j + 1);
+    double best = -1;
+    for (int i = 0; i < num_vols; i++) {
+      uint64_t h = vol_hash_mix(seeds[i] ^ slot);
+      double u = ((double)(h >> 11) + 0.5) / (double)(1ULL << 53);
+      double score = weights[i] / -log(u);
+      if (score > best) {
+        best = score;
+        ttable[j] = i;
+      }
+    }
+  }
+  ats_free(seeds);
+  ats_free(weights);
+}
+
+void
+vol_hash_table_fill(unsigned short *table, int n, const CryptoHash *ids, const int64_t *lens, int algorithm)
+{
+  ink_assert(n > 0 && n < VOL_HASH_EMPTY);
+  if (algorithm == VOL_ASSIGN_RENDEZVOUS)
+    vol_hash_table_fill_rendezvous(table, n, ids, lens);
+  else
+    vol_hash_table_fill_ring(table, n, ids, lens);
+}
@@ -63,7 +63,7 @@ CacheVC::updateVector(int /* event ATS_UNUSED */, Event */* e ATS_UNUSED */)
     VC_SCHED_LOCK_RETRY();
   int ret = 0;
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock || od->writing_vec)
       VC_SCHED_LOCK_RETRY();
 
@@ -270,10 +270,10 @@ void
 Vol::scan_for_pinned_documents()
 {
   if (cache_config_permit_pinning) {
-    // we can't evacuate anything between header->write_pos and
-    // header->write_pos + AGG_SIZE.
-    int ps = offset_to_vol_offset(this, header->write_pos + AGG_SIZE);
-    int pe = offset_to_vol_offset(this, header->write_pos + 2 * EVACUATION_SIZE + (len / PIN_SCAN_EVERY));
+    // we can't evacuate anything between agg_write_pos and
+    // agg_write_pos + AGG_SIZE.
+    int ps = offset_to_vol_offset(this, agg_write_pos + AGG_SIZE);
+    int pe = offset_to_vol_offset(this, agg_write_pos + 2 * EVACUATION_SIZE + (len / PIN_SCAN_EVERY));
     int vol_end_offset = offset_to_vol_offset(this, len + skip);
     int before_end_of_vol = pe < vol_end_offset;
     DDebug("cache_evac", "scan %d %d", ps, pe);
@@ -297,13 +297,23 @@ Vol::scan_for_pinned_documents()
   }
 }
 
+int
+AggBuffer::handle_write_done(int event, void * /* data ATS_UNUSED */)
+{
+  // Only the AIO completes the write. A lock retry can arrive after the
+  // buffer was retired and issued again, and must not mark that write done.
+  if (event == AIO_EVENT_DONE)
+    done = true;
+  return vol->aggWriteDone(event, this);
+}
+
 /* NOTE:: This state can be called by an AIO thread, so DON'T DON'T
    DON'T schedule any events on this thread using VC_SCHED_XXX or
    mutex->thread_holding->schedule_xxx_local(). ALWAYS use
    eventProcessor.schedule_xxx().
    */
 int
-Vol::aggWriteDone(int event, Event *e)
+Vol::aggWriteDone(int event, AggBuffer *b)
 {
   cancel_trigger();
 
@@ -311,40 +321,48 @@ Vol::aggWriteDone(int event, Event *e)
   // retaking the current mutex recursively is a NOOP
   CACHE_TRY_LOCK(lock, dir_sync_waiting ? cacheDirSync->mutex : mutex, mutex->thread_holding);
   if (!lock) {
-    eventProcessor.schedule_in(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
+    eventProcessor.schedule_in(b, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
     return EVENT_CONT;
   }
-  if (io.ok()) {
+  // the writes may complete out of order, retire them in the order
+  // they were issued so that write_pos only covers data on disk
+  while (agg_in_flight) {
+    AggBuffer *a = &agg_buffers[(agg_cur + agg_buffer_count - agg_in_flight) % agg_buffer_count];
+    if (!a->done)
+      break;
+    a->done = false;
+    agg_in_flight--;
+    ink_assert(header->write_pos == (off_t)a->io.aiocb.aio_offset);
+    if (!a->io.ok()) {
+      // delete all the directory entries that we inserted
+      // for fragments is this aggregation buffer
+      Debug("cache_disk_error", "Write error on disk %s\n \
+              write range : [%" PRIu64 " - %" PRIu64 " bytes]  [%" PRIu64 " - %" PRIu64 " blocks] \n",
+            hash_text.get(), (uint64_t)a->io.aiocb.aio_offset,
+            (uint64_t)a->io.aiocb.aio_offset + a->io.aiocb.aio_nbytes,
+            (uint64_t)a->io.aiocb.aio_offset / CACHE_BLOCK_SIZE,
+            (uint64_t)(a->io.aiocb.aio_offset + a->io.aiocb.aio_nbytes) / CACHE_BLOCK_SIZE);
+      Dir del_dir;
+      dir_clear(&del_dir);
+      for (int done = 0; done < (int)a->io.aiocb.aio_nbytes;) {
+        Doc *doc = (Doc *) (a->buf + done);
+        dir_set_offset(&del_dir, header->write_pos + done);
+        dir_delete(&doc->key, this, &del_dir);
+        done += round_to_approx_size(doc->len);
+      }
+    }
+    // the later buffers are already placed after this one, so step
+    // over it even if the write failed
     header->last_write_pos = header->write_pos;
-    header->write_pos += io.aiocb.aio_nbytes;
+    header->write_pos += a->io.aiocb.aio_nbytes;
     ink_assert(header->write_pos >= start);
     DDebug("cache_agg", "Dir %s, Write: %" PRIu64 ", last Write: %" PRIu64 "\n",
           hash_text.get(), header->write_pos, header->last_write_pos);
-    ink_assert(header->write_pos == header->agg_pos);
     if (header->write_pos + EVACUATION_SIZE > scan_pos)
       periodic_scan();
-    agg_buf_pos = 0;
     header->write_serial++;
-  } else {
-    // delete all the directory entries that we inserted
-    // for fragments is this aggregation buffer
-    Debug("cache_disk_error", "Write error on disk %s\n \
-              write range : [%" PRIu64 " - %" PRIu64 " bytes]  [%" PRIu64 " - %" PRIu64 " blocks] \n",
-          hash_text.get(), (uint64_t)io.aiocb.aio_offset,
-          (uint64_t)io.aiocb.aio_offset + io.aiocb.aio_nbytes,
-          (uint64_t)io.aiocb.aio_offset / CACHE_BLOCK_SIZE,
-          (uint64_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) / CACHE_BLOCK_SIZE);
-    Dir del_dir;
-    dir_clear(&del_dir);
-    for (int done = 0; done < agg_buf_pos;) {
-      Doc *doc = (Doc *) (agg_buffer + done);
-      dir_set_offset(&del_dir, header->write_pos + done);
-      dir_delete(&doc->key, this, &del_dir);
-      done += round_to_approx_size(doc->len);
-    }
-    agg_buf_pos = 0;
   }
-  set_io_not_in_progress();
+  ink_assert(agg_in_flight || header->write_pos == agg_write_pos);
   // callback ready sync CacheVCs
   CacheVC *c = 0;
   while ((c = sync.dequeue())) {
@@ -355,12 +373,13 @@ Vol::aggWriteDone(int event, Event *e)
       break;
     }
   }
-  if (dir_sync_waiting) {
+  if (dir_sync_waiting && !agg_in_flight) {
     dir_sync_waiting = 0;
     cacheDirSync->handleEvent(EVENT_IMMEDIATE, 0);
   }
-  if (agg.head || sync.head)
-    return aggWrite(event, e);
+  // an evacuation read calls aggWrite() when it is done
+  if ((agg.head || sync.head) && !is_io_in_progress())
+    return aggWrite(event, 0);
   return EVENT_CONT;
 }
 
@@ -729,7 +748,9 @@ static int
 agg_copy(char *p, CacheVC *vc)
 {
   Vol *vol = vc->vol;
-  off_t o = vol->header->write_pos + vol->agg_buf_pos;
+  off_t o = vol->agg_write_pos + vol->agg_buf_pos;
+  // the buffers in flight each bump write_serial when they are done
+  uint32_t write_serial = vol->header->write_serial + vol->agg_in_flight;
 
   if (!vc->f.evacuator) {
     Doc *doc = (Doc *) p;
@@ -758,7 +779,7 @@ agg_copy(char *p, CacheVC *vc)
     doc->total_len = vc->total_len;
     doc->first_key = vc->first_key;
     doc->sync_serial = vol->header->sync_serial;
-    vc->write_serial = doc->write_serial = vol->header->write_serial;
+    vc->write_serial = doc->write_serial = write_serial;
     doc->checksum = DOC_NO_CHECKSUM;
     if (vc->pin_in_cache) {
       dir_set_pinned(&vc->dir, 1);
@@ -821,9 +842,9 @@ agg_copy(char *p, CacheVC *vc)
     // move data
     if (vc->write_len) {
       {
-        ProxyMutex *mutex ATS_UNUSED = vc->vol->mutex;
+        ProxyMutex *mutex = vc->vol->mutex;
         ink_assert(mutex->thread_holding == this_ethread());
-        CACHE_DEBUG_SUM_DYN_STAT(cache_write_bytes_stat, vc->write_len);
+        CACHE_SUM_DYN_STAT(cache_write_bytes_stat, vc->write_len);
       }
 #ifdef HTTP_CACHE
       if (vc->f.rewrite_resident_alt)
@@ -868,7 +889,7 @@ agg_copy(char *p, CacheVC *vc)
     }
 
     doc->sync_serial = vc->vol->header->sync_serial;
-    doc->write_serial = vc->vol->header->write_serial;
+    doc->write_serial = write_serial;
 
     memcpy(p, doc, doc->len);
 
@@ -942,7 +963,8 @@ Vol::periodic_scan()
 void
 Vol::agg_wrap()
 {
-  header->write_pos = start;
+  ink_assert(!agg_in_flight);
+  agg_write_pos = header->write_pos = start;
   header->phase = !header->phase;
 
   header->cycle++;
@@ -970,16 +992,21 @@ Vol::aggWrite(int event, void */* e ATS_UNUSED */)
   cancel_trigger();
 
 Lagain:
+  // all the buffers are in flight, or a directory sync waits for them
+  // to drain; aggWriteDone() calls back
+  if (agg_in_flight == agg_buffer_count || (dir_sync_waiting && agg_in_flight))
+    goto Lwait;
+
   // calculate length of aggregated write
   for (c = (CacheVC *) agg.head; c;) {
     int writelen = c->agg_len;
     // [amc] this is checked multiple places, on here was it strictly less.
     ink_assert(writelen <= AGG_SIZE);
     if (agg_buf_pos + writelen > AGG_SIZE ||
-        header->write_pos + agg_buf_pos + writelen > (skip + len))
+        agg_write_pos + agg_buf_pos + writelen > (skip + len))
       break;
     DDebug("agg_read", "copying: %d, %" PRIu64 ", key: %d",
-          agg_buf_pos, header->write_pos + agg_buf_pos, c->first_key.slice32(0));
+          agg_buf_pos, agg_write_pos + agg_buf_pos, c->first_key.slice32(0));
     int wrotelen = agg_copy(agg_buffer + agg_buf_pos, c);
     ink_assert(writelen == wrotelen);
     agg_todo_size -= writelen;
@@ -1001,8 +1028,8 @@ Lagain:
   // if we got nothing...
   if (!agg_buf_pos) {
     if (!agg.head && !sync.head) // nothing to get
-      return EVENT_CONT;
-    if (header->write_pos == start) {
+      goto Lwait;
+    if (agg_write_pos == start) {
       // write aggregation too long, bad bad, punt on everything.
       Note("write aggregation exceeds vol size");
       ink_assert(!tocall.head);
@@ -1016,20 +1043,24 @@ Lagain:
       }
       return EVENT_CONT;
     }
-    // start back
+    // start back, once the writes before the end are done
     if (agg.head) {
+      if (agg_in_flight)
+        goto Lwait;
       agg_wrap();
       goto Lagain;
     }
   }
 
-  // evacuate space
-  off_t end = header->write_pos + agg_buf_pos + EVACUATION_SIZE;
-  if (evac_range(header->write_pos, end, !header->phase) < 0)
-    goto Lwait;
-  if (end > skip + len)
-    if (evac_range(start, start + (end - (skip + len)), header->phase) < 0)
+  {
+    // evacuate space
+    off_t end = agg_write_pos + agg_buf_pos + EVACUATION_SIZE;
+    if (evac_range(agg_write_pos, end, !header->phase) < 0)
       goto Lwait;
+    if (end > skip + len)
+      if (evac_range(start, start + (end - (skip + len)), header->phase) < 0)
+        goto Lwait;
+  }
 
   // if agg.head, then we are near the end of the disk, so
   // write down the aggregation in whatever size it is.
@@ -1046,25 +1077,36 @@ Lagain:
     d->magic = DOC_MAGIC;
     d->len = l;
     d->sync_serial = header->sync_serial;
-    d->write_serial = header->write_serial;
+    d->write_serial = header->write_serial + agg_in_flight;
   }
 
-  // set write limit
-  header->agg_pos = header->write_pos + agg_buf_pos;
-
-  io.aiocb.aio_fildes = fd;
-  io.aiocb.aio_offset = header->write_pos;
-  io.aiocb.aio_buf = agg_buffer;
-  io.aiocb.aio_nbytes = agg_buf_pos;
-  io.action = this;
-  /*
-    Callback on AIO thread so that we can issue a new write ASAP
-    as all writes are serialized in the volume.  This is not necessary
-    for reads proceed independently.
-   */
-  io.thread = AIO_CALLBACK_THREAD_AIO;
-  SET_HANDLER(&Vol::aggWriteDone);
-  ink_aio_write(&io);
+  {
+    // set write limit
+    header->agg_pos = agg_write_pos + agg_buf_pos;
+
+    AggBuffer *b = &agg_buffers[agg_cur];
+    b->io.aiocb.aio_fildes = fd;
+    b->io.aiocb.aio_offset = agg_write_pos;
+    b->io.aiocb.aio_buf = agg_buffer;
+    b->io.aiocb.aio_nbytes = agg_buf_pos;
+    b->io.action = b;
+    /*
+      Callback on AIO thread so that we can issue a new write ASAP
+      as all writes are serialized in the volume.  This is not necessary
+      for reads proceed independently.
+     */
+    b->io.thread = AIO_CALLBACK_THREAD_AIO;
+    // move on to the next buffer before the write can complete
+    agg_in_flight++;
+    agg_write_pos += agg_buf_pos;
+    agg_buf_pos = 0;
+    agg_cur = (agg_cur + 1) % agg_buffer_count;
+    agg_buffer = agg_buffers[agg_cur].buf;
+    ink_aio_write(&b->io);
+  }
+  // keep aggregating into the next buffer
+  if (agg.head)
+    goto Lagain;
 
 Lwait:
   int ret = EVENT_CONT;
@@ -1084,7 +1126,7 @@ CacheVC::openWriteCloseDir(int /* event ATS_UNUSED */, Event */* e ATS_UNUSED */
 {
   cancel_trigger();
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock) {
       SET_HANDLER(&CacheVC::openWriteCloseDir);
       ink_assert(!is_io_in_progress());
@@ -1143,7 +1185,7 @@ CacheVC::openWriteCloseHeadDone(int event, Event *e)
   else if (is_io_in_progress())
     return EVENT_CONT;
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock)
       VC_LOCK_RETRY_EVENT();
     od->writing_vec = 0;
@@ -1219,7 +1261,7 @@ CacheVC::openWriteCloseDataDone(int event, Event *e)
   if (!io.ok())
     return openWriteCloseDir(event, e);
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, this_ethread());
+    VOL_TRY_LOCK(lock, vol, this_ethread());
     if (!lock)
       VC_LOCK_RETRY_EVENT();
     if (!fragment) {
@@ -1314,7 +1356,7 @@ CacheVC::openWriteWriteDone(int event, Event *e)
     return calluser(VC_EVENT_ERROR);
   }
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock)
       VC_LOCK_RETRY_EVENT();
     // store the earliest directory. Need to remove the earliest dir
@@ -1440,7 +1482,7 @@ CacheVC::openWriteOverwrite(int event, Event *e)
   }
 Lcollision:
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, this_ethread());
+    VOL_TRY_LOCK(lock, vol, this_ethread());
     if (!lock)
       VC_LOCK_RETRY_EVENT();
     int res = dir_probe(&first_key, vol, &dir, &last_collision);
@@ -1471,7 +1513,7 @@ CacheVC::openWriteStartDone(int event, Event *e)
     set_io_not_in_progress();
   }
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock)
       VC_LOCK_RETRY_EVENT();
 
@@ -1757,7 +1799,7 @@ Cache::open_write(Continuation *cont, CacheKey *key, CacheHTTPInfo *info, time_t
   c->pin_in_cache = (uint32_t) apin_in_cache;
 
   {
-    CACHE_TRY_LOCK(lock, c->vol->mutex, cont->mutex->thread_holding);
+    VOL_TRY_LOCK(lock, c->vol, cont->mutex->thread_holding);
     if (lock) {
       if ((err = c->vol->open_write(c, if_writers,
                                      cache_config_http_max_alts > 1 ? cache_config_http_max_alts : 0)) > 0)
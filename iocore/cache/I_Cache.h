@@ -45,6 +45,7 @@
 
 #define RAM_CACHE_ALGORITHM_CLFUS        0
 #define RAM_CACHE_ALGORITHM_LRU          1
+#define RAM_CACHE_ALGORITHM_S3FIFO       2
 
 #define CACHE_COMPRESSION_NONE           0
 #define CACHE_COMPRESSION_FASTLZ         1
@@ -69,6 +70,7 @@ struct CacheProcessor:public Processor
   CacheProcessor()
     : min_stripe_version(CACHE_DB_MAJOR_VERSION, CACHE_DB_MINOR_VERSION)
     , max_stripe_version(CACHE_DB_MAJOR_VERSION, CACHE_DB_MINOR_VERSION)
+    , key_hash(CACHE_KEY_HASH_MMH)
     , cb_after_init(0)
   {}
 
@@ -107,6 +109,9 @@ struct CacheProcessor:public Processor
                             bool rm_user_agents = true, bool rm_link = false,
                             char *hostname = 0, int host_len = 0);
   Action *scan(Continuation *cont, char *hostname = 0, int host_len = 0, int KB_per_second = SCAN_KB_PER_SECOND);
+  // Write a listing of the objects in the cache to path (the log
+  // directory by default), KB_per_second = 0 for the configured rate.
+  Action *inventory(Continuation *cont, const char *path = NULL, int KB_per_second = 0);
 #ifdef HTTP_CACHE
   Action *lookup(Continuation *cont, URL *url, bool cluster_cache_local, bool local_only = false,
                  CacheFragType frag_type = CACHE_FRAG_TYPE_HTTP);
@@ -189,6 +194,9 @@ struct CacheProcessor:public Processor
   
   VersionNumber min_stripe_version;
   VersionNumber max_stripe_version;
+  /// Hash to make cache keys with, the configured one until the cache
+  /// is initialized, then the one the stripes were written with.
+  CacheKeyHash key_hash;
 
   CALLBACK_FUNC cb_after_init;
 };
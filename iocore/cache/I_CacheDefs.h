@@ -56,6 +56,15 @@
 #define CACHE_DEREF			12
 #define CACHE_LOOKUP_OP			13
 
+// Hash cache keys are made from URLs with, recorded in each stripe
+// header.  Stripes from before it was recorded hold zero there, and
+// used MMH.
+enum CacheKeyHash {
+  CACHE_KEY_HASH_MMH = 0,
+  CACHE_KEY_HASH_MD5 = 1,
+  CACHE_KEY_HASH_MURMUR3 = 2
+};
+
 enum CacheType {
   CACHE_NONE_TYPE = 0,  // for empty disk fragments
   CACHE_HTTP_TYPE = 1,
@@ -0,0 +1,72 @@
+/** @file
+
+  Admission filter for cache writes
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef _P_CACHE_ADMISSION_H__
+#define _P_CACHE_ADMISSION_H__
+
+#include "libts.h"
+
+//
+// A TinyLFU style frequency sketch: a count-min sketch of 4 bit counters
+// keyed on the cache key. Every sighting increments the key's counters
+// (conservatively, only the smallest ones), and once sample_size sightings
+// have been recorded all the counters are halved, so the sketch tracks
+// recent popularity rather than all time popularity.
+//
+// The counters are updated without a lock, concurrent updates of the same
+// word are resolved with a CAS and a sighting may be lost to a concurrent
+// aging pass, which is fine for an estimate.
+//
+#define CACHE_ADMISSION_ROWS        4
+#define CACHE_ADMISSION_MAX_COUNT   15
+
+struct CacheAdmissionFilter
+{
+  CacheAdmissionFilter()
+    : table(NULL), row_words(0), row_mask(0), sample_size(0), additions(0)
+  { }
+
+  ~CacheAdmissionFilter() { ats_free((void *)table); }
+
+  // Size the sketch to track about entries distinct objects.
+  void init(int64_t entries);
+  bool enabled() const { return table != NULL; }
+
+  // Record a sighting of the key, returns its estimated frequency
+  // including this sighting.
+  int record(const INK_MD5 & key);
+  int frequency(const INK_MD5 & key) const;
+
+private:
+  void age();
+
+  volatile uint64_t *table;     // CACHE_ADMISSION_ROWS rows of row_words words, 16 counters per word
+  int64_t row_words;
+  uint32_t row_mask;            // counters per row - 1
+  int64_t sample_size;
+  volatile int64_t additions;
+};
+
+extern CacheAdmissionFilter cache_admission;
+
+#endif /* _P_CACHE_ADMISSION_H__ */
@@ -317,6 +317,7 @@ struct CacheSync: public Continuation
 void vol_init_dir(Vol *d);
 int dir_token_probe(CacheKey *, Vol *, Dir *);
 int dir_probe(CacheKey *, Vol *, Dir *, Dir **);
+bool dir_probe_miss_unlocked(CacheKey *key, Vol *d);
 int dir_insert(CacheKey *key, Vol *d, Dir *to_part);
 int dir_overwrite(CacheKey *key, Vol *d, Dir *to_part, Dir *overwrite, bool must_overwrite = true);
 int dir_delete(CacheKey *key, Vol *d, Dir *del);
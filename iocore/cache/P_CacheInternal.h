@@ -70,6 +70,22 @@ struct EvacuationBlock;
     CACHE_MUTEX_RELEASE(_l)
 #endif
 
+// Count a miss of the vol lock, globally, for the volume and the stripe.
+#define VOL_LOCK_MISS(_v, _t) do { \
+  ink_atomic_increment(&(_v)->lock_misses, 1); \
+  RecIncrRawStat(cache_rsb, _t, (int) cache_vol_lock_miss_stat, 1); \
+  RecIncrRawStat((_v)->cache_vol->vol_rsb, _t, (int) cache_vol_lock_miss_stat, 1); \
+} while (0)
+
+// The lock has to be declared in the caller's scope, the miss count is
+// one statement after it.
+#define VOL_TRY_LOCK(_l, _v, _t)                               \
+  CACHE_TRY_LOCK(_l, (_v)->mutex, _t);                         \
+  do {                                                         \
+    if (!_l)                                                   \
+      VOL_LOCK_MISS(_v, _t);                                   \
+  } while (0)
+
 
 #define VC_LOCK_RETRY_EVENT() \
   do { \
@@ -160,6 +176,11 @@ enum
   cache_hdr_vector_marshal_stat,
   cache_hdr_marshal_stat,
   cache_hdr_marshal_bytes_stat,
+  cache_admission_admitted_stat,
+  cache_admission_rejected_stat,
+  cache_ram_cache_prefetched_stat,
+  cache_vol_lock_miss_stat,
+  cache_vol_lock_miss_probed_stat,
   cache_stat_count
 };
 
@@ -192,6 +213,9 @@ extern RecRawStatBlock *cache_rsb;
 	RecIncrRawStat(cache_rsb, this_ethread(), (int) (x), (int64_t) (y)); \
 	RecIncrRawStat(vol->cache_vol->vol_rsb, this_ethread(), (int) (x), (int64_t) (y));
 
+#define GLOBAL_CACHE_SUM_DYN_STAT_THREAD(x, y) \
+	RecIncrRawStat(cache_rsb, this_ethread(), (int) (x), (int64_t) (y));
+
 #define GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(x, y) \
 	RecIncrGlobalRawStatSum(cache_rsb,(x),(y))
 
@@ -214,6 +238,7 @@ extern int cache_config_permit_pinning;
 extern int cache_config_select_alternate;
 extern int cache_config_vary_on_user_agent;
 extern int cache_config_max_doc_size;
+extern int cache_config_admission_threshold;
 extern int cache_config_min_average_object_size;
 extern int cache_config_agg_write_backlog;
 extern int cache_config_enable_checksum;
@@ -229,9 +254,20 @@ extern int cache_config_hit_evacuate_size_limit;
 extern int cache_config_force_sector_size;
 extern int cache_config_target_fragment_size;
 extern int cache_config_mutex_retry_delay;
+extern int cache_config_vol_assignment;
+extern int64_t cache_config_max_stripe_size;
+extern int cache_config_agg_write_buffers;
+extern int cache_config_ram_cache_index_enabled;
+extern int cache_config_ram_cache_index_save_interval;
+extern int cache_config_ram_cache_index_prefetch_rate;
+extern int cache_config_inventory_rate;
 #if TS_USE_INTERIM_CACHE == 1
 extern int good_interim_disks;
 #endif
+
+// the largest stripe to create on a span, in store blocks
+off_t cache_max_stripe_blocks();
+
 // CacheVC
 struct CacheVC: public CacheVConnection
 {
@@ -287,6 +323,7 @@ struct CacheVC: public CacheVConnection
   int dead(int event, Event *e);
 
   int handleReadDone(int event, Event *e);
+  int ramCachePrefetchDone(int event, Event *e);
   int handleRead(int event, Event *e);
   int do_read_call(CacheKey *akey);
   int handleWrite(int event, Event *e);
@@ -756,7 +793,7 @@ CacheVC::handleWriteLock(int /* event ATS_UNUSED */, Event *e)
   cancel_trigger();
   int ret = 0;
   {
-    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    VOL_TRY_LOCK(lock, vol, mutex->thread_holding);
     if (!lock) {
       set_agg_write_in_progress();
       trigger = mutex->thread_holding->schedule_in_local(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
@@ -997,6 +1034,7 @@ CacheRemoveCont::event_handler(int event, void *data)
 
 int64_t cache_bytes_used(void);
 int64_t cache_bytes_total(void);
+bool cache_inventory_progress(int *vols_done, int *vols, int64_t *objects);
 
 #ifdef DEBUG
 #define CACHE_DEBUG_INCREMENT_DYN_STAT(_x) CACHE_INCREMENT_DYN_STAT(_x)
@@ -1049,6 +1087,7 @@ struct Cache
   Action *open_write(Continuation *cont, URL *url, CacheHTTPHdr *request,
                      CacheHTTPInfo *old_info, time_t pin_in_cache = (time_t) 0,
                      CacheFragType type = CACHE_FRAG_TYPE_HTTP);
+  bool admit(CacheKey *key);
   static void generate_key(INK_MD5 *md5, URL *url);
 #endif
 
@@ -1093,12 +1132,21 @@ TS_INLINE Action *
 Cache::open_write(Continuation *cont, CacheURL *url, CacheHTTPHdr *request,
                   CacheHTTPInfo *old_info, time_t pin_in_cache, CacheFragType type)
 {
-  (void) request;
   INK_MD5 url_md5;
   url->hash_get(&url_md5);
   int len;
   const char *hostname = url->host_get(&len);
 
+  // Only new documents go through admission, PUSH has to be able to write.
+  // Multiple writers are only allowed for the transformed copy next to a
+  // write the transaction already had admitted, which counted the request;
+  // the transaction skips the second write if the first one was rejected.
+  if (!old_info && cache_admission.enabled() && !(request && request->method_get_wksidx() == HTTP_WKSIDX_PUSH) &&
+      !admit(&url_md5)) {
+    cont->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *) -ECACHE_NOT_ADMITTED);
+    return ACTION_RESULT_DONE;
+  }
+
   return open_write(cont, &url_md5, old_info, pin_in_cache, NULL, type, (char *) hostname, len);
 }
 #endif
@@ -39,15 +39,14 @@
 #define AGG_SIZE                        (4 * 1024 * 1024) // 4MB
 #define AGG_HIGH_WATER                  (AGG_SIZE / 2) // 2MB
 #define EVACUATION_SIZE                 (2 * AGG_SIZE)  // 8MB
+#define AGG_WRITE_BUFFERS_MAX           4       // aggregation buffers per Vol
+#define RECOVERY_CLEAR_SIZE             (AGG_WRITE_BUFFERS_MAX * AGG_SIZE) // 16MB
 #define MAX_VOL_SIZE                   ((off_t)512 * 1024 * 1024 * 1024 * 1024)
 #define STORE_BLOCKS_PER_CACHE_BLOCK    (STORE_BLOCK_SIZE / CACHE_BLOCK_SIZE)
 #define MAX_VOL_BLOCKS                 (MAX_VOL_SIZE / CACHE_BLOCK_SIZE)
 #define MAX_FRAG_SIZE                   (AGG_SIZE - sizeofDoc) // true max
 #define LEAVE_FREE                      DEFAULT_MAX_BUFFER_SIZE
 #define PIN_SCAN_EVERY                  16      // scan every 1/16 of disk
-#define VOL_HASH_TABLE_SIZE             32707
-#define VOL_HASH_EMPTY                 0xFFFF
-#define VOL_HASH_ALLOC_SIZE             (8 * 1024 * 1024)  // one chance per this unit
 #define LOOKASIDE_SIZE                  256
 #define EVACUATION_BUCKET_SIZE          (2 * EVACUATION_SIZE) // 16MB
 #define RECOVERY_SIZE                   EVACUATION_SIZE // 8MB
@@ -113,7 +112,7 @@ struct VolHeaderFooter
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused;                // pad out to 8 byte boundary
+  uint32_t key_hash;              // CacheKeyHash of the keys in the stripe, also pads to 8 bytes
 #if TS_USE_INTERIM_CACHE == 1
   InterimVolHeaderFooter interim_header[8];
 #endif
@@ -414,6 +413,28 @@ void dir_clean_interimvol(InterimCacheVol *d);
 
 #endif
 
+// An aggregation buffer with its own AIO, so that a Vol can fill one
+// buffer while the writes of the others are in flight.
+struct AggBuffer: public Continuation
+{
+  Vol *vol;
+  char *buf;
+  bool done;                    // written, waiting for the earlier buffers
+  AIOCallbackInternal io;
+
+  int handle_write_done(int event, void *data);
+
+  AggBuffer()
+    : Continuation(NULL), vol(NULL), buf(NULL), done(false) {
+    SET_HANDLER(&AggBuffer::handle_write_done);
+  }
+
+  ~AggBuffer() {
+    if (buf)
+      ats_memalign_free(buf);
+  }
+};
+
 struct Vol: public Continuation
 {
   char *path;
@@ -423,6 +444,7 @@ struct Vol: public Continuation
 
   char *raw_dir;
   Dir *dir;
+  volatile uint32_t *dir_seq; // per segment, odd while the segment is being changed
   VolHeaderFooter *header;
   VolHeaderFooter *footer;
   int segments;
@@ -440,11 +462,17 @@ struct Vol: public Continuation
   Queue<CacheVC, Continuation::Link_link> agg;
   Queue<CacheVC, Continuation::Link_link> stat_cache_vcs;
   Queue<CacheVC, Continuation::Link_link> sync;
-  char *agg_buffer;
+  AggBuffer *agg_buffers;       // ring of agg_buffer_count buffers
+  int agg_buffer_count;
+  int agg_cur;                  // the buffer being filled
+  int agg_in_flight;            // buffers written but not yet done, before agg_cur
+  off_t agg_write_pos;          // where agg_cur goes, header->write_pos if none in flight
+  char *agg_buffer;             // agg_buffers[agg_cur].buf
   int agg_todo_size;
   int agg_buf_pos;
 
   Event *trigger;
+  volatile int64_t lock_misses;
 
   OpenDir open_dir;
   RamCache *ram_cache;
@@ -521,6 +549,8 @@ struct Vol: public Continuation
   // currently http handles a write-lock failure by retrying the read
   OpenDirEntry *open_read(CryptoHash *key);
   OpenDirEntry *open_read_lock(CryptoHash *key, EThread *t);
+  // true if key is surely not in the stripe, see dir_probe_miss_unlocked()
+  bool probe_miss_unlocked(CryptoHash *key);
   int close_read(CacheVC *cont);
   int close_read_lock(CacheVC *cont);
 
@@ -561,9 +591,11 @@ struct Vol: public Continuation
     io.aiocb.aio_fildes = AIO_NOT_IN_PROGRESS;
   }
   
-  int aggWriteDone(int event, Event *e);
+  int aggWriteDone(int event, AggBuffer *b);
   int aggWrite(int event, void *e);
   void agg_wrap();
+  void init_agg_buffers();
+  char *agg_buffer_data(off_t offset);
 
   int evacuateWrite(CacheVC *evacuator, int event, Event *e);
   int evacuateDocReadDone(int event, Event *e);
@@ -580,18 +612,18 @@ struct Vol: public Continuation
 
   Vol()
     : Continuation(new_ProxyMutex()), path(NULL), fd(-1),
-      dir(0), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0), skip(0), start(0),
-      len(0), data_blocks(0), hit_evacuate_window(0), agg_todo_size(0), agg_buf_pos(0), trigger(0),
-      evacuate_size(0), disk(NULL), last_sync_serial(0), last_write_serial(0), recover_wrapped(false),
+      dir(0), dir_seq(0), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0), skip(0), start(0),
+      len(0), data_blocks(0), hit_evacuate_window(0), agg_buffers(NULL), agg_buffer_count(0), agg_cur(0),
+      agg_in_flight(0), agg_write_pos(0), agg_buffer(NULL), agg_todo_size(0), agg_buf_pos(0), trigger(0),
+      lock_misses(0), evacuate_size(0), disk(NULL), last_sync_serial(0), last_write_serial(0), recover_wrapped(false),
       dir_sync_waiting(0), dir_sync_in_progress(0), writing_end_marker(0) {
     open_dir.mutex = mutex;
-    agg_buffer = (char *)ats_memalign(ats_pagesize(), AGG_SIZE);
-    memset(agg_buffer, 0, AGG_SIZE);
     SET_HANDLER(&Vol::aggWrite);
   }
 
   ~Vol() {
-    ats_memalign_free(agg_buffer);
+    delete[] agg_buffers;
+    ats_free((void *)dir_seq);
   }
 };
 
@@ -678,7 +710,20 @@ vol_direntries(Vol *d)
   return d->buckets * DIR_DEPTH * d->segments;
 }
 
+// end of the data given to the aggregation buffers, written or not
+TS_INLINE off_t
+vol_agg_end(Vol *d)
+{
+  return d->agg_write_pos + d->agg_buf_pos;
+}
+
 #if TS_USE_INTERIM_CACHE == 1
+TS_INLINE off_t
+vol_agg_end(InterimCacheVol *d)
+{
+  return d->header->write_pos + d->agg_buf_pos;
+}
+
 #define vol_out_of_phase_valid(d, e)            \
     (dir_offset(e) - 1 >= ((d->header->agg_pos - d->start) / CACHE_BLOCK_SIZE))
 
@@ -689,7 +734,7 @@ vol_direntries(Vol *d)
     (dir_offset(e) - 1 >= ((d->header->agg_pos - d->start + AGG_SIZE) / CACHE_BLOCK_SIZE))
 
 #define vol_in_phase_valid(d, e)                \
-    (dir_offset(e) - 1 < ((d->header->write_pos + d->agg_buf_pos - d->start) / CACHE_BLOCK_SIZE))
+    (dir_offset(e) - 1 < ((vol_agg_end(d) - d->start) / CACHE_BLOCK_SIZE))
 
 #define vol_offset_to_offset(d, pos)            \
     (d->start + pos * CACHE_BLOCK_SIZE - CACHE_BLOCK_SIZE)
@@ -704,7 +749,7 @@ vol_direntries(Vol *d)
     ((d)->start + (off_t) ((off_t)dir_offset(e) * CACHE_BLOCK_SIZE) - CACHE_BLOCK_SIZE)
 
 #define vol_in_phase_agg_buf_valid(d, e)        \
-    ((vol_offset(d, e) >= d->header->write_pos) && vol_offset(d, e) < (d->header->write_pos + d->agg_buf_pos))
+    ((vol_offset(d, e) >= d->header->write_pos) && vol_offset(d, e) < vol_agg_end(d))
 
 #define vol_transistor_range_valid(d, e)    \
   ((d->header->agg_pos + d->transistor_range_threshold < d->start + d->len) ? \
@@ -736,7 +781,7 @@ vol_out_of_phase_write_valid(Vol *d, Dir *e)
 TS_INLINE int
 vol_in_phase_valid(Vol *d, Dir *e)
 {
-  return (dir_offset(e) - 1 < ((d->header->write_pos + d->agg_buf_pos - d->start) / CACHE_BLOCK_SIZE));
+  return (dir_offset(e) - 1 < ((vol_agg_end(d) - d->start) / CACHE_BLOCK_SIZE));
 }
 
 TS_INLINE off_t
@@ -766,7 +811,7 @@ vol_dir_segment(Vol *d, int s)
 TS_INLINE int
 vol_in_phase_agg_buf_valid(Vol *d, Dir *e)
 {
-  return (vol_offset(d, e) >= d->header->write_pos && vol_offset(d, e) < (d->header->write_pos + d->agg_buf_pos));
+  return (vol_offset(d, e) >= d->header->write_pos && vol_offset(d, e) < vol_agg_end(d));
 }
 #endif
 // length of the partition not including the offset of location 0.
@@ -859,11 +904,21 @@ Vol::open_read(CryptoHash *key)
   return open_dir.open_read(key);
 }
 
+// May be called without the vol lock. A document stays in open_dir
+// until its directory entry is in, so check for writers first.
+TS_INLINE bool
+Vol::probe_miss_unlocked(CryptoHash *key)
+{
+  if (open_dir.bucket[key->slice32(0) % OPEN_DIR_BUCKETS].head)
+    return false;
+  return dir_probe_miss_unlocked(key, this);
+}
+
 TS_INLINE int
 Vol::within_hit_evacuate_window(Dir *xdir)
 {
   off_t oft = dir_offset(xdir) - 1;
-  off_t write_off = (header->write_pos + AGG_SIZE - start) / CACHE_BLOCK_SIZE;
+  off_t write_off = (agg_write_pos + AGG_SIZE - start) / CACHE_BLOCK_SIZE;
   off_t delta = oft - write_off;
   if (delta >= 0)
     return delta < hit_evacuate_window;
@@ -871,6 +926,23 @@ Vol::within_hit_evacuate_window(Dir *xdir)
     return -delta > (data_blocks - hit_evacuate_window) && -delta < data_blocks;
 }
 
+// the copy of the data at offset in the aggregation buffers,
+// for offsets in [header->write_pos, vol_agg_end())
+TS_INLINE char *
+Vol::agg_buffer_data(off_t offset)
+{
+  if (offset >= agg_write_pos)
+    return agg_buffer + (offset - agg_write_pos);
+  // in flight, oldest first
+  for (int i = agg_in_flight; i > 0; i--) {
+    AggBuffer *b = &agg_buffers[(agg_cur + agg_buffer_count - i) % agg_buffer_count];
+    if (offset < (off_t)(b->io.aiocb.aio_offset + b->io.aiocb.aio_nbytes))
+      return b->buf + (offset - b->io.aiocb.aio_offset);
+  }
+  ink_assert(!"offset not in the aggregation buffers");
+  return agg_buffer;
+}
+
 TS_INLINE uint32_t
 Vol::round_to_approx_size(uint32_t l) {
   uint32_t ll = round_to_approx_dir_size(l);
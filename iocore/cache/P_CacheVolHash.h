@@ -0,0 +1,51 @@
+/** @file
+
+  Assignment of cache keys to volumes
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef _P_CACHE_VOL_HASH_H__
+#define _P_CACHE_VOL_HASH_H__
+
+#include "libts.h"
+
+// A key maps to slot (key % VOL_HASH_TABLE_SIZE) of its host record's
+// table, and each slot to one of the volumes.
+#define VOL_HASH_TABLE_SIZE             32707
+#define VOL_HASH_EMPTY                 0xFFFF
+#define VOL_HASH_ALLOC_SIZE             (8 * 1024 * 1024)  // one chance per this unit
+
+// proxy.config.cache.vol_assignment
+#define VOL_ASSIGN_RING                 0       // closest of random points per VOL_HASH_ALLOC_SIZE
+#define VOL_ASSIGN_RENDEZVOUS           1       // weighted highest random weight
+
+//
+// Assign each slot of table to one of the n volumes, in proportion to the
+// volume lengths (in bytes). ids identify the volumes (Vol::hash_id) and
+// the assignment only depends on them and the lengths, not on the order
+// of the volumes. The slots are set to indexes into ids/lens.
+//
+// With VOL_ASSIGN_RENDEZVOUS, removing a volume only moves the slots it
+// had, and adding one only moves the slots it gets, spread evenly over
+// the other volumes.
+//
+void vol_hash_table_fill(unsigned short *table, int n, const CryptoHash *ids, const int64_t *lens, int algorithm);
+
+#endif /* _P_CACHE_VOL_HASH_H__ */
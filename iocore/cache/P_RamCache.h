@@ -26,6 +26,15 @@
 
 #include "I_Cache.h"
 
+// An object in a RamCache, as saved in the RAM cache index
+struct RamCacheIndexEntry {
+  INK_MD5 key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+  uint32_t hits;                 // the most hit are prefetched first
+  uint32_t reserved;
+};
+
 // Generic Ram Cache interface
 
 struct RamCache {
@@ -34,11 +43,19 @@ struct RamCache {
   virtual int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) = 0;
   virtual int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) = 0;
 
+  // append the cached objects to entries, the ones most worth keeping first
+  virtual void index(Vec<RamCacheIndexEntry> &entries) { (void)entries; }
+
   virtual void init(int64_t max_bytes, Vol *vol) = 0;
   virtual ~RamCache() {};
 };
 
 RamCache *new_RamCacheLRU();
 RamCache *new_RamCacheCLFUS();
+RamCache *new_RamCacheS3FIFO();
+
+// Saving the RAM cache index, and refilling the RAM caches from it at startup
+void ram_cache_index_init();
+void ram_cache_index_save_on_shutdown();
 
 #endif /* _P_RAM_CACHE_H__ */
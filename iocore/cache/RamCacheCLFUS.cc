@@ -66,6 +66,8 @@ struct RamCacheCLFUSEntry {
   Ptr<IOBufferData> data;
 };
 
+class RamCacheCLFUSCompressor;
+
 struct RamCacheCLFUS : public RamCache {
   int64_t max_bytes;
   int64_t bytes;
@@ -76,6 +78,7 @@ struct RamCacheCLFUS : public RamCache {
   int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
   int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
 
+  void index(Vec<RamCacheIndexEntry> &entries);
   void init(int64_t max_bytes, Vol *vol);
 
   // private
@@ -88,6 +91,7 @@ struct RamCacheCLFUS : public RamCache {
   uint16_t *seen;
   int ncompressed;
   RamCacheCLFUSEntry *compressed; // first uncompressed lru[0] entry
+  RamCacheCLFUSCompressor *compressor;
   void compress_entries(EThread *thread, int do_at_most = INT_MAX);
   void resize_hashtable();
   void victimize(RamCacheCLFUSEntry *e);
@@ -96,16 +100,19 @@ struct RamCacheCLFUS : public RamCache {
   void requeue_victims(RamCacheCLFUS *c, Que(RamCacheCLFUSEntry, lru_link) &victims);
   void tick(); // move CLOCK on history
   RamCacheCLFUS(): max_bytes(0), bytes(0), objects(0), vol(0), history(0), ibuckets(0), nbuckets(0), bucket(0),
-              seen(0), ncompressed(0), compressed(0) { }
+              seen(0), ncompressed(0), compressed(0), compressor(0) { }
+  ~RamCacheCLFUS();
 };
 
 class RamCacheCLFUSCompressor : public Continuation {
 public:
   RamCacheCLFUS *rc;
+  Event *event;
   int mainEvent(int event, Event *e);
+  void cancel();
 
   RamCacheCLFUSCompressor(RamCacheCLFUS *arc)
-    : rc(arc)
+    : Continuation(new_ProxyMutex()), rc(arc), event(0)
   { 
     SET_HANDLER(&RamCacheCLFUSCompressor::mainEvent); 
   }
@@ -136,6 +143,16 @@ RamCacheCLFUSCompressor::mainEvent(int /* event ATS_UNUSED */, Event *e)
   return EVENT_CONT;
 }
 
+// Waits for a running compression, which holds our lock, to finish.
+void
+RamCacheCLFUSCompressor::cancel()
+{
+  MUTEX_TAKE_LOCK(mutex, this_ethread());
+  event->cancel();
+  MUTEX_UNTAKE_LOCK(mutex, this_ethread());
+  delete this;
+}
+
 ClassAllocator<RamCacheCLFUSEntry> ramCacheCLFUSEntryAllocator("RamCacheCLFUSEntry");
 
 static const int bucket_sizes[] = {
@@ -180,7 +197,20 @@ RamCacheCLFUS::init(int64_t abytes, Vol *avol)
   if (!max_bytes)
     return;
   resize_hashtable();
-  eventProcessor.schedule_every(new RamCacheCLFUSCompressor(this), HRTIME_SECOND, ET_TASK);
+  compressor = new RamCacheCLFUSCompressor(this);
+  compressor->event = eventProcessor.schedule_every(compressor, HRTIME_SECOND, ET_TASK);
+}
+
+// without the vol lock held, which the compressor may be waiting for
+RamCacheCLFUS::~RamCacheCLFUS()
+{
+  if (compressor)
+    compressor->cancel();
+  for (int l = 0; l < 2; l++)
+    while (lru[l].head)
+      destroy(lru[l].head);
+  ats_free(bucket);
+  ats_free(seen);
 }
 
 #ifdef CHECK_ACOUNTING
@@ -673,6 +703,20 @@ RamCacheCLFUS::fixup(INK_MD5 * key, uint32_t old_auxkey1, uint32_t old_auxkey2,
   return 0;
 }
 
+// the objects in memory, most recently used first, the history is not saved
+void
+RamCacheCLFUS::index(Vec<RamCacheIndexEntry> &entries)
+{
+  for (RamCacheCLFUSEntry *e = lru[0].tail; e; e = e->lru_link.prev) {
+    RamCacheIndexEntry &x = entries.add();
+    x.key = e->key;
+    x.auxkey1 = e->auxkey1;
+    x.auxkey2 = e->auxkey2;
+    x.hits = e->hits > UINT32_MAX ? UINT32_MAX : (uint32_t)e->hits;
+    x.reserved = 0;
+  }
+}
+
 RamCache *
 new_RamCacheCLFUS()
 {
@@ -0,0 +1,382 @@
+/** @file
+
+  Saving the RAM cache index, and refilling the RAM caches from it
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// The keys of the objects in the RAM caches are saved periodically and on
+// shutdown. On startup the objects are read back from disk into the RAM
+// caches at a limited rate, the most valuable ones first, so that a
+// restarted server does not have to warm up its RAM cache one miss at a time.
+//
+// The saved entries carry the aux keys (the directory offset) the object
+// was cached under, an entry whose object has since been overwritten or
+// moved no longer matches a directory entry and is skipped.
+
+#include "P_Cache.h"
+#include "I_Layout.h"
+#include <algorithm>
+
+#define RAM_CACHE_INDEX_FILE      "ram_cache.index"
+#define RAM_CACHE_INDEX_MAGIC     0x52414d49    // "RAMI"
+#define RAM_CACHE_INDEX_VERSION   1
+#define RAM_CACHE_PREFETCH_PERIOD HRTIME_MSECONDS(100)
+
+struct RamCacheIndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t nvols;
+  uint32_t reserved;
+};
+
+// followed by count RamCacheIndexEntry
+struct RamCacheIndexVol {
+  CryptoHash hash_id;
+  uint32_t count;
+  uint32_t reserved;
+};
+
+int cache_config_ram_cache_index_enabled = 0;
+int cache_config_ram_cache_index_save_interval = 300;
+int cache_config_ram_cache_index_prefetch_rate = 100;
+
+static ink_mutex ram_cache_index_lock;
+
+static char *
+ram_cache_index_path()
+{
+  ats_scoped_str rundir(RecConfigReadRuntimeDir());
+  return Layout::relative_to(rundir, RAM_CACHE_INDEX_FILE);
+}
+
+static bool
+write_fully(int fd, const void *buf, size_t len)
+{
+  const char *p = (const char *)buf;
+
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+//
+// Save the index of all the RAM caches, t is the thread to take the volume
+// locks for.
+//
+static void
+ram_cache_index_save(EThread *t)
+{
+  Vec<RamCacheIndexEntry> *entries = new Vec<RamCacheIndexEntry>[gnvol];
+  ats_scoped_str path(ram_cache_index_path());
+  char tmp_path[PATH_NAME_MAX + 1];
+  RamCacheIndexHeader header;
+  int64_t total = 0;
+  int fd;
+  bool ok;
+
+  for (int i = 0; i < gnvol; i++) {
+    if (DISK_BAD(gvol[i]->disk))
+      continue;
+    MUTEX_TAKE_LOCK(gvol[i]->mutex, t);
+    gvol[i]->ram_cache->index(entries[i]);
+    MUTEX_UNTAKE_LOCK(gvol[i]->mutex, t);
+    total += entries[i].n;
+  }
+
+  // Write under a temporary name and rename it into place, an interrupted
+  // save leaves the previous index.
+  ink_mutex_acquire(&ram_cache_index_lock);
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", (const char *)path);
+  if ((fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    Warning("could not create RAM cache index %s: %s", tmp_path, strerror(errno));
+    goto Ldone;
+  }
+
+  header.magic = RAM_CACHE_INDEX_MAGIC;
+  header.version = RAM_CACHE_INDEX_VERSION;
+  header.nvols = gnvol;
+  header.reserved = 0;
+  ok = write_fully(fd, &header, sizeof(header));
+  for (int i = 0; ok && i < gnvol; i++) {
+    RamCacheIndexVol v;
+
+    v.hash_id = gvol[i]->hash_id;
+    v.count = entries[i].n;
+    v.reserved = 0;
+    ok = write_fully(fd, &v, sizeof(v)) &&
+      (!entries[i].n || write_fully(fd, entries[i].v, entries[i].n * sizeof(RamCacheIndexEntry)));
+  }
+  if (close(fd) < 0)
+    ok = false;
+  if (!ok || rename(tmp_path, path) < 0) {
+    Warning("could not write RAM cache index %s: %s", (const char *)path, strerror(errno));
+    unlink(tmp_path);
+    goto Ldone;
+  }
+  Debug("ram_cache", "saved %" PRId64 " RAM cache entries in %s", total, (const char *)path);
+
+Ldone:
+  ink_mutex_release(&ram_cache_index_lock);
+  delete[] entries;
+}
+
+static bool
+ram_cache_index_more_hits(const RamCacheIndexEntry &a, const RamCacheIndexEntry &b)
+{
+  return a.hits > b.hits;
+}
+
+//
+// Read the index saved by a previous run, entries[i] gets the entries of gvol[i],
+// the most hit first and otherwise in the order they were saved.
+//
+static int64_t
+ram_cache_index_load(Vec<RamCacheIndexEntry> *entries)
+{
+  ats_scoped_str path(ram_cache_index_path());
+  ats_scoped_fd fd(open(path, O_RDONLY));
+  RamCacheIndexHeader header;
+  int64_t total = 0;
+
+  if (fd < 0) {
+    Debug("ram_cache", "no RAM cache index %s", (const char *)path);
+    return 0;
+  }
+  if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+      header.magic != RAM_CACHE_INDEX_MAGIC || header.version != RAM_CACHE_INDEX_VERSION) {
+    Warning("ignoring RAM cache index %s: bad header", (const char *)path);
+    return 0;
+  }
+
+  for (uint32_t n = 0; n < header.nvols; n++) {
+    RamCacheIndexVol v;
+    Vec<RamCacheIndexEntry> *e = NULL;
+    size_t len;
+
+    if (read(fd, &v, sizeof(v)) != sizeof(v))
+      break;
+    for (int i = 0; i < gnvol; i++) {
+      if (gvol[i]->hash_id == v.hash_id && !DISK_BAD(gvol[i]->disk) && !entries[i].n) {
+        e = &entries[i];
+        break;
+      }
+    }
+    len = v.count * sizeof(RamCacheIndexEntry);
+    if (!e || !v.count) {
+      // the volume is gone or was reconfigured
+      if (lseek(fd, len, SEEK_CUR) < 0)
+        break;
+      continue;
+    }
+    if (v.count > (uint64_t)DIR_DEPTH * gvol[e - entries]->buckets * gvol[e - entries]->segments) {
+      Warning("ignoring RAM cache index %s: more entries than the directory holds", (const char *)path);
+      break;
+    }
+    e->reserve(v.count);
+    e->n = v.count;
+    if ((size_t)read(fd, e->v, len) != len) {
+      Warning("ignoring the rest of RAM cache index %s: truncated", (const char *)path);
+      e->clear();
+      break;
+    }
+    std::stable_sort(e->v, e->v + e->n, ram_cache_index_more_hits);
+    total += v.count;
+  }
+  return total;
+}
+
+//
+// Periodic saves, on a thread of their own since they write a file.
+//
+struct RamCacheIndexSaver: public Continuation
+{
+  int mainEvent(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+  {
+    for (;;) {
+      sleep(cache_config_ram_cache_index_save_interval);
+      ram_cache_index_save(this_ethread());
+    }
+    return 0;
+  }
+
+  RamCacheIndexSaver():Continuation(NULL)
+  {
+    SET_HANDLER(&RamCacheIndexSaver::mainEvent);
+  }
+};
+
+//
+// Reads the saved objects back into the RAM caches, a few at a time.
+//
+struct RamCachePrefetcher: public Continuation
+{
+  Vec<RamCacheIndexEntry> *entries;
+  size_t *next;
+  int remaining;        // volumes with entries left
+  int ivol;
+  int64_t prefetched;
+  int64_t skipped;
+
+  int prefetch(Vol *vol, RamCacheIndexEntry *entry);
+  int mainEvent(int event, Event *e);
+
+  RamCachePrefetcher(Vec<RamCacheIndexEntry> *aentries)
+    : Continuation(new_ProxyMutex()), entries(aentries), remaining(0), ivol(0), prefetched(0), skipped(0)
+  {
+    next = (size_t *)ats_calloc(gnvol, sizeof(size_t));
+    for (int i = 0; i < gnvol; i++)
+      if (entries[i].n)
+        remaining++;
+    SET_HANDLER(&RamCachePrefetcher::mainEvent);
+  }
+
+  ~RamCachePrefetcher()
+  {
+    ats_free(next);
+    delete[] entries;
+  }
+};
+
+// Called with the volume locked, returns 1 if a read was started.
+int
+RamCachePrefetcher::prefetch(Vol *vol, RamCacheIndexEntry *entry)
+{
+  CacheKey key = entry->key;
+  Dir dir, *last_collision = NULL;
+
+  while (dir_probe(&key, vol, &dir, &last_collision)) {
+#if TS_USE_INTERIM_CACHE == 1
+    uint64_t o = dir_get_offset(&dir);
+#else
+    uint64_t o = dir_offset(&dir);
+#endif
+    if ((uint32_t)(o >> 32) != entry->auxkey1 || (uint32_t)o != entry->auxkey2)
+      continue;
+
+    CacheVC *c = new_CacheVC(this);
+    c->vol = vol;
+    c->vio.op = VIO::READ;
+    c->base_stat = cache_read_active_stat;
+    CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
+    c->first_key = c->key = key;
+    c->dir = dir;
+    SET_CONTINUATION_HANDLER(c, &CacheVC::ramCachePrefetchDone);
+    if (c->do_read_call(&c->key) == EVENT_RETURN)
+      c->handleEvent(AIO_EVENT_DONE, 0);
+    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_prefetched_stat, 1);
+    return 1;
+  }
+  return 0;
+}
+
+int
+RamCachePrefetcher::mainEvent(int /* event ATS_UNUSED */, Event *e)
+{
+  int todo = cache_config_ram_cache_index_prefetch_rate / (HRTIME_SECOND / RAM_CACHE_PREFETCH_PERIOD);
+  int misses = 0;
+
+  if (todo < 1)
+    todo = 1;
+
+  // round robin over the volumes, skipping the busy ones
+  while (todo > 0 && remaining > 0 && misses < gnvol) {
+    Vol *vol = gvol[ivol];
+    int i = ivol;
+
+    ivol = (ivol + 1) % gnvol;
+    if (next[i] >= entries[i].n)
+      continue;
+
+    MUTEX_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock) {
+      misses++;
+      continue;
+    }
+    misses = 0;
+    if (prefetch(vol, &entries[i].v[next[i]])) {
+      prefetched++;
+      todo--;
+    } else
+      skipped++;
+    if (++next[i] >= entries[i].n) {
+      entries[i].clear();
+      remaining--;
+    }
+  }
+
+  if (remaining > 0) {
+    e->schedule_in(RAM_CACHE_PREFETCH_PERIOD);
+    return EVENT_CONT;
+  }
+  Note("RAM cache prefetch done, %" PRId64 " objects read, %" PRId64 " no longer cached", prefetched, skipped);
+  delete this;
+  return EVENT_DONE;
+}
+
+int
+CacheVC::ramCachePrefetchDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  cancel_trigger();
+  return free_CacheVC(this);
+}
+
+void
+ram_cache_index_init()
+{
+  if (!cache_config_ram_cache_index_enabled)
+    return;
+  ink_mutex_init(&ram_cache_index_lock, "RamCacheIndex");
+
+  if (cache_config_ram_cache_index_prefetch_rate > 0) {
+    Vec<RamCacheIndexEntry> *entries = new Vec<RamCacheIndexEntry>[gnvol];
+    int64_t total = ram_cache_index_load(entries);
+
+    if (total > 0) {
+      Note("prefetching %" PRId64 " objects into the RAM cache, %d per second", total,
+           cache_config_ram_cache_index_prefetch_rate);
+      eventProcessor.schedule_imm(new RamCachePrefetcher(entries), ET_CALL);
+    } else
+      delete[] entries;
+  }
+
+  if (cache_config_ram_cache_index_save_interval > 0) {
+    size_t stacksize;
+
+    REC_ReadConfigInteger(stacksize, "proxy.config.thread.default.stacksize");
+    eventProcessor.spawn_thread(new RamCacheIndexSaver, "[RAM_CACHE_INDEX]", stacksize);
+  }
+}
+
+void
+ram_cache_index_save_on_shutdown()
+{
+  if (!cache_config_ram_cache_index_enabled || !CacheProcessor::IsCacheReady(CACHE_FRAG_TYPE_HTTP))
+    return;
+  // the process is going down, do a blocking save
+  ram_cache_index_save((EThread *)0xdeadbeef);
+}
@@ -42,6 +42,7 @@ struct RamCacheLRU: public RamCache {
   int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
   int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
 
+  void index(Vec<RamCacheIndexEntry> &entries);
   void init(int64_t max_bytes, Vol *vol);
 
   // private
@@ -56,6 +57,7 @@ struct RamCacheLRU: public RamCache {
   RamCacheLRUEntry *remove(RamCacheLRUEntry *e);
 
   RamCacheLRU():bytes(0), objects(0), seen(0), bucket(0), nbuckets(0), ibuckets(0), vol(NULL) {}
+  ~RamCacheLRU();
 };
 
 ClassAllocator<RamCacheLRUEntry> ramCacheLRUEntryAllocator("RamCacheLRUEntry");
@@ -136,6 +138,14 @@ RamCacheLRUEntry * RamCacheLRU::remove(RamCacheLRUEntry *e) {
   return ret;
 }
 
+// with the vol lock held, like everything else
+RamCacheLRU::~RamCacheLRU() {
+  while (lru.head)
+    remove(lru.head);
+  ats_free(bucket);
+  ats_free(seen);
+}
+
 // ignore 'copy' since we don't touch the data
 int RamCacheLRU::put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2) {
   if (!max_bytes)
@@ -205,6 +215,18 @@ int RamCacheLRU::fixup(INK_MD5 * key, uint32_t old_auxkey1, uint32_t old_auxkey2
   return 0;
 }
 
+// most recently used first
+void RamCacheLRU::index(Vec<RamCacheIndexEntry> &entries) {
+  for (RamCacheLRUEntry *e = lru.tail; e; e = e->lru_link.prev) {
+    RamCacheIndexEntry &x = entries.add();
+    x.key = e->key;
+    x.auxkey1 = e->auxkey1;
+    x.auxkey2 = e->auxkey2;
+    x.hits = 0;
+    x.reserved = 0;
+  }
+}
+
 RamCache *new_RamCacheLRU() {
   return new RamCacheLRU;
 }
@@ -0,0 +1,296 @@
+/** @file
+
+  A brief file description
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// S3-FIFO replacement policy (Yang et al., "FIFO queues are all you need
+// for cache eviction", SOSP 2023).
+//
+// New objects enter a small FIFO holding about 10% of the bytes. Objects
+// evicted from it that were hit while there move to the main FIFO, the
+// others leave their key behind in a ghost FIFO, and a put() that finds a
+// ghost goes straight into the main FIFO. The main FIFO is a CLOCK: an
+// object that was hit since it was queued gets requeued instead of evicted.
+// One time objects (e.g. a crawler scan) therefore only ever cycle through
+// the small FIFO. Hits only bump a 2 bit counter and never relink entries,
+// so get() is a hash lookup and nothing else.
+
+#include "P_Cache.h"
+
+#define SMALL_QUEUE_PERCENT 10
+#define MAX_FREQ 3
+
+enum
+{
+  S3FIFO_SMALL,
+  S3FIFO_MAIN,
+  S3FIFO_GHOST,
+  S3FIFO_QUEUES
+};
+
+struct RamCacheS3FIFOEntry {
+  INK_MD5 key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+  uint32_t size; // block size of the data, 0 for a ghost
+  uint8_t freq;
+  uint8_t queue;
+  LINK(RamCacheS3FIFOEntry, lru_link);
+  LINK(RamCacheS3FIFOEntry, hash_link);
+  Ptr<IOBufferData> data;
+};
+
+struct RamCacheS3FIFO: public RamCache {
+  int64_t max_bytes;
+  int64_t bytes;
+  int64_t objects;
+
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
+  int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
+
+  void index(Vec<RamCacheIndexEntry> &entries);
+  void init(int64_t max_bytes, Vol *vol);
+
+  // private
+  int64_t small_bytes;
+  int64_t ghosts;
+  Que(RamCacheS3FIFOEntry, lru_link) queue[S3FIFO_QUEUES];
+  DList(RamCacheS3FIFOEntry, hash_link) *bucket;
+  int nbuckets;
+  int ibuckets;
+  Vol *vol;
+
+  void resize_hashtable();
+  void evict();
+  RamCacheS3FIFOEntry *destroy(RamCacheS3FIFOEntry *e);
+
+  RamCacheS3FIFO():max_bytes(0), bytes(0), objects(0), small_bytes(0), ghosts(0), bucket(0), nbuckets(0), ibuckets(0), vol(NULL) {}
+  ~RamCacheS3FIFO();
+};
+
+ClassAllocator<RamCacheS3FIFOEntry> ramCacheS3FIFOEntryAllocator("RamCacheS3FIFOEntry");
+
+static const int bucket_sizes[] = {
+  127, 251, 509, 1021, 2039, 4093, 8191, 16381, 32749, 65521, 131071, 262139,
+  524287, 1048573, 2097143, 4194301, 8388593, 16777213, 33554393, 67108859,
+  134217689, 268435399, 536870909
+};
+
+void RamCacheS3FIFO::resize_hashtable() {
+  int anbuckets = bucket_sizes[ibuckets];
+  DDebug("ram_cache", "resize hashtable %d", anbuckets);
+  int64_t s = anbuckets * sizeof(DList(RamCacheS3FIFOEntry, hash_link));
+  DList(RamCacheS3FIFOEntry, hash_link) *new_bucket = (DList(RamCacheS3FIFOEntry, hash_link) *)ats_malloc(s);
+  memset(new_bucket, 0, s);
+  if (bucket) {
+    for (int64_t i = 0; i < nbuckets; i++) {
+      RamCacheS3FIFOEntry *e = 0;
+      while ((e = bucket[i].pop()))
+        new_bucket[e->key.slice32(3) % anbuckets].push(e);
+    }
+    ats_free(bucket);
+  }
+  bucket = new_bucket;
+  nbuckets = anbuckets;
+}
+
+void
+RamCacheS3FIFO::init(int64_t abytes, Vol *avol) {
+  vol = avol;
+  max_bytes = abytes;
+  DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
+  if (!max_bytes)
+    return;
+  resize_hashtable();
+}
+
+int
+RamCacheS3FIFO::get(INK_MD5 * key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2) {
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->slice32(3) % nbuckets;
+  RamCacheS3FIFOEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2 && e->queue != S3FIFO_GHOST) {
+      if (e->freq < MAX_FREQ)
+        e->freq++;
+      (*ret_data) = e->data;
+      DDebug("ram_cache", "get %X %d %d HIT", key->slice32(3), auxkey1, auxkey2);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  DDebug("ram_cache", "get %X %d %d MISS", key->slice32(3), auxkey1, auxkey2);
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  return 0;
+}
+
+RamCacheS3FIFOEntry * RamCacheS3FIFO::destroy(RamCacheS3FIFOEntry *e) {
+  RamCacheS3FIFOEntry *ret = e->hash_link.next;
+  uint32_t b = e->key.slice32(3) % nbuckets;
+  bucket[b].remove(e);
+  queue[e->queue].remove(e);
+  if (e->queue == S3FIFO_GHOST) {
+    ghosts--;
+  } else {
+    if (e->queue == S3FIFO_SMALL)
+      small_bytes -= e->size;
+    bytes -= e->size;
+    objects--;
+    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)e->size);
+    DDebug("ram_cache", "put %X %d %d FREED", e->key.slice32(3), e->auxkey1, e->auxkey2);
+  }
+  e->data = NULL;
+  THREAD_FREE(e, ramCacheS3FIFOEntryAllocator, this_thread());
+  return ret;
+}
+
+// with the vol lock held, like everything else
+RamCacheS3FIFO::~RamCacheS3FIFO() {
+  for (int q = 0; q < S3FIFO_QUEUES; q++)
+    while (queue[q].head)
+      destroy(queue[q].head);
+  ats_free(bucket);
+}
+
+// Make one step towards freeing space, either evicting an object or
+// moving one from the small to the main FIFO.
+void RamCacheS3FIFO::evict() {
+  RamCacheS3FIFOEntry *e;
+
+  if (small_bytes > max_bytes / 100 * SMALL_QUEUE_PERCENT || !queue[S3FIFO_MAIN].head) {
+    if (!(e = queue[S3FIFO_SMALL].dequeue()))
+      return;
+    small_bytes -= e->size;
+    if (e->freq) {
+      e->freq = 0;
+      e->queue = S3FIFO_MAIN;
+      queue[S3FIFO_MAIN].enqueue(e);
+      return;
+    }
+    // leave a ghost, as many of them as there are objects
+    DDebug("ram_cache", "put %X %d %d GHOSTED", e->key.slice32(3), e->auxkey1, e->auxkey2);
+    bytes -= e->size;
+    objects--;
+    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)e->size);
+    e->data = NULL;
+    e->size = 0;
+    e->queue = S3FIFO_GHOST;
+    queue[S3FIFO_GHOST].enqueue(e);
+    ghosts++;
+    while (ghosts > objects && (e = queue[S3FIFO_GHOST].head))
+      destroy(e);
+  } else {
+    e = queue[S3FIFO_MAIN].head;
+    if (e->freq) {
+      e->freq--;
+      queue[S3FIFO_MAIN].remove(e);
+      queue[S3FIFO_MAIN].enqueue(e);
+    } else
+      destroy(e);
+  }
+}
+
+// ignore 'copy' since we don't touch the data
+int RamCacheS3FIFO::put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2) {
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->slice32(3) % nbuckets;
+  bool ghost = false;
+  RamCacheS3FIFOEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key) {
+      if (e->queue == S3FIFO_GHOST) {
+        ghost = true;
+        e = destroy(e);
+        continue;
+      } else if (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+        if (e->freq < MAX_FREQ)
+          e->freq++;
+        return 1;
+      } else { // discard when aux keys conflict
+        e = destroy(e);
+        continue;
+      }
+    }
+    e = e->hash_link.next;
+  }
+  e = THREAD_ALLOC(ramCacheS3FIFOEntryAllocator, this_ethread());
+  e->key = *key;
+  e->auxkey1 = auxkey1;
+  e->auxkey2 = auxkey2;
+  e->size = data->block_size();
+  e->freq = 0;
+  e->queue = ghost ? S3FIFO_MAIN : S3FIFO_SMALL;
+  e->data = data;
+  bucket[i].push(e);
+  queue[e->queue].enqueue(e);
+  if (!ghost)
+    small_bytes += e->size;
+  bytes += e->size;
+  objects++;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, e->size);
+  while (bytes > max_bytes)
+    evict();
+  DDebug("ram_cache", "put %X %d %d len %d INSERTED%s", key->slice32(3), auxkey1, auxkey2, len, ghost ? " (GHOST)" : "");
+  if (objects + ghosts > nbuckets && ibuckets + 1 < (int)countof(bucket_sizes)) {
+    ++ibuckets;
+    resize_hashtable();
+  }
+  return 1;
+}
+
+int RamCacheS3FIFO::fixup(INK_MD5 * key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) {
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->slice32(3) % nbuckets;
+  RamCacheS3FIFOEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == old_auxkey1 && e->auxkey2 == old_auxkey2 && e->queue != S3FIFO_GHOST) {
+      e->auxkey1 = new_auxkey1;
+      e->auxkey2 = new_auxkey2;
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  return 0;
+}
+
+// the main queue first, ghosts are not worth saving
+void RamCacheS3FIFO::index(Vec<RamCacheIndexEntry> &entries) {
+  for (int q = S3FIFO_MAIN; q >= S3FIFO_SMALL; q--) {
+    for (RamCacheS3FIFOEntry *e = queue[q].tail; e; e = e->lru_link.prev) {
+      RamCacheIndexEntry &x = entries.add();
+      x.key = e->key;
+      x.auxkey1 = e->auxkey1;
+      x.auxkey2 = e->auxkey2;
+      x.hits = e->freq;
+      x.reserved = 0;
+    }
+  }
+}
+
+RamCache *new_RamCacheS3FIFO() {
+  return new RamCacheS3FIFO;
+}
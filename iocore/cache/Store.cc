@@ -35,6 +35,7 @@
 
 char const Store::VOLUME_KEY[] = "volume";
 char const Store::HASH_BASE_STRING_KEY[] = "id";
+char const Store::AGG_BUFFERS_KEY[] = "agg_buffers";
 
 static span_error_t
 make_span_error(int error)
@@ -239,6 +240,12 @@ Span::volume_number_set(int n)
   forced_volume_num = n;
 }
 
+void
+Span::agg_write_buffers_set(int n)
+{
+  agg_write_buffers = n;
+}
+
 void
 Store::delete_all()
 {
@@ -347,6 +354,7 @@ Store::read_config()
 
     int64_t size = -1;
     int volume_num = -1;
+    int agg_buffers = 0;
     char const* e;
     while (0 != (e = tokens.getNext())) {
       if (ParseRules::is_digit(*e)) {
@@ -366,6 +374,13 @@ Store::read_config()
           err = "error parsing volume number";
           goto Lfail;
         }
+      } else if (0 == strncasecmp(AGG_BUFFERS_KEY, e, sizeof(AGG_BUFFERS_KEY)-1)) {
+        e += sizeof(AGG_BUFFERS_KEY) - 1;
+        if ('=' == *e) ++e;
+        if (!*e || !ParseRules::is_digit(*e) || 0 >= (agg_buffers = ink_atoi(e))) {
+          err = "error parsing aggregation buffer count";
+          goto Lfail;
+        }
       }
     }
 
@@ -386,6 +401,7 @@ Store::read_config()
     // Set side values if present.
     if (seed) ns->hash_base_string_set(seed);
     if (volume_num > 0) ns->volume_number_set(volume_num);
+    if (agg_buffers > 0) ns->agg_write_buffers_set(agg_buffers);
 
     // new Span
     {
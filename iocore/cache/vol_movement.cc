@@ -0,0 +1,219 @@
+/** @file
+
+  Predict how much of the cache a storage.config change moves
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/*
+  vol_movement old_storage.config new_storage.config
+
+  Builds the volume assignment table for both storage configurations, the
+  same way the cache does, and reports the share of the cache keys that
+  map to a different span afterwards (and so are lost). A disk failure is
+  the old configuration without the failed disk.
+
+  Each span is modeled as a single volume identified by its path (or its
+  "id=" seed) and size, the way a span with no volume.config is laid out.
+  The exact random points differ from those of the running cache, the
+  shares moved are the same in expectation.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "libts.h"
+#include "I_Version.h"
+#include "P_CacheVolHash.h"
+
+struct VolModel
+{
+  char path[PATH_NAME_MAX + 1];
+  CryptoHash id;
+  int64_t len;
+};
+
+static AppVersionInfo appVersionInfo;
+static char algorithm[32] = "both";
+
+static const ArgumentDescription argument_descriptions[] = {
+  {"algorithm", 'a', "Assignment (ring, rendezvous or both)", "S31", algorithm, NULL, NULL},
+  HELP_ARGUMENT_DESCRIPTION(),
+  VERSION_ARGUMENT_DESCRIPTION()
+};
+
+static int64_t
+span_size(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  off_t size;
+
+  if (fd < 0)
+    return -1;
+  size = lseek(fd, 0, SEEK_END);
+  close(fd);
+  return size;
+}
+
+// Parse the "path [size] [id=seed] [volume=n]" lines of a storage.config.
+static int
+read_storage_config(const char *filename, VolModel **ret)
+{
+  FILE *fp = fopen(filename, "r");
+  VolModel *vols = NULL;
+  char line[1024];
+  int n = 0;
+
+  if (!fp) {
+    fprintf(stderr, "%s: %s\n", filename, strerror(errno));
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), fp)) {
+    char *last = NULL;
+    char *path = strtok_r(line, " \t\r\n", &last);
+    const char *seed = NULL;
+    int64_t size = -1;
+    char *tok, text[PATH_NAME_MAX + 64];
+
+    if (!path || path[0] == '#')
+      continue;
+    while ((tok = strtok_r(NULL, " \t\r\n", &last))) {
+      if (ParseRules::is_digit(*tok))
+        size = ink_atoi64(tok);
+      else if (!strncasecmp(tok, "id=", 3))
+        seed = tok + 3;
+    }
+    if (size <= 0 && (size = span_size(path)) <= 0) {
+      fprintf(stderr, "%s: no size given for %s, and it can not be opened\n", filename, path);
+      exit(1);
+    }
+    vols = (VolModel *)ats_realloc(vols, (n + 1) * sizeof(VolModel));
+    ink_strlcpy(vols[n].path, path, sizeof(vols[n].path));
+    vols[n].len = size & ~(int64_t)(8192 - 1);
+    snprintf(text, sizeof(text), "%s %" PRId64, seed ? seed : path, vols[n].len);
+    MD5Context().hash_immediate(vols[n].id, text, strlen(text));
+    n++;
+  }
+  fclose(fp);
+  if (!n) {
+    fprintf(stderr, "%s: no storage\n", filename);
+    exit(1);
+  }
+  *ret = vols;
+  return n;
+}
+
+static unsigned short *
+build_table(VolModel *vols, int n, int algorithm)
+{
+  unsigned short *table = (unsigned short *)ats_malloc(VOL_HASH_TABLE_SIZE * sizeof(unsigned short));
+  CryptoHash *ids = (CryptoHash *)ats_malloc(n * sizeof(CryptoHash));
+  int64_t *lens = (int64_t *)ats_malloc(n * sizeof(int64_t));
+
+  for (int i = 0; i < n; i++) {
+    ids[i] = vols[i].id;
+    lens[i] = vols[i].len;
+  }
+  vol_hash_table_fill(table, n, ids, lens, algorithm);
+  ats_free(ids);
+  ats_free(lens);
+  return table;
+}
+
+static void
+report(const char *name, int algorithm, VolModel *ovols, int on, VolModel *nvols, int nn)
+{
+  unsigned short *otable = build_table(ovols, on, algorithm);
+  unsigned short *ntable = build_table(nvols, nn, algorithm);
+  int *ocount = (int *)ats_calloc(on, sizeof(int));
+  int *ncount = (int *)ats_calloc(nn, sizeof(int));
+  int *moved_from = (int *)ats_calloc(on, sizeof(int));
+  int *same = (int *)ats_malloc(on * sizeof(int));
+  int moved = 0, lost = 0;
+
+  // the new volume that is the same span as each old one, if any
+  for (int i = 0; i < on; i++) {
+    same[i] = -1;
+    for (int j = 0; j < nn; j++)
+      if (ovols[i].id == nvols[j].id)
+        same[i] = j;
+  }
+  for (int s = 0; s < VOL_HASH_TABLE_SIZE; s++) {
+    int o = otable[s], n = ntable[s];
+
+    ocount[o]++;
+    ncount[n]++;
+    if (same[o] != n) {
+      moved++;
+      moved_from[o]++;
+      if (same[o] < 0)
+        lost++;
+    }
+  }
+
+  printf("%s: %.2f%% of the keys move (%.2f%% were on removed spans)\n", name,
+         100.0 * moved / VOL_HASH_TABLE_SIZE, 100.0 * lost / VOL_HASH_TABLE_SIZE);
+  for (int i = 0; i < on; i++)
+    printf("  %-40s %6.2f%% -> %6.2f%%, %.2f%% of its keys move\n", ovols[i].path,
+           100.0 * ocount[i] / VOL_HASH_TABLE_SIZE, same[i] < 0 ? 0.0 : 100.0 * ncount[same[i]] / VOL_HASH_TABLE_SIZE,
+           ocount[i] ? 100.0 * moved_from[i] / ocount[i] : 0.0);
+  for (int j = 0; j < nn; j++) {
+    bool added = true;
+    for (int i = 0; i < on; i++)
+      if (same[i] == j)
+        added = false;
+    if (added)
+      printf("  %-40s    new -> %6.2f%%\n", nvols[j].path, 100.0 * ncount[j] / VOL_HASH_TABLE_SIZE);
+  }
+
+  ats_free(otable);
+  ats_free(ntable);
+  ats_free(ocount);
+  ats_free(ncount);
+  ats_free(moved_from);
+  ats_free(same);
+}
+
+int
+main(int /* argc ATS_UNUSED */, char *argv[])
+{
+  VolModel *ovols, *nvols;
+  int on, nn;
+
+  appVersionInfo.setup(PACKAGE_NAME, "vol_movement", PACKAGE_VERSION, __DATE__, __TIME__, BUILD_MACHINE, BUILD_PERSON, "");
+  process_args(&appVersionInfo, argument_descriptions, countof(argument_descriptions), argv);
+  if (n_file_arguments != 2)
+    usage(argument_descriptions, countof(argument_descriptions), "old_storage.config new_storage.config");
+
+  on = read_storage_config(file_arguments[0], &ovols);
+  nn = read_storage_config(file_arguments[1], &nvols);
+
+  if (!strcasecmp(algorithm, "ring") || !strcasecmp(algorithm, "both"))
+    report("ring (vol_assignment 0)", VOL_ASSIGN_RING, ovols, on, nvols, nn);
+  if (!strcasecmp(algorithm, "rendezvous") || !strcasecmp(algorithm, "both"))
+    report("rendezvous (vol_assignment 1)", VOL_ASSIGN_RENDEZVOUS, ovols, on, nvols, nn);
+
+  ats_free(ovols);
+  ats_free(nvols);
+  return 0;
+}
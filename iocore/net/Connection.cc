@@ -164,6 +164,16 @@ Server::setup_fd_for_listen(
     add_http_filter(fd);
   }
 
+  if (tfo_queue_length > 0) {
+#ifdef TCP_FASTOPEN
+    if (safe_setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, (char *) &tfo_queue_length, sizeof(int)) < 0) {
+      Warning("unable to enable TCP Fast Open on port %d: %s", ats_ip_port_host_order(&accept_addr), strerror(errno));
+    }
+#else
+    Warning("TCP Fast Open is not supported on this platform");
+#endif
+  }
+
 #ifdef SEND_BUF_SIZE
   {
     int send_buf_size = SEND_BUF_SIZE;
@@ -95,6 +95,10 @@ public:
     */
     bool f_inbound_transparent;
 
+    /// TCP Fast Open queue length for the listen socket.
+    /// 0 => TCP Fast Open is not enabled.
+    int tfo_queue_length;
+
     /// Default constructor.
     /// Instance is constructed with default values.
     AcceptOptions() { this->reset(); }
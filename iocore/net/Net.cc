@@ -111,6 +111,15 @@ register_net_stats()
   RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.inactivity_cop_lock_acquire_failure",
                      RECD_INT, RECP_PERSISTENT, (int) inactivity_cop_lock_acquire_failure_stat,
                      RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.tcp_fastopen.accepted",
+                     RECD_INT, RECP_PERSISTENT, (int) net_tfo_accepted_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.tcp_fastopen.connects",
+                     RECD_INT, RECP_PERSISTENT, (int) net_tfo_connects_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.tcp_fastopen.fallbacks",
+                     RECD_INT, RECP_PERSISTENT, (int) net_tfo_fallbacks_stat, RecRawStatSyncSum);
 }
 
 void
@@ -164,6 +164,9 @@ struct Server: public Connection
   /// If set, a kernel HTTP accept filter
   bool http_accept_filter;
 
+  /// TCP Fast Open queue length, 0 if not enabled.
+  int tfo_queue_length;
+
   //
   // Use this call for the main proxy accept
   //
@@ -188,6 +191,7 @@ struct Server: public Connection
   Server()
     : Connection()
     , f_inbound_transparent(false)
+    , tfo_queue_length(0)
   {
     ink_zero(accept_addr);
   }
@@ -51,6 +51,9 @@ enum Net_Stats
   socks_connections_unsuccessful_stat,
   socks_connections_currently_open_stat,
   inactivity_cop_lock_acquire_failure_stat,
+  net_tfo_accepted_stat,
+  net_tfo_connects_stat,
+  net_tfo_fallbacks_stat,
   Net_Stat_Count
 };
 
@@ -95,6 +95,7 @@ enum SSL_Stats
 };
 
 extern RecRawStatBlock *ssl_rsb;
+extern RecHistogram *ssl_handshake_latency;
 
 /* Stats should only be accessed using these macros */
 #define SSL_INCREMENT_DYN_STAT(x) RecIncrRawStat(ssl_rsb, NULL, (int) x, 1)
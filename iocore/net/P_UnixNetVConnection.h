@@ -227,6 +227,8 @@ public:
     {
       unsigned int got_local_addr:1;
       unsigned int shutdown:2;
+      unsigned int tfo_accept:1;  ///< Accepted on a TCP Fast Open listener.
+      unsigned int tfo_connect:1; ///< Connected with TCP Fast Open.
     } f;
   };
 
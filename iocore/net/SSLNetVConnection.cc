@@ -974,6 +974,7 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
       Debug("ssl", "ssl handshake time:%" PRId64, ssl_handshake_time);
       sslHandshakeBeginTime = 0;
       SSL_INCREMENT_DYN_STAT_EX(ssl_total_handshake_time_stat, ssl_handshake_time);
+      RecIncrHistogram(ssl_handshake_latency, NULL, ssl_handshake_time);
       SSL_INCREMENT_DYN_STAT(ssl_total_success_handshake_count_stat);
     }
 
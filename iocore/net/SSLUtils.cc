@@ -127,6 +127,7 @@ static pthread_mutex_t *mutex_buf = NULL;
 static bool open_ssl_initialized = false;
 
 RecRawStatBlock *ssl_rsb = NULL;
+RecHistogram *ssl_handshake_latency = NULL;
 static InkHashTable *ssl_cipher_name_table = NULL;
 
 /* Using pthread thread ID and mutex functions directly, instead of
@@ -733,6 +734,7 @@ SSLInitializeStatistics()
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.total_success_handshake_count",
                      RECD_INT, RECP_PERSISTENT, (int) ssl_total_success_handshake_count_stat,
                      RecRawStatSyncCount);
+  ssl_handshake_latency = RecAllocateHistogram("proxy.process.ssl.latency.handshake");
 
   // TLS tickets
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.total_tickets_created",
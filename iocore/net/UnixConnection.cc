@@ -377,6 +377,14 @@ Connection::apply_options(NetVCOptions const& opt)
       safe_setsockopt(fd, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
       Debug("socket", "::open:: setsockopt() turn on SO_LINGER on socket");
     }
+#ifdef TCP_FASTOPEN_CONNECT
+    // Only takes effect before the connect, which then returns at once and
+    // the first write goes out with the SYN if there is a cookie for the peer.
+    if (!is_connected && (opt.sockopt_flags & NetVCOptions::SOCK_OPT_TCP_FAST_OPEN)) {
+      safe_setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, SOCKOPT_ON, sizeof(int));
+      Debug("socket", "::open: setsockopt() TCP_FASTOPEN_CONNECT on socket");
+    }
+#endif
   }
 
 #if TS_HAS_SO_MARK
@@ -122,6 +122,7 @@ net_accept(NetAccept * na, void *ep, bool blockable)
     vc->mutex = new_ProxyMutex();
     vc->action_ = *na->action_;
     vc->set_is_transparent(na->server.f_inbound_transparent);
+    vc->f.tfo_accept = na->server.tfo_queue_length > 0;
     vc->closed  = 0;
     SET_CONTINUATION_HANDLER(vc, (NetVConnHandler) & UnixNetVConnection::acceptEvent);
 
@@ -304,6 +305,7 @@ NetAccept::do_blocking_accept(EThread * t)
     vc->submit_time = now;
     ats_ip_copy(&vc->server_addr, &vc->con.addr);
     vc->set_is_transparent(server.f_inbound_transparent);
+    vc->f.tfo_accept = server.tfo_queue_length > 0;
     vc->mutex = new_ProxyMutex();
     vc->action_ = *action_;
     SET_CONTINUATION_HANDLER(vc, (NetVConnHandler) & UnixNetVConnection::acceptEvent);
@@ -461,6 +463,7 @@ NetAccept::acceptFastEvent(int event, void *ep)
     vc->submit_time = ink_get_hrtime();
     ats_ip_copy(&vc->server_addr, &vc->con.addr);
     vc->set_is_transparent(server.f_inbound_transparent);
+    vc->f.tfo_accept = server.tfo_queue_length > 0;
     vc->mutex = new_ProxyMutex();
     vc->thread = e->ethread;
 
@@ -46,6 +46,7 @@ NetProcessor::AcceptOptions::reset()
   packet_mark = 0;
   packet_tos = 0;
   f_inbound_transparent = false;
+  tfo_queue_length = 0;
   return *this;
 }
 
@@ -128,6 +129,7 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
   REC_ReadConfigInteger(should_filter_int, "proxy.config.net.defer_accept");
   if (should_filter_int > 0 && opt.etype == ET_NET)
     na->server.http_accept_filter = true;
+  na->server.tfo_queue_length = opt.tfo_queue_length;
 
   na->action_ = new NetAcceptAction();
   *na->action_ = cont;
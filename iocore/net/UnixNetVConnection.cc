@@ -88,6 +88,31 @@ net_activity(UnixNetVConnection *vc, EThread *thread)
 
 }
 
+//
+// Count whether the SYN of a TCP Fast Open connection carried data
+// the peer accepted, which the kernel only tells us after the fact.
+//
+static inline void
+net_tfo_account(UnixNetVConnection *vc)
+{
+#if defined(TCP_INFO) && defined(TCPI_OPT_SYN_DATA)
+  if (vc->f.tfo_accept || vc->f.tfo_connect) {
+    struct tcp_info info;
+    socklen_t info_len = sizeof(info);
+
+    if (getsockopt(vc->con.fd, IPPROTO_TCP, TCP_INFO, &info, &info_len) == 0) {
+      if (info.tcpi_options & TCPI_OPT_SYN_DATA) {
+        NET_SUM_GLOBAL_DYN_STAT(vc->f.tfo_accept ? net_tfo_accepted_stat : net_tfo_connects_stat, 1);
+      } else if (vc->f.tfo_connect) {
+        NET_SUM_GLOBAL_DYN_STAT(net_tfo_fallbacks_stat, 1);
+      }
+    }
+  }
+#else
+  (void) vc;
+#endif
+}
+
 //
 // Function used to close a UnixNetVConnection and free the vc
 //
@@ -97,6 +122,7 @@ close_UnixNetVConnection(UnixNetVConnection *vc, EThread *t)
   NetHandler *nh = vc->nh;
   vc->cancel_OOB();
   vc->ep.stop();
+  net_tfo_account(vc);
   vc->con.close();
 #ifdef INACTIVITY_TIMEOUT
   if (vc->inactivity_timeout) {
@@ -1155,6 +1181,9 @@ UnixNetVConnection::connectUp(EThread *t, int fd)
     if (res != 0) {
       goto fail;
     }
+#ifdef TCP_FASTOPEN_CONNECT
+    f.tfo_connect = (options.sockopt_flags & NetVCOptions::SOCK_OPT_TCP_FAST_OPEN) != 0;
+#endif
   }
 
   check_emergency_throttle(con);
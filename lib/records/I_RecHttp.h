@@ -199,6 +199,8 @@ public:
   bool m_outbound_transparent_p;
   // True if transparent pass-through is enabled on this port.
   bool m_transparent_passthrough;
+  /// TCP Fast Open queue length for the listen socket, 0 if not enabled.
+  int m_tfo_queue_length;
   /// Local address for inbound connections (listen address).
   IpAddr m_inbound_ip;
   /// Local address for outbound connections (to origin server).
@@ -358,6 +360,7 @@ public:
   static char const* const OPT_COMPRESSED; ///< Compressed.
   static char const* const OPT_HOST_RES_PREFIX; ///< Set DNS family preference.
   static char const* const OPT_PROTO_PREFIX; ///< Transport layer protocols.
+  static char const* const OPT_TFO_PREFIX; ///< TCP Fast Open.
 
   static Vec<self>& m_global; ///< Global ("default") data.
 
@@ -112,6 +112,36 @@ int64_t *RecGetGlobalRawStatSumPtr(RecRawStatBlock * rsb, int id);
 int64_t *RecGetGlobalRawStatCountPtr(RecRawStatBlock * rsb, int id);
 
 
+//-------------------------------------------------------------------------
+// Histograms
+//-------------------------------------------------------------------------
+// Log-linear histograms of durations, counted per thread like the raw
+// stats and merged when these are synced. A histogram "name" has the
+// stats "name.count", the number of durations counted, and "name.p50",
+// "name.p90", "name.p99" and "name.p999", the percentiles over about
+// the last minute, in microseconds.
+#define REC_HISTOGRAM_LINEAR_BITS   3   // one bucket per usec below 8us
+#define REC_HISTOGRAM_SUB_BITS      2   // four per power of two above
+#define REC_HISTOGRAM_OCTAVES       24  // up to 2^27us, about two minutes
+#define REC_HISTOGRAM_BUCKETS       ((1 << REC_HISTOGRAM_LINEAR_BITS) + (REC_HISTOGRAM_OCTAVES << REC_HISTOGRAM_SUB_BITS))
+#define REC_HISTOGRAM_PERCENTILES   4
+
+struct RecHistogram
+{
+  off_t ethr_offset;            // thread local buckets
+  RecRawStatBlock *rsb;         // count and percentile stats
+  int64_t *snapshots;           // merged buckets at the start of each part of the window
+  int slot;
+  ink_hrtime slot_start;
+  int64_t count;
+  int64_t percentiles[REC_HISTOGRAM_PERCENTILES];
+  RecHistogram *next;
+};
+
+RecHistogram *RecAllocateHistogram(const char *name);
+inline void RecIncrHistogram(RecHistogram * h, EThread * ethread, ink_hrtime duration);
+
+
 //-------------------------------------------------------------------------
 // RecIncrRawStatXXX
 //-------------------------------------------------------------------------
@@ -161,4 +191,31 @@ RecIncrRawStatCount(RecRawStatBlock * rsb, EThread * ethread, int id, int64_t in
   return REC_ERR_OKAY;
 }
 
+//-------------------------------------------------------------------------
+// RecIncrHistogram
+//-------------------------------------------------------------------------
+inline int
+rec_histogram_bucket(int64_t usec)
+{
+  if (usec < (1 << REC_HISTOGRAM_LINEAR_BITS))
+    return usec < 0 ? 0 : (int) usec;
+
+  int e = 63 - __builtin_clzll(usec);
+  int b = (1 << REC_HISTOGRAM_LINEAR_BITS) + ((e - REC_HISTOGRAM_LINEAR_BITS) << REC_HISTOGRAM_SUB_BITS) +
+    (int) ((usec >> (e - REC_HISTOGRAM_SUB_BITS)) & ((1 << REC_HISTOGRAM_SUB_BITS) - 1));
+  return b < REC_HISTOGRAM_BUCKETS ? b : REC_HISTOGRAM_BUCKETS - 1;
+}
+
+inline void
+RecIncrHistogram(RecHistogram * h, EThread * ethread, ink_hrtime duration)
+{
+  if (h == NULL)
+    return;
+  if (ethread == NULL) {
+    ethread = this_ethread();
+  }
+  int64_t *buckets = (int64_t *) ((char *) (ethread) + h->ethr_offset);
+  buckets[rec_histogram_bucket(duration / HRTIME_USECOND)]++;
+}
+
 #endif /* !_I_REC_PROCESS_H_ */
@@ -0,0 +1,246 @@
+/** @file
+
+  Shared memory stats segment
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef _I_REC_SHM_H_
+#define _I_REC_SHM_H_
+
+#include "ink_platform.h"
+#include "ink_align.h"
+#include "I_RecDefs.h"
+
+//-------------------------------------------------------------------------
+// Each process publishes the stats it owns into a file in the runtime
+// directory, which other processes mmap() and read without talking to
+// the publisher. The segment is a fixed size array of entries plus an
+// open addressing hash index on the record names. Entries are only ever
+// appended, and every entry value is protected by a seqlock, so readers
+// never block the publisher.
+//
+// A publisher that restarts creates a new file and renames it into
+// place, readers notice the new inode and remap.
+//-------------------------------------------------------------------------
+
+#define REC_SHM_MAGIC           0x52454353      // "RECS"
+#define REC_SHM_VERSION         1
+
+#define REC_SHM_NAME_LEN        128
+#define REC_SHM_STRING_LEN      256
+
+#define REC_SHM_PROCESS_FILE    "records_process.shm"
+#define REC_SHM_MANAGER_FILE    "records_manager.shm"
+
+// Entry flags
+#define REC_SHM_TRUNCATED       0x01    // string value didn't fit, ask the owner
+
+#define REC_SHM_BARRIER()       __sync_synchronize()
+
+struct RecShmEntry
+{
+  volatile uint32_t seq;        // seqlock, odd while the value is being updated
+  uint8_t rec_type;             // RecT
+  uint8_t data_type;            // RecDataT
+  uint8_t persist_type;         // RecPersistT
+  uint8_t flags;
+  char name[REC_SHM_NAME_LEN];
+  union
+  {
+    RecInt rec_int;
+    RecFloat rec_float;
+    RecCounter rec_counter;
+    char rec_string[REC_SHM_STRING_LEN];
+  } data;
+};
+
+struct RecShmHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entry_size;          // sizeof(RecShmEntry), a sanity check
+  uint32_t max_entries;
+  uint32_t hash_size;           // number of hash slots, a power of 2
+  volatile uint32_t num_entries;
+  int32_t pid;                  // the publisher
+  volatile uint32_t last_update; // wall clock seconds of the last publish
+
+  // An array of hash_size entry indexes (+1, 0 is an empty slot) follows,
+  // followed by the array of max_entries entries.
+  volatile uint32_t *hash() { return (uint32_t *) (this + 1); }
+  RecShmEntry *entries() { return (RecShmEntry *) ((char *) (this + 1) + INK_ALIGN_DEFAULT(hash_size * sizeof(uint32_t))); }
+
+  static size_t segment_size(uint32_t max_entries, uint32_t hash_size)
+  {
+    return sizeof(RecShmHeader) + INK_ALIGN_DEFAULT(hash_size * sizeof(uint32_t)) + max_entries * sizeof(RecShmEntry);
+  }
+};
+
+static inline uint32_t
+rec_shm_hash(const char *name)
+{
+  uint32_t hval = (uint32_t)0x811c9dc5; /* FNV1_32_INIT */
+
+  while (*name) {
+    hval ^= (uint32_t)*name++;
+    hval *= (uint32_t)0x01000193;  /* FNV_32_PRIME */
+  }
+
+  return hval;
+}
+
+//-------------------------------------------------------------------------
+// RecShmReader
+//
+// Read-only view of a segment. open() can be called repeatedly, it only
+// remaps the file when the publisher recreated it.
+//-------------------------------------------------------------------------
+class RecShmReader
+{
+public:
+  RecShmReader()
+    : m_header(NULL), m_size(0), m_ino(0)
+  { }
+
+  ~RecShmReader() { close(); }
+
+  bool
+  open(const char *path)
+  {
+    struct stat st;
+    int fd;
+
+    if (stat(path, &st) < 0) {
+      close();
+      return false;
+    }
+    if (m_header && (st.st_ino == m_ino))
+      return alive();
+
+    close();
+    if ((size_t)st.st_size < sizeof(RecShmHeader) || (fd = ::open(path, O_RDONLY)) < 0)
+      return false;
+
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (MAP_FAILED == addr)
+      return false;
+
+    m_header = (RecShmHeader *)addr;
+    m_size = st.st_size;
+    m_ino = st.st_ino;
+    if ((m_header->magic != REC_SHM_MAGIC) || (m_header->version != REC_SHM_VERSION) ||
+        (m_header->entry_size != sizeof(RecShmEntry)) ||
+        (RecShmHeader::segment_size(m_header->max_entries, m_header->hash_size) > m_size)) {
+      close();
+      return false;
+    }
+
+    return alive();
+  }
+
+  void
+  close()
+  {
+    if (m_header) {
+      munmap((void *)m_header, m_size);
+      m_header = NULL;
+      m_size = 0;
+      m_ino = 0;
+    }
+  }
+
+  // Is the publisher still around? If not, the values are stale.
+  bool
+  alive() const
+  {
+    return m_header && ((kill(m_header->pid, 0) == 0) || (EPERM == errno));
+  }
+
+  uint32_t
+  count() const
+  {
+    if (!m_header)
+      return 0;
+    return (m_header->num_entries < m_header->max_entries) ? m_header->num_entries : m_header->max_entries;
+  }
+
+  const RecShmEntry *
+  entry(uint32_t i) const
+  {
+    return m_header->entries() + i;
+  }
+
+  const RecShmEntry *
+  find(const char *name) const
+  {
+    uint32_t mask, slot, idx;
+
+    if (!m_header)
+      return NULL;
+
+    mask = m_header->hash_size - 1;
+    slot = rec_shm_hash(name) & mask;
+    for (uint32_t probe = 0; probe <= mask; ++probe, slot = (slot + 1) & mask) {
+      if (0 == (idx = m_header->hash()[slot]))
+        return NULL;
+      if ((idx <= m_header->max_entries) && (0 == strncmp(entry(idx - 1)->name, name, REC_SHM_NAME_LEN)))
+        return entry(idx - 1);
+    }
+
+    return NULL;
+  }
+
+  // Take a consistent copy of the entry's value, returns false if the
+  // publisher kept updating it for all our attempts.
+  static bool
+  read(const RecShmEntry * e, RecShmEntry * copy)
+  {
+    for (int tries = 0; tries < 1000; ++tries) {
+      uint32_t seq = e->seq;
+
+      if (seq & 1)
+        continue;
+      REC_SHM_BARRIER();
+      memcpy(copy, (const void *)e, sizeof(RecShmEntry));
+      REC_SHM_BARRIER();
+      if (seq == e->seq) {
+        copy->data.rec_string[REC_SHM_STRING_LEN - 1] = '\0';
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+private:
+  RecShmHeader *m_header;
+  size_t m_size;
+  ino_t m_ino;
+};
+
+//-------------------------------------------------------------------------
+// Publisher / consumer, see RecShm.cc
+//-------------------------------------------------------------------------
+int RecShmInit(const char *filename);
+int RecShmPublish(bool clear_sync);
+int RecShmConsume(const char *filename);
+
+#endif
@@ -106,6 +106,7 @@ char const* const HttpProxyPort::OPT_OUTBOUND_IP_PREFIX = "ip-out";
 char const* const HttpProxyPort::OPT_INBOUND_IP_PREFIX = "ip-in";
 char const* const HttpProxyPort::OPT_HOST_RES_PREFIX = "ip-resolve";
 char const* const HttpProxyPort::OPT_PROTO_PREFIX = "proto";
+char const* const HttpProxyPort::OPT_TFO_PREFIX = "tfo";
 
 char const* const HttpProxyPort::OPT_IPV6 = "ipv6";
 char const* const HttpProxyPort::OPT_IPV4 = "ipv4";
@@ -126,6 +127,10 @@ namespace {
   size_t const OPT_INBOUND_IP_PREFIX_LEN = strlen(HttpProxyPort::OPT_INBOUND_IP_PREFIX);
   size_t const OPT_HOST_RES_PREFIX_LEN = strlen(HttpProxyPort::OPT_HOST_RES_PREFIX);
   size_t const OPT_PROTO_PREFIX_LEN = strlen(HttpProxyPort::OPT_PROTO_PREFIX);
+  size_t const OPT_TFO_PREFIX_LEN = strlen(HttpProxyPort::OPT_TFO_PREFIX);
+
+  // TCP Fast Open queue length if the tfo option has no value.
+  int const TFO_DEFAULT_QUEUE_LENGTH = 1024;
 }
 
 namespace {
@@ -146,6 +151,7 @@ HttpProxyPort::HttpProxyPort()
   , m_inbound_transparent_p(false)
   , m_outbound_transparent_p(false)
   , m_transparent_passthrough(false)
+  , m_tfo_queue_length(0)
 {
   memcpy(m_host_res_preference, host_res_default_preference_order, sizeof(m_host_res_preference));
 }
@@ -338,6 +344,16 @@ HttpProxyPort::processOptions(char const* opts) {
     } else if (0 != (value = this->checkPrefix(item, OPT_PROTO_PREFIX, OPT_PROTO_PREFIX_LEN))) {
       this->processSessionProtocolPreference(value);
       sp_set_p = true;
+    } else if (0 != (value = this->checkPrefix(item, OPT_TFO_PREFIX, OPT_TFO_PREFIX_LEN))) {
+      char* ptr; // tmp for syntax check.
+      int qlen = strtoul(value, &ptr, 10);
+      if ('\0' == *value) {
+        m_tfo_queue_length = TFO_DEFAULT_QUEUE_LENGTH;
+      } else if (ptr == value || '\0' != *ptr || qlen <= 0) {
+        Warning("Mangled TCP Fast Open queue length '%s' in port descriptor '%s'", item, opts);
+      } else {
+        m_tfo_queue_length = qlen;
+      }
     } else {
       Warning("Invalid option '%s' in proxy port configuration '%s'", item, opts);
     }
@@ -498,6 +514,9 @@ HttpProxyPort::print(char* out, size_t n) {
   if (m_transparent_passthrough)
     zret += snprintf(out+zret, n-zret, ":%s", OPT_TRANSPARENT_PASSTHROUGH);
 
+  if (m_tfo_queue_length > 0)
+    zret += snprintf(out+zret, n-zret, ":%s=%d", OPT_TFO_PREFIX, m_tfo_queue_length);
+
   /* Don't print the IP resolution preferences if the port is outbound
    * transparent (which means the preference order is forced) or if
    * the order is the same as the default.
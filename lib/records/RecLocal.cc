@@ -29,6 +29,7 @@
 #include "P_RecMessage.h"
 #include "P_RecUtils.h"
 #include "P_RecFile.h"
+#include "I_RecShm.h"
 #include "LocalManager.h"
 #include "FileManager.h"
 
@@ -70,7 +71,9 @@ sync_thr(void * data)
   bool written;
 
   while (1) {
+    RecShmConsume(REC_SHM_PROCESS_FILE);
     send_push_message();
+    RecShmPublish(false);
     RecSyncStatsFile();
     if (RecSyncConfigToTB(tb, &inc_version) == REC_ERR_OKAY) {
       written = false;
@@ -186,6 +189,10 @@ RecLocalInitMessage()
 int
 RecLocalStart(FileManager * configFiles)
 {
+  if (RecShmInit(REC_SHM_MANAGER_FILE) != REC_ERR_OKAY) {
+    RecLog(DL_Warning, "unable to create the shared memory stats segment");
+  }
+
   ink_thread_create(sync_thr, configFiles);
   ink_thread_create(config_update_thr, NULL);
 
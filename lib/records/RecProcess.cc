@@ -31,6 +31,7 @@
 #include "P_RecMessage.h"
 #include "P_RecUtils.h"
 #include "P_RecFile.h"
+#include "I_RecShm.h"
 
 #include "mgmtapi.h"
 #include "ProcessManager.h"
@@ -338,6 +339,7 @@ struct raw_stat_sync_cont: public Continuation
   int exec_callbacks(int /* event */, Event * /* e */)
   {
     RecExecRawStatSyncCbs();
+    RecShmPublish(true);
     Debug("statsproc", "raw_stat_sync_cont() processed");
 
     return EVENT_CONT;
@@ -493,6 +495,10 @@ RecProcessStart(void)
     return REC_ERR_OKAY;
   }
 
+  if (RecShmInit(REC_SHM_PROCESS_FILE) != REC_ERR_OKAY) {
+    RecLog(DL_Warning, "unable to create the shared memory stats segment");
+  }
+
   Debug("statsproc", "Starting sync continuations:");
   raw_stat_sync_cont *rssc = new raw_stat_sync_cont(new_ProxyMutex());
   Debug("statsproc", "\traw-stat syncer");
@@ -837,6 +843,139 @@ RecGetGlobalRawStatCountPtr(RecRawStatBlock *rsb, int id)
 }
 
 
+//-------------------------------------------------------------------------
+// Histograms
+//-------------------------------------------------------------------------
+// The percentiles are over the window since the oldest of the snapshots
+// taken every REC_HISTOGRAM_SLOT_SECONDS, i.e. over the last 45 to 60s.
+#define REC_HISTOGRAM_SLOTS         4
+#define REC_HISTOGRAM_SLOT_SECONDS  15
+
+static RecHistogram *g_histograms = NULL;
+static const int histogram_permille[REC_HISTOGRAM_PERCENTILES] = { 500, 900, 990, 999 };
+static const char *histogram_names[REC_HISTOGRAM_PERCENTILES] = { "p50", "p90", "p99", "p999" };
+
+// The middle of a bucket, in microseconds
+static int64_t
+histogram_bucket_value(int b)
+{
+  if (b < (1 << REC_HISTOGRAM_LINEAR_BITS))
+    return b;
+
+  int e = REC_HISTOGRAM_LINEAR_BITS + ((b - (1 << REC_HISTOGRAM_LINEAR_BITS)) >> REC_HISTOGRAM_SUB_BITS);
+  int sub = (b - (1 << REC_HISTOGRAM_LINEAR_BITS)) & ((1 << REC_HISTOGRAM_SUB_BITS) - 1);
+  int64_t width = 1LL << (e - REC_HISTOGRAM_SUB_BITS);
+  return ((1LL << REC_HISTOGRAM_SUB_BITS) + sub) * width + width / 2;
+}
+
+static void
+histogram_merge(RecHistogram *h)
+{
+  int64_t totals[REC_HISTOGRAM_BUCKETS];
+  int64_t window[REC_HISTOGRAM_BUCKETS];
+  int64_t *b, *oldest, n = 0;
+  int i, j;
+
+  memset(totals, 0, sizeof(totals));
+  for (i = 0; i < eventProcessor.n_ethreads; i++) {
+    b = (int64_t *) ((char *) (eventProcessor.all_ethreads[i]) + h->ethr_offset);
+    for (j = 0; j < REC_HISTOGRAM_BUCKETS; j++)
+      totals[j] += b[j];
+  }
+  for (i = 0; i < eventProcessor.n_dthreads; i++) {
+    b = (int64_t *) ((char *) (eventProcessor.all_dthreads[i]) + h->ethr_offset);
+    for (j = 0; j < REC_HISTOGRAM_BUCKETS; j++)
+      totals[j] += b[j];
+  }
+
+  ink_hrtime now = ink_get_hrtime();
+  if (now - h->slot_start >= HRTIME_SECONDS(REC_HISTOGRAM_SLOT_SECONDS)) {
+    h->slot = (h->slot + 1) % REC_HISTOGRAM_SLOTS;
+    memcpy(h->snapshots + h->slot * REC_HISTOGRAM_BUCKETS, totals, sizeof(totals));
+    h->slot_start = now;
+  }
+  oldest = h->snapshots + ((h->slot + 1) % REC_HISTOGRAM_SLOTS) * REC_HISTOGRAM_BUCKETS;
+
+  h->count = 0;
+  for (j = 0; j < REC_HISTOGRAM_BUCKETS; j++) {
+    h->count += totals[j];
+    window[j] = totals[j] - oldest[j];
+    n += window[j];
+  }
+
+  for (i = 0; i < REC_HISTOGRAM_PERCENTILES; i++) {
+    int64_t rank = (n * histogram_permille[i] + 999) / 1000;
+    int64_t seen = 0;
+
+    h->percentiles[i] = 0;
+    for (j = 0; n > 0 && j < REC_HISTOGRAM_BUCKETS; j++) {
+      seen += window[j];
+      if (seen >= rank) {
+        h->percentiles[i] = histogram_bucket_value(j);
+        break;
+      }
+    }
+  }
+}
+
+// The count is synced first and merges the buckets for the percentiles
+static int
+histogram_sync(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  RecHistogram *h;
+
+  Debug("stats", "raw sync:histogram for %s", name);
+  for (h = g_histograms; h && h->rsb != rsb; h = h->next);
+  ink_assert(h);
+
+  if (id == 0) {
+    histogram_merge(h);
+    RecDataSetFromInk64(data_type, data, h->count);
+  } else {
+    RecDataSetFromInk64(data_type, data, h->percentiles[id - 1]);
+  }
+
+  return REC_ERR_OKAY;
+}
+
+//-------------------------------------------------------------------------
+// RecAllocateHistogram
+//-------------------------------------------------------------------------
+RecHistogram *
+RecAllocateHistogram(const char *name)
+{
+  char buf[256];
+  off_t ethr_offset;
+  RecRawStatBlock *rsb;
+  RecHistogram *h;
+
+  if ((ethr_offset = eventProcessor.allocate(REC_HISTOGRAM_BUCKETS * sizeof(int64_t))) == -1) {
+    return NULL;
+  }
+  if ((rsb = RecAllocateRawStatBlock(1 + REC_HISTOGRAM_PERCENTILES)) == NULL) {
+    return NULL;
+  }
+
+  h = (RecHistogram *)ats_malloc(sizeof(RecHistogram));
+  memset(h, 0, sizeof(RecHistogram));
+  h->ethr_offset = ethr_offset;
+  h->rsb = rsb;
+  h->snapshots = (int64_t *)ats_malloc(REC_HISTOGRAM_SLOTS * REC_HISTOGRAM_BUCKETS * sizeof(int64_t));
+  memset(h->snapshots, 0, REC_HISTOGRAM_SLOTS * REC_HISTOGRAM_BUCKETS * sizeof(int64_t));
+  h->next = g_histograms;
+  g_histograms = h;
+
+  snprintf(buf, sizeof(buf), "%s.count", name);
+  RecRegisterRawStat(rsb, RECT_PROCESS, buf, RECD_COUNTER, RECP_NON_PERSISTENT, 0, histogram_sync);
+  for (int i = 0; i < REC_HISTOGRAM_PERCENTILES; i++) {
+    snprintf(buf, sizeof(buf), "%s.%s", name, histogram_names[i]);
+    RecRegisterRawStat(rsb, RECT_PROCESS, buf, RECD_INT, RECP_NON_PERSISTENT, i + 1, histogram_sync);
+  }
+
+  return h;
+}
+
+
 //-------------------------------------------------------------------------
 // RecRegisterRawStatSyncCb
 //-------------------------------------------------------------------------
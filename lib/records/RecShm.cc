@@ -0,0 +1,304 @@
+/** @file
+
+  Shared memory stats segment, publisher and consumer
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "libts.h"
+#include "I_Layout.h"
+
+#include "P_RecCore.h"
+#include "P_RecUtils.h"
+#include "I_RecShm.h"
+
+// The segment we publish into, only one per process.
+static RecShmHeader *g_shm = NULL;
+static ink_mutex g_shm_lock;
+
+// Index of each of g_records in the segment, -1 if not published (yet).
+static int *g_shm_index = NULL;
+
+//-------------------------------------------------------------------------
+// RecShmInit
+//-------------------------------------------------------------------------
+int
+RecShmInit(const char *filename)
+{
+  RecInt enabled = 1;
+  uint32_t hash_size = 1;
+  size_t size;
+  int fd;
+
+  if (g_shm) {
+    return REC_ERR_OKAY;
+  }
+
+  ats_scoped_str rundir(RecConfigReadRuntimeDir());
+  ats_scoped_str path(Layout::relative_to(rundir, filename));
+  char tmp_path[PATH_NAME_MAX + 1];
+
+  // Don't leave an old segment around for readers to find.
+  RecGetRecordInt("proxy.config.stats.shm_enabled", &enabled);
+  if (!enabled) {
+    unlink(path);
+    return REC_ERR_OKAY;
+  }
+
+  while (hash_size < 2 * REC_MAX_RECORDS) {
+    hash_size <<= 1;
+  }
+  size = RecShmHeader::segment_size(REC_MAX_RECORDS, hash_size);
+
+  // Build the new segment under a temporary name, and rename it into place
+  // so that readers never see a partially initialized (or truncated) file.
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", (const char *)path);
+  unlink(tmp_path);
+  if ((fd = open(tmp_path, O_RDWR | O_CREAT | O_EXCL, 0644)) < 0) {
+    RecLog(DL_Warning, "could not create stats segment %s: %s", tmp_path, strerror(errno));
+    return REC_ERR_FAIL;
+  }
+  if (ftruncate(fd, size) < 0) {
+    RecLog(DL_Warning, "could not size stats segment %s: %s", tmp_path, strerror(errno));
+    close(fd);
+    unlink(tmp_path);
+    return REC_ERR_FAIL;
+  }
+
+  void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (MAP_FAILED == addr) {
+    RecLog(DL_Warning, "could not map stats segment %s: %s", tmp_path, strerror(errno));
+    unlink(tmp_path);
+    return REC_ERR_FAIL;
+  }
+
+  RecShmHeader *header = (RecShmHeader *)addr;
+  header->magic = REC_SHM_MAGIC;
+  header->version = REC_SHM_VERSION;
+  header->entry_size = sizeof(RecShmEntry);
+  header->max_entries = REC_MAX_RECORDS;
+  header->hash_size = hash_size;
+  header->num_entries = 0;
+  header->pid = getpid();
+  header->last_update = 0;
+
+  if (rename(tmp_path, path) < 0) {
+    RecLog(DL_Warning, "could not rename stats segment to %s: %s", (const char *)path, strerror(errno));
+    munmap(addr, size);
+    unlink(tmp_path);
+    return REC_ERR_FAIL;
+  }
+
+  g_shm_index = (int *)ats_malloc(REC_MAX_RECORDS * sizeof(int));
+  for (int i = 0; i < REC_MAX_RECORDS; i++) {
+    g_shm_index[i] = -1;
+  }
+  ink_mutex_init(&g_shm_lock, "RecShm");
+  g_shm = header;
+
+  RecDebug(DL_Note, "publishing stats in %s [%zu bytes]", (const char *)path, size);
+  return REC_ERR_OKAY;
+}
+
+//-------------------------------------------------------------------------
+// shm_add_entry
+//-------------------------------------------------------------------------
+static int
+shm_add_entry(RecRecord *r)
+{
+  uint32_t idx = g_shm->num_entries;
+  uint32_t mask = g_shm->hash_size - 1;
+  uint32_t slot = rec_shm_hash(r->name) & mask;
+  RecShmEntry *e;
+
+  if ((idx >= g_shm->max_entries) || (strlen(r->name) >= REC_SHM_NAME_LEN)) {
+    return -1;
+  }
+
+  e = g_shm->entries() + idx;
+  e->seq = 0;
+  e->rec_type = r->rec_type;
+  e->data_type = r->data_type;
+  e->persist_type = r->stat_meta.persist_type;
+  e->flags = 0;
+  ink_strlcpy(e->name, r->name, REC_SHM_NAME_LEN);
+
+  // The entry has to be complete before a reader can find it.
+  REC_SHM_BARRIER();
+  while (g_shm->hash()[slot]) {
+    slot = (slot + 1) & mask;
+  }
+  g_shm->hash()[slot] = idx + 1;
+  REC_SHM_BARRIER();
+  g_shm->num_entries = idx + 1;
+
+  return idx;
+}
+
+//-------------------------------------------------------------------------
+// RecShmPublish
+//
+// Copy the values of all the stats we own into the segment. If clear_sync
+// is set, these records no longer need to be pushed to our peer, since it
+// reads them from the segment (see RecShmConsume).
+//-------------------------------------------------------------------------
+int
+RecShmPublish(bool clear_sync)
+{
+  RecRecord *r;
+  RecShmEntry *e;
+  int i, num_records;
+
+  if (!g_shm) {
+    return REC_ERR_OKAY;
+  }
+
+  ink_mutex_acquire(&g_shm_lock);
+  num_records = g_num_records;
+  for (i = 0; i < num_records; i++) {
+    r = &(g_records[i]);
+    if (!REC_TYPE_IS_STAT(r->rec_type) || !i_am_the_record_owner(r->rec_type)) {
+      continue;
+    }
+
+    rec_mutex_acquire(&(r->lock));
+    if ((g_shm_index[i] < 0) && ((g_shm_index[i] = shm_add_entry(r)) < 0)) {
+      g_shm_index[i] = INT_MAX;         // doesn't fit, don't try again
+    }
+    if (g_shm_index[i] != INT_MAX) {
+      e = g_shm->entries() + g_shm_index[i];
+
+      ink_atomic_increment(&e->seq, 1);
+      switch (r->data_type) {
+      case RECD_INT:
+        e->data.rec_int = r->data.rec_int;
+        break;
+      case RECD_FLOAT:
+        e->data.rec_float = r->data.rec_float;
+        break;
+      case RECD_COUNTER:
+        e->data.rec_counter = r->data.rec_counter;
+        break;
+      case RECD_STRING:
+        if (r->data.rec_string && (strlen(r->data.rec_string) >= REC_SHM_STRING_LEN)) {
+          e->flags |= REC_SHM_TRUNCATED;
+        } else {
+          e->flags &= ~REC_SHM_TRUNCATED;
+        }
+        ink_strlcpy(e->data.rec_string, r->data.rec_string ? r->data.rec_string : "", REC_SHM_STRING_LEN);
+        break;
+      default:
+        break;
+      }
+      ink_atomic_increment(&e->seq, 1);
+
+      if (clear_sync && !(e->flags & REC_SHM_TRUNCATED)) {
+        r->sync_required &= ~REC_PEER_SYNC_REQUIRED;
+      }
+    }
+    rec_mutex_release(&(r->lock));
+  }
+  g_shm->last_update = (uint32_t)time(NULL);
+  ink_mutex_release(&g_shm_lock);
+
+  return REC_ERR_OKAY;
+}
+
+//-------------------------------------------------------------------------
+// RecShmConsume
+//
+// Update our copies of the stats our peer publishes. Records we don't
+// know yet are created the same way a RECG_PUSH would create them.
+//-------------------------------------------------------------------------
+int
+RecShmConsume(const char *filename)
+{
+  static RecShmReader reader;
+  static RecRecord **records = NULL;
+  static ino_t records_ino = 0;
+  RecShmEntry copy;
+  RecData data;
+  RecRecord *r;
+  uint32_t i, count;
+
+  ats_scoped_str rundir(RecConfigReadRuntimeDir());
+  ats_scoped_str path(Layout::relative_to(rundir, filename));
+  struct stat st;
+
+  if (!reader.open(path) || (stat(path, &st) < 0)) {
+    return REC_ERR_FAIL;
+  }
+
+  // A new segment means the entry indexes changed.
+  if (!records || (records_ino != st.st_ino)) {
+    ats_free(records);
+    records = (RecRecord **)ats_malloc(REC_MAX_RECORDS * sizeof(RecRecord *));
+    memset(records, 0, REC_MAX_RECORDS * sizeof(RecRecord *));
+    records_ino = st.st_ino;
+  }
+
+  count = reader.count();
+  if (count > REC_MAX_RECORDS) {
+    count = REC_MAX_RECORDS;
+  }
+
+  for (i = 0; i < count; i++) {
+    if (!RecShmReader::read(reader.entry(i), &copy) || (copy.flags & REC_SHM_TRUNCATED)) {
+      continue;
+    }
+
+    memset(&data, 0, sizeof(data));
+    switch (copy.data_type) {
+    case RECD_INT:
+      data.rec_int = copy.data.rec_int;
+      break;
+    case RECD_FLOAT:
+      data.rec_float = copy.data.rec_float;
+      break;
+    case RECD_COUNTER:
+      data.rec_counter = copy.data.rec_counter;
+      break;
+    case RECD_STRING:
+      data.rec_string = copy.data.rec_string;
+      break;
+    default:
+      continue;
+    }
+
+    if ((r = records[i]) != NULL) {
+      rec_mutex_acquire(&(r->lock));
+      RecDataSet(r->data_type, &(r->data), &data);
+      rec_mutex_release(&(r->lock));
+    } else {
+      RecRecord tmp;
+
+      memset(&tmp, 0, sizeof(tmp));
+      tmp.rec_type = (RecT)copy.rec_type;
+      tmp.name = copy.name;
+      tmp.data_type = (RecDataT)copy.data_type;
+      tmp.data = data;
+      tmp.registered = true;
+      tmp.stat_meta.persist_type = (RecPersistT)copy.persist_type;
+      records[i] = RecForceInsert(&tmp);
+    }
+  }
+
+  return REC_ERR_OKAY;
+}
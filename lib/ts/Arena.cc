@@ -129,16 +129,14 @@ Arena::alloc(size_t size, size_t alignment)
 void
 Arena::free(void *mem, size_t size)
 {
-  if (m_blocks) {
-    ArenaBlock *b;
-
-    b = m_blocks;
-    while (b->next) {
-      b = b->next;
-    }
+  ArenaBlock *b;
 
+  // Only the most recent allocation in a block can be given back, and
+  // that can be in any block once more than one is in use.
+  for (b = m_blocks; b; b = b->next) {
     if (b->m_water_level == ((char *) mem + size)) {
       b->m_water_level = (char *) mem;
+      return;
     }
   }
 }
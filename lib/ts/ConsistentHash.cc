@@ -20,6 +20,8 @@
  */
 
 #include "ConsistentHash.h"
+#include "ink_atomic.h"
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <sstream>
@@ -33,7 +35,8 @@ operator << (std::ostream & os, ATSConsistentHashNode & thing)
   return os << thing.name;
 }
 
-ATSConsistentHash::ATSConsistentHash(int r, ATSHash64 *h) : replicas(r), hash(h)
+ATSConsistentHash::ATSConsistentHash(int r, ATSHash64 *h)
+  : replicas(r), hash(h), load_factor(0), total_load(0)
 {
 }
 
@@ -45,6 +48,7 @@ ATSConsistentHash::insert(ATSConsistentHashNode * node, float weight, ATSHash64
   ATSHash64 *thash;
   std::ostringstream string_stream;
   std::string std_string;
+  std::vector<uint64_t> node_points;
 
   if (h) {
     thash = h;
@@ -62,18 +66,117 @@ ATSConsistentHash::insert(ATSConsistentHashNode * node, float weight, ATSHash64
     thash->update(numstr, strlen(numstr));
     thash->update(std_string.c_str(), strlen(std_string.c_str()));
     thash->final();
-    NodeMap.insert(std::pair<uint64_t, ATSConsistentHashNode *>(thash->get(), node));
+    node_points.push_back(thash->get());
     thash->clear();
   }
+
+  if (node_points.empty()) {
+    return;
+  }
+
+  // Merge the node's points into the ring, a point already taken by an
+  // earlier node stays with it.
+  std::sort(node_points.begin(), node_points.end());
+
+  uint32_t slot = slots.size();
+  std::vector<uint64_t> merged_points;
+  std::vector<uint32_t> merged_owners;
+  size_t a = 0, b = 0;
+  int added = 0;
+
+  merged_points.reserve(points.size() + node_points.size());
+  merged_owners.reserve(points.size() + node_points.size());
+  while (a < points.size() || b < node_points.size()) {
+    if (b == node_points.size() || (a < points.size() && points[a] <= node_points[b])) {
+      if (b < node_points.size() && points[a] == node_points[b]) {
+        ++b;
+        continue;
+      }
+      merged_points.push_back(points[a]);
+      merged_owners.push_back(owners[a]);
+      ++a;
+    } else {
+      if (!merged_points.empty() && merged_points.back() == node_points[b]) {
+        ++b;
+        continue;
+      }
+      merged_points.push_back(node_points[b]);
+      merged_owners.push_back(slot);
+      ++added;
+      ++b;
+    }
+  }
+
+  points.swap(merged_points);
+  owners.swap(merged_owners);
+
+  Slot s = { node, added, 0 };
+  slots.push_back(s);
+}
+
+uint64_t
+ATSConsistentHash::hash_url(const char *url, ATSHash64 *thash)
+{
+  uint64_t url_hash;
+
+  thash->update(url, strlen(url));
+  thash->final();
+  url_hash = thash->get();
+  thash->clear();
+
+  return url_hash;
+}
+
+// Index of the first point at or after url_hash, points.size() if there
+// is none.
+size_t
+ATSConsistentHash::find(uint64_t url_hash)
+{
+  return std::lower_bound(points.begin(), points.end(), url_hash) - points.begin();
+}
+
+// Starting at pos, the first point whose node is still within its bound.
+// The counts are updated without a lock, they only need to be roughly
+// right, and are halved every few lookups per node so the bound follows
+// the recent traffic.
+size_t
+ATSConsistentHash::bound(size_t pos, bool *wrapped)
+{
+  size_t n = points.size();
+  double limit = load_factor * (double) (total_load + 1) / n;
+
+  for (size_t k = 0; k < n; ++k) {
+    Slot & s = slots[owners[pos]];
+
+    if (s.load < (int64_t) ceil(limit * s.points)) {
+      break;
+    }
+    if (++pos == n) {
+      *wrapped = true;
+      pos = 0;
+    }
+  }
+
+  int64_t window = (int64_t) slots.size() * CONSISTENT_HASH_LOAD_WINDOW;
+
+  ink_atomic_increment(&slots[owners[pos]].load, (int64_t) 1);
+  if (ink_atomic_increment(&total_load, (int64_t) 1) + 1 == window) {
+    for (size_t j = 0; j < slots.size(); ++j) {
+      ink_atomic_increment(&slots[j].load, -(slots[j].load / 2));
+    }
+    ink_atomic_increment(&total_load, -(window / 2));
+  }
+
+  return pos;
 }
 
 ATSConsistentHashNode *
 ATSConsistentHash::lookup(const char *url, ATSConsistentHashIter *i, bool *w, ATSHash64 *h)
 {
-  uint64_t url_hash;
   ATSConsistentHashIter NodeMapIterUp, *iter;
   ATSHash64 *thash;
   bool *wptr, wrapped = false;
+  size_t n = points.size();
 
   if (h) {
     thash = h;
@@ -95,42 +198,44 @@ ATSConsistentHash::lookup(const char *url, ATSConsistentHashIter *i, bool *w, AT
     iter = &NodeMapIterUp;
   }
 
-  if (url) {
-    thash->update(url, strlen(url));
-    thash->final();
-    url_hash = thash->get();
-    thash->clear();
+  if (n == 0) {
+    return NULL;
+  }
 
-    *iter = NodeMap.lower_bound(url_hash);
+  if (url) {
+    *iter = find(hash_url(url, thash));
 
-    if (*iter == NodeMap.end()) {
+    if (*iter == n) {
       *wptr = true;
-      *iter = NodeMap.begin();
+      *iter = 0;
     }
 
+    if (load_factor > 0) {
+      *iter = bound(*iter, wptr);
+    }
   } else {
     (*iter)++;
   }
 
-  if (!(*wptr) && *iter == NodeMap.end()) {
+  if (!(*wptr) && *iter >= n) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    *iter = 0;
   }
 
-  if (*wptr && *iter == NodeMap.end()) {
+  if (*wptr && *iter >= n) {
     return NULL;
   }
 
-  return (*iter)->second;
+  return slots[owners[*iter]].node;
 }
 
 ATSConsistentHashNode *
 ATSConsistentHash::lookup_available(const char *url, ATSConsistentHashIter *i, bool *w, ATSHash64 *h)
 {
-  uint64_t url_hash;
   ATSConsistentHashIter NodeMapIterUp, *iter;
   ATSHash64 *thash;
   bool *wptr, wrapped = false;
+  size_t n = points.size();
 
   if (h) {
     thash = h;
@@ -152,32 +257,35 @@ ATSConsistentHash::lookup_available(const char *url, ATSConsistentHashIter *i, b
     iter = &NodeMapIterUp;
   }
 
-  if (url) {
-    thash->update(url, strlen(url));
-    thash->final();
-    url_hash = thash->get();
-    thash->clear();
+  if (n == 0) {
+    return NULL;
+  }
 
-    *iter = NodeMap.lower_bound(url_hash);
+  if (url) {
+    *iter = find(hash_url(url, thash));
   }
 
-  if (*iter == NodeMap.end()) {
+  if (*iter >= n) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    *iter = 0;
+  }
+
+  if (url && load_factor > 0) {
+    *iter = bound(*iter, wptr);
   }
 
-  while (!(*iter)->second->available) {
+  while (!slots[owners[*iter]].node->available) {
     (*iter)++;
 
-    if (!(*wptr) && *iter == NodeMap.end()) {
+    if (!(*wptr) && *iter == n) {
       *wptr = true;
-      *iter = NodeMap.begin();
-    } else if (*wptr && *iter == NodeMap.end()) {
+      *iter = 0;
+    } else if (*wptr && *iter == n) {
       return NULL;
     }
   }
 
-  return (*iter)->second;
+  return slots[owners[*iter]].node;
 }
 
 ATSConsistentHash::~ATSConsistentHash()
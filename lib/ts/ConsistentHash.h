@@ -25,7 +25,7 @@
 #include "Hash.h"
 #include <stdint.h>
 #include <iostream>
-#include <map>
+#include <vector>
 
 /*
   Helper class to be extended to make ring nodes.
@@ -40,12 +40,27 @@ struct ATSConsistentHashNode
 std::ostream &
 operator<< (std::ostream & os, ATSConsistentHashNode & thing);
 
-typedef std::map<uint64_t, ATSConsistentHashNode *>::iterator ATSConsistentHashIter;
+// Lookups per node after which the bounded load counts are halved.
+#define CONSISTENT_HASH_LOAD_WINDOW 1024
+
+// Position on the ring, an index into the sorted points.
+typedef size_t ATSConsistentHashIter;
 
 /*
   TSConsistentHash requires a TSHash64 object
 
   Caller is responsible for freeing ring node memory.
+
+  The ring is kept as a sorted array of point hashes with the owning node
+  of each point in a parallel array, so a lookup is a binary search over
+  contiguous memory and stepping to the next point on failover is an
+  increment. Nodes are expected to be inserted up front, lookups may then
+  run concurrently.
+
+  With a load factor c >= 1 a url lookup skips points whose node has
+  already been given more than c times its weighted share of the recent
+  lookups (consistent hashing with bounded loads), so a popular url range
+  cannot pile onto one node. Zero, the default, disables this.
  */
 
 struct ATSConsistentHash
@@ -54,12 +69,28 @@ struct ATSConsistentHash
   void insert(ATSConsistentHashNode *node, float weight = 1.0, ATSHash64 *h = NULL);
   ATSConsistentHashNode *lookup(const char *url = NULL, ATSConsistentHashIter *i = NULL, bool *w = NULL, ATSHash64 *h = NULL);
   ATSConsistentHashNode *lookup_available(const char *url = NULL, ATSConsistentHashIter *i = NULL, bool *w = NULL, ATSHash64 *h = NULL);
+  void set_load_factor(float c) { load_factor = (c > 0 && c < 1) ? 1 : c; }
   ~ATSConsistentHash();
 
 private:
+  struct Slot
+  {
+    ATSConsistentHashNode *node;
+    int points;
+    int64_t load;
+  };
+
+  uint64_t hash_url(const char *url, ATSHash64 *h);
+  size_t find(uint64_t url_hash);
+  size_t bound(size_t pos, bool *wrapped);
+
   int replicas;
   ATSHash64 *hash;
-  std::map<uint64_t, ATSConsistentHashNode *> NodeMap;
+  float load_factor;
+  int64_t total_load;
+  std::vector<uint64_t> points;     // sorted point hashes
+  std::vector<uint32_t> owners;     // slot of each point
+  std::vector<Slot> slots;
 };
 
 #endif
@@ -0,0 +1,158 @@
+/** @file
+
+  MurmurHash3 support class.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/**
+
+Algorithm Info:
+https://github.com/aappleby/smhasher/wiki/MurmurHash3
+
+Based off of the public domain reference MurmurHash3_x64_128().
+
+ */
+
+#include "HashMurmur3.h"
+#include <cstring>
+
+#define MURMUR3_BLOCK_SIZE 16
+
+#define ROTL64(a,b) (((a)<<(b))|((a)>>(64-b)))
+
+static const uint64_t C1 = 0x87c37b91114253d5ULL;
+static const uint64_t C2 = 0x4cf5ad432745937fULL;
+
+static inline uint64_t
+fmix64(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+static inline void
+murmur3_block(uint64_t &h1, uint64_t &h2, const uint8_t *p)
+{
+  uint64_t k1, k2;
+
+  memcpy(&k1, p, 8);
+  memcpy(&k2, p + 8, 8);
+
+  k1 *= C1;
+  k1 = ROTL64(k1, 31);
+  k1 *= C2;
+  h1 ^= k1;
+
+  h1 = ROTL64(h1, 27);
+  h1 += h2;
+  h1 = h1 * 5 + 0x52dce729;
+
+  k2 *= C2;
+  k2 = ROTL64(k2, 33);
+  k2 *= C1;
+  h2 ^= k2;
+
+  h2 = ROTL64(h2, 31);
+  h2 += h1;
+  h2 = h2 * 5 + 0x38495ab5;
+}
+
+Murmur3Context::Murmur3Context(uint64_t seed)
+  : _h1(seed), _h2(seed), _total_len(0), _tail_len(0)
+{
+}
+
+bool
+Murmur3Context::update(void const* data, int length)
+{
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+
+  _total_len += length;
+
+  if (_tail_len) {
+    int n = MURMUR3_BLOCK_SIZE - _tail_len;
+
+    if (length < n) {
+      memcpy(_tail + _tail_len, p, length);
+      _tail_len += length;
+      return true;
+    }
+    memcpy(_tail + _tail_len, p, n);
+    murmur3_block(_h1, _h2, _tail);
+    _tail_len = 0;
+    p += n;
+    length -= n;
+  }
+
+  for (; length >= MURMUR3_BLOCK_SIZE; p += MURMUR3_BLOCK_SIZE, length -= MURMUR3_BLOCK_SIZE) {
+    murmur3_block(_h1, _h2, p);
+  }
+
+  memcpy(_tail, p, length);
+  _tail_len = length;
+  return true;
+}
+
+bool
+Murmur3Context::finalize(CryptoHash& hash)
+{
+  uint64_t h1 = _h1, h2 = _h2;
+  uint64_t k1 = 0, k2 = 0;
+
+  for (int i = _tail_len - 1; i >= 8; --i) {
+    k2 = (k2 << 8) | _tail[i];
+  }
+  if (_tail_len > 8) {
+    k2 *= C2;
+    k2 = ROTL64(k2, 33);
+    k2 *= C1;
+    h2 ^= k2;
+  }
+
+  for (int i = (_tail_len > 8 ? 8 : _tail_len) - 1; i >= 0; --i) {
+    k1 = (k1 << 8) | _tail[i];
+  }
+  if (_tail_len > 0) {
+    k1 *= C1;
+    k1 = ROTL64(k1, 31);
+    k1 *= C2;
+    h1 ^= k1;
+  }
+
+  h1 ^= _total_len;
+  h2 ^= _total_len;
+
+  h1 += h2;
+  h2 += h1;
+
+  h1 = fmix64(h1);
+  h2 = fmix64(h2);
+
+  h1 += h2;
+  h2 += h1;
+
+  hash.u64[0] = h1;
+  hash.u64[1] = h2;
+  return true;
+}
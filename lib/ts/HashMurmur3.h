@@ -0,0 +1,56 @@
+/** @file
+
+  MurmurHash3 support class.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __HASH_MURMUR3_H__
+#define __HASH_MURMUR3_H__
+
+#include "ink_code.h"
+#include "ink_defs.h"
+#include "CryptoHash.h"
+
+/**
+  The 128 bit, x64 flavor of MurmurHash3. Not a cryptographic hash,
+  but a good deal cheaper than MD5 or MMH and well enough spread for
+  cache keys. The two 64 bit lanes are independent until the final
+  mix, which keeps the CPU busy.
+
+  Like MMH it returns different values on big-endian and
+  little-endian machines.
+*/
+class Murmur3Context : public CryptoContext
+{
+public:
+  Murmur3Context(uint64_t seed = 0);
+  /// Update the hash with @a data of @a length bytes.
+  virtual bool update(void const* data, int length);
+  /// Finalize and extract the @a hash.
+  virtual bool finalize(CryptoHash& hash);
+
+protected:
+  uint64_t _h1, _h2;
+  uint64_t _total_len;
+  uint8_t _tail[16];
+  int _tail_len;
+};
+
+#endif
@@ -85,6 +85,7 @@
 #include "Hash.h"
 #include "HashFNV.h"
 #include "HashMD5.h"
+#include "HashMurmur3.h"
 #include "HashSip.h"
 #include "I_Version.h"
 #include "InkPool.h"
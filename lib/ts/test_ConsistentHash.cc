@@ -0,0 +1,276 @@
+/** @file
+
+  Test and benchmark for the consistent hash ring.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include "libts.h"
+#include "ConsistentHash.h"
+#include "HashSip.h"
+#include <map>
+
+// A parent tier the size of a large deployment, with mixed weights.
+static const int NODES = 200;
+static const int URLS = 100000;
+
+static ATSConsistentHashNode nodes[NODES + 1];
+static char urls[URLS][32];
+
+static int failures = 0;
+
+#define CHECK(x) do { \
+  if (!(x)) { \
+    printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #x); \
+    ++failures; \
+  } \
+} while (0)
+
+static float
+weight(int i)
+{
+  return 1.0 + (i % 3);
+}
+
+// The ring as it was kept before, a map from point hash to node.
+struct MapRing
+{
+  std::map<uint64_t, ATSConsistentHashNode *> points;
+
+  void
+  insert(ATSConsistentHashNode *node, float w)
+  {
+    ATSHash64Sip24 h;
+    char numstr[256];
+
+    for (int i = 0; i < (int) roundf(1024 * w); i++) {
+      snprintf(numstr, sizeof(numstr), "%d-", i);
+      h.update(numstr, strlen(numstr));
+      h.update(node->name, strlen(node->name));
+      h.final();
+      points.insert(std::make_pair(h.get(), node));
+      h.clear();
+    }
+  }
+
+  ATSConsistentHashNode *
+  lookup(const char *url)
+  {
+    ATSHash64Sip24 h;
+
+    h.update(url, strlen(url));
+    h.final();
+
+    std::map<uint64_t, ATSConsistentHashNode *>::iterator i = points.lower_bound(h.get());
+    if (i == points.end())
+      i = points.begin();
+    return i->second;
+  }
+};
+
+static ATSConsistentHash *
+build(int n)
+{
+  ATSConsistentHash *ring = new ATSConsistentHash(1024, new ATSHash64Sip24);
+
+  for (int i = 0; i < n; ++i)
+    ring->insert(&nodes[i], weight(i));
+  return ring;
+}
+
+static int
+index_of(ATSConsistentHashNode *node)
+{
+  return node ? node - nodes : -1;
+}
+
+// The flat ring picks the same nodes as the map did, and stepping on
+// failover visits every node.
+static void
+test_lookup()
+{
+  ATSConsistentHash *ring = build(NODES);
+  MapRing map;
+
+  for (int i = 0; i < NODES; ++i)
+    map.insert(&nodes[i], weight(i));
+
+  for (int i = 0; i < URLS; ++i)
+    CHECK(ring->lookup(urls[i]) == map.lookup(urls[i]));
+
+  ATSConsistentHashIter iter;
+  bool wrapped = false;
+  bool seen[NODES];
+  int distinct = 0;
+
+  memset(seen, 0, sizeof(seen));
+  for (ATSConsistentHashNode *node = ring->lookup(urls[0], &iter, &wrapped); node; node = ring->lookup(NULL, &iter, &wrapped)) {
+    if (!seen[index_of(node)]) {
+      seen[index_of(node)] = true;
+      ++distinct;
+    }
+  }
+  CHECK(distinct == NODES);
+  CHECK(wrapped);
+
+  nodes[index_of(ring->lookup(urls[0]))].available = false;
+  CHECK(ring->lookup_available(urls[0]) != ring->lookup(urls[0]));
+  CHECK(ring->lookup_available(urls[0])->available);
+  for (int i = 0; i < NODES; ++i)
+    nodes[i].available = true;
+
+  delete ring;
+}
+
+// Adding one node should only move the urls that now hash to it.
+static void
+test_movement()
+{
+  ATSConsistentHash *before = build(NODES);
+  ATSConsistentHash *after = build(NODES + 1);
+  int moved = 0, moved_elsewhere = 0;
+
+  for (int i = 0; i < URLS; ++i) {
+    ATSConsistentHashNode *a = before->lookup(urls[i]);
+    ATSConsistentHashNode *b = after->lookup(urls[i]);
+
+    if (a != b) {
+      ++moved;
+      if (b != &nodes[NODES])
+        ++moved_elsewhere;
+    }
+  }
+
+  printf("key movement adding 1 node to %d: %.2f%% of urls (%d to other nodes)\n", NODES, 100.0 * moved / URLS,
+         moved_elsewhere);
+  CHECK(moved_elsewhere == 0);
+  CHECK(moved < URLS / 50);
+
+  delete before;
+  delete after;
+}
+
+// A skewed mix, a tenth of the requests for a single url, stays within
+// the bound while the plain hash piles them onto one node.
+static void
+test_bounded_load()
+{
+  static const float factor = 1.25;
+  static const int REQUESTS = 200000;
+  ATSConsistentHash *plain = build(NODES);
+  ATSConsistentHash *bounded = build(NODES);
+  int64_t plain_load[NODES], bounded_load[NODES];
+  double total_weight = 0;
+  double plain_worst = 0, bounded_worst = 0;
+  int same = 0;
+
+  bounded->set_load_factor(factor);
+  memset(plain_load, 0, sizeof(plain_load));
+  memset(bounded_load, 0, sizeof(bounded_load));
+
+  for (int i = 0; i < NODES; ++i)
+    total_weight += weight(i);
+
+  for (int r = 0; r < REQUESTS; ++r) {
+    const char *url = (r % 10 == 0) ? urls[0] : urls[r % URLS];
+    ATSConsistentHashNode *p = plain->lookup(url);
+    ATSConsistentHashNode *b = bounded->lookup(url);
+
+    ++plain_load[index_of(p)];
+    ++bounded_load[index_of(b)];
+    if (p == b)
+      ++same;
+  }
+
+  for (int i = 0; i < NODES; ++i) {
+    double share = REQUESTS * weight(i) / total_weight;
+
+    plain_worst = std::max(plain_worst, plain_load[i] / share);
+    bounded_worst = std::max(bounded_worst, bounded_load[i] / share);
+  }
+
+  printf("busiest node at load factor %.2f: %.2fx its share (%.2fx unbounded), %.1f%% of requests on the hashed node\n",
+         factor, bounded_worst, plain_worst, 100.0 * same / REQUESTS);
+  CHECK(plain_worst > 2 * factor);
+  CHECK(bounded_worst < factor + 0.1);
+
+  delete plain;
+  delete bounded;
+}
+
+static void
+bench_lookup()
+{
+  static const int ROUNDS = 10;
+  ATSConsistentHash *ring = build(NODES);
+  MapRing map;
+  ink_hrtime start;
+  intptr_t sum = 0;
+
+  for (int i = 0; i < NODES; ++i)
+    map.insert(&nodes[i], weight(i));
+
+  start = ink_get_hrtime_internal();
+  for (int r = 0; r < ROUNDS; ++r)
+    for (int i = 0; i < URLS; ++i)
+      sum += (intptr_t) map.lookup(urls[i]);
+  ink_hrtime map_time = ink_get_hrtime_internal() - start;
+
+  start = ink_get_hrtime_internal();
+  for (int r = 0; r < ROUNDS; ++r)
+    for (int i = 0; i < URLS; ++i)
+      sum -= (intptr_t) ring->lookup(urls[i]);
+  ink_hrtime ring_time = ink_get_hrtime_internal() - start;
+
+  printf("lookup over %d points: map %.0f ns, flat ring %.0f ns\n", (int) map.points.size(),
+         (double) map_time / (ROUNDS * URLS), (double) ring_time / (ROUNDS * URLS));
+  CHECK(sum == 0);
+
+  delete ring;
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char ** /* argv ATS_UNUSED */)
+{
+  for (int i = 0; i <= NODES; ++i) {
+    char name[64];
+
+    snprintf(name, sizeof(name), "parent%d.example.com:8080", i);
+    nodes[i].name = ats_strdup(name);
+    nodes[i].available = true;
+  }
+
+  for (int i = 0; i < URLS; ++i)
+    snprintf(urls[i], sizeof(urls[i]), "/obj/%d/%x.jpg", i, i * 2654435761u);
+
+  test_lookup();
+  test_movement();
+  test_bounded_load();
+  bench_lookup();
+
+  for (int i = 0; i <= NODES; ++i)
+    ats_free(nodes[i].name);
+
+  if (failures) {
+    printf("test_ConsistentHash: %d failures\n", failures);
+    return 1;
+  }
+  printf("test_ConsistentHash: all tests passed\n");
+  return 0;
+}
@@ -0,0 +1,158 @@
+/** @file
+
+  Test and benchmark for the 128 bit hashes used for cache keys.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include "libts.h"
+#include "HashMurmur3.h"
+
+static const int URLS = 10000;
+
+static char short_urls[URLS][512];
+static char long_urls[URLS][512];
+
+static int failures = 0;
+
+#define CHECK(x) do { \
+  if (!(x)) { \
+    printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #x); \
+    ++failures; \
+  } \
+} while (0)
+
+// Values from the reference MurmurHash3_x64_128() with a zero seed.
+static void
+test_murmur3_vectors()
+{
+  static const struct
+  {
+    const char *input;
+    uint64_t h1, h2;
+  } vectors[] = {
+    {"", 0, 0},
+    {"a", 0x85555565f6597889ULL, 0xe6b53a48510e895aULL},
+    {"abc", 0xb4963f3f3fad7867ULL, 0x3ba2744126ca2d52ULL},
+    {"0123456789abcdef", 0x4be06d94cf4ad1a7ULL, 0x87c35b5c63a708daULL},
+    {"0123456789abcdefX", 0xcdebd2acb570d6f7ULL, 0x8f72119782104b27ULL},
+    {"The quick brown fox jumps over the lazy dog", 0xe34bbc7bbc071b6cULL, 0x7a433ca9c49a9347ULL},
+    {"http://www.example.com/some/long/path/to/an/object.jpg", 0x655ecdeabcc19105ULL, 0x5d87a3ab6fcb7e87ULL},
+  };
+
+  for (unsigned i = 0; i < countof(vectors); ++i) {
+    Murmur3Context ctx;
+    CryptoHash hash;
+
+    ctx.hash_immediate(hash, vectors[i].input, strlen(vectors[i].input));
+    CHECK(hash.u64[0] == vectors[i].h1 && hash.u64[1] == vectors[i].h2);
+  }
+}
+
+// Feeding the input in pieces, as the URL hash does, gives the same
+// hash as feeding it at once.
+template <class Context>
+static void
+test_incremental()
+{
+  const char *url = long_urls[0];
+  int len = strlen(url);
+  CryptoHash whole;
+
+  Context().hash_immediate(whole, url, len);
+
+  for (int split = 0; split <= len; ++split) {
+    for (int step = 1; step <= 17; step += 4) {
+      Context ctx;
+      CryptoHash pieces;
+      int at = split;
+
+      ctx.update(url, split);
+      while (at < len) {
+        int n = std::min(step, len - at);
+        ctx.update(url + at, n);
+        at += n;
+      }
+      ctx.finalize(pieces);
+      CHECK(pieces == whole);
+    }
+  }
+}
+
+template <class Context>
+static double
+bench(char (*urls)[512], int rounds, uint64_t *fold)
+{
+  ink_hrtime start = ink_get_hrtime_internal();
+
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < URLS; ++i) {
+      Context ctx;
+      CryptoHash hash;
+
+      ctx.update(urls[i], strlen(urls[i]));
+      ctx.finalize(hash);
+      *fold += hash.fold();
+    }
+  }
+  return (double) (ink_get_hrtime_internal() - start) / (rounds * URLS);
+}
+
+// Key generation cost for the hashes a cache can be configured with,
+// over short urls and urls with long query strings.
+static void
+bench_key_hash()
+{
+  static const int ROUNDS = 20;
+  uint64_t fold = 0;
+
+  printf("key hash over %d byte urls: md5 %.0f ns, mmh %.0f ns, murmur3 %.0f ns\n", (int) strlen(short_urls[0]),
+         bench<MD5Context>(short_urls, ROUNDS, &fold), bench<MMHContext>(short_urls, ROUNDS, &fold),
+         bench<Murmur3Context>(short_urls, ROUNDS, &fold));
+  printf("key hash over %d byte urls: md5 %.0f ns, mmh %.0f ns, murmur3 %.0f ns\n", (int) strlen(long_urls[0]),
+         bench<MD5Context>(long_urls, ROUNDS, &fold), bench<MMHContext>(long_urls, ROUNDS, &fold),
+         bench<Murmur3Context>(long_urls, ROUNDS, &fold));
+  CHECK(fold != 0);
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char ** /* argv ATS_UNUSED */)
+{
+  for (int i = 0; i < URLS; ++i) {
+    int len;
+
+    snprintf(short_urls[i], sizeof(short_urls[i]), "http://img.example.com/obj/%08x.jpg", i * 2654435761u);
+    len = snprintf(long_urls[i], sizeof(long_urls[i]), "http://www.example.com/search/results/page?session=%08x", i);
+    while (len < 400)
+      len += snprintf(long_urls[i] + len, sizeof(long_urls[i]) - len, "&p%d=%08x", len, (len + i) * 2654435761u);
+  }
+
+  test_murmur3_vectors();
+  test_incremental<MD5Context>();
+  test_incremental<MMHContext>();
+  test_incremental<Murmur3Context>();
+  bench_key_hash();
+
+  if (failures) {
+    printf("test_CryptoHash: %d failures\n", failures);
+    return 1;
+  }
+  printf("test_CryptoHash: all tests passed\n");
+  return 0;
+}
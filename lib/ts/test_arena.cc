@@ -111,12 +111,56 @@ test_block_boundries()
   return failures;
 }
 
+// Freeing the latest allocation gives the space back, whichever block
+// it landed in.
+int
+test_free_latest()
+{
+  int failures = 0;
+  Arena *a = new Arena();
+
+  // Two blocks; the small allocation goes to the newer one.
+  char *big = (char *) a->alloc(900);
+  char *huge = (char *) a->alloc(4000);
+  char *small = (char *) a->alloc(64);
+
+  if (!big || !huge || !small) {
+    fprintf(stderr, "free_latest test failed.  allocation failed\n");
+    failures++;
+  }
+
+  a->free(small, 64);
+  if ((char *) a->alloc(64) != small) {
+    fprintf(stderr, "free_latest test failed.  space not reused after free\n");
+    failures++;
+  }
+
+  // Not the latest in its block, so this is a no-op. The allocation
+  // fills up the newer block behind small instead.
+  a->free(huge, 4000);
+  if ((char *) a->alloc(1900) == huge) {
+    fprintf(stderr, "free_latest test failed.  freed a non-latest region\n");
+    failures++;
+  }
+
+  // The latest in the older block, which only it has room for now.
+  a->free(big, 900);
+  if ((char *) a->alloc(950) != big) {
+    fprintf(stderr, "free_latest test failed.  space not reused in the older block\n");
+    failures++;
+  }
+
+  delete a;
+  return failures;
+}
+
 int
 main()
 {
   int failures = 0;
 
   failures += test_block_boundries();
+  failures += test_free_latest();
 
   if (failures) {
     return 1;
@@ -48,6 +48,7 @@
 #include "NetworkUtilsRemote.h"
 #include "EventCallback.h"
 #include "MgmtMarshall.h"
+#include "I_RecShm.h"
 
 // forward declarations
 static TSMgmtError send_and_parse_list(OpType op, LLQ * list);
@@ -60,6 +61,13 @@ ink_thread ts_test_thread;
 ink_thread ts_event_thread;
 TSInitOptionT ts_init_options;
 
+// The shared memory stats segments of traffic_server and traffic_manager,
+// record gets try these first, before asking traffic_manager.
+static const char *shm_files[] = { REC_SHM_PROCESS_FILE, REC_SHM_MANAGER_FILE };
+static char *shm_paths[sizeof(shm_files) / sizeof(shm_files[0])];
+static RecShmReader shm_readers[sizeof(shm_files) / sizeof(shm_files[0])];
+static ink_mutex shm_mutex;
+
 /***************************************************************************
  * Helper Functions
  ***************************************************************************/
@@ -202,6 +210,13 @@ Init(const char *socket_path, TSInitOptionT options)
   // store socket_path
   set_socket_paths(socket_path);
 
+  // the stats segments live next to the sockets
+  ink_mutex_init(&shm_mutex, "mgmtapi shm");
+  for (unsigned i = 0; i < countof(shm_files); i++) {
+    ats_free(shm_paths[i]);
+    shm_paths[i] = Layout::relative_to(socket_path, shm_files[i]);
+  }
+
   // need to ignore SIGPIPE signal; in the case that TM is restarted
   signal(SIGPIPE, SIG_IGN);
 
@@ -536,6 +551,56 @@ mgmt_record_get_reply(OpType op, TSRecordEle * rec_ele)
   return TS_ERR_OKAY;
 }
 
+/*-------------------------------------------------------------------------
+ * shm_record_get (helper function)
+ *-------------------------------------------------------------------------
+ * Look the record up in the shared memory stats segments. Returns false if
+ * the record isn't published there, in which case we ask traffic_manager.
+ */
+static bool
+shm_record_get(const char *rec_name, TSRecordEle * rec_ele)
+{
+  RecShmEntry copy;
+  bool found = false;
+
+  ink_mutex_acquire(&shm_mutex);
+  for (unsigned i = 0; i < countof(shm_files) && !found; i++) {
+    const RecShmEntry *e;
+
+    if (!shm_paths[i] || !shm_readers[i].open(shm_paths[i]) || !(e = shm_readers[i].find(rec_name)))
+      continue;
+    if (!RecShmReader::read(e, &copy) || (copy.flags & REC_SHM_TRUNCATED))
+      continue;
+
+    ink_zero(*rec_ele);
+    switch (copy.data_type) {
+    case RECD_INT:
+      rec_ele->rec_type = TS_REC_INT;
+      rec_ele->valueT.int_val = copy.data.rec_int;
+      break;
+    case RECD_COUNTER:
+      rec_ele->rec_type = TS_REC_COUNTER;
+      rec_ele->valueT.counter_val = copy.data.rec_counter;
+      break;
+    case RECD_FLOAT:
+      rec_ele->rec_type = TS_REC_FLOAT;
+      rec_ele->valueT.float_val = copy.data.rec_float;
+      break;
+    case RECD_STRING:
+      rec_ele->rec_type = TS_REC_STRING;
+      rec_ele->valueT.string_val = ats_strdup(copy.data.rec_string);
+      break;
+    default:
+      continue;
+    }
+    rec_ele->rec_name = ats_strdup(rec_name);
+    found = true;
+  }
+  ink_mutex_release(&shm_mutex);
+
+  return found;
+}
+
 // note that the record value is being sent as chunk of memory, regardless of
 // record type; it's not being converted to a string!!
 TSMgmtError
@@ -549,6 +614,10 @@ MgmtRecordGet(const char *rec_name, TSRecordEle * rec_ele)
     return TS_ERR_PARAMS;
   }
 
+  if (shm_record_get(rec_name, rec_ele)) {
+    return TS_ERR_OKAY;
+  }
+
   // create and send request
   ret = MGMTAPI_SEND_MESSAGE(main_socket_fd, RECORD_GET, &optype, &record);
   return (ret == TS_ERR_OKAY) ? mgmt_record_get_reply(RECORD_GET, rec_ele) : ret;
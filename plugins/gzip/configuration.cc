@@ -84,6 +84,8 @@ namespace Gzip {
     kParseEnable,
     kParseCache,
     kParseDisallow,
+    kParseBackgroundFetch,
+    kParseCompressionLevel,
   };
 
   void Configuration::AddHostConfiguration(HostConfiguration * hc){
@@ -221,6 +223,10 @@ namespace Gzip {
             state = kParseCache;
           } else if (token == "disallow" ) {
             state = kParseDisallow;
+          } else if (token == "background-fetch" ) {
+            state = kParseBackgroundFetch;
+          } else if (token == "compression-level" ) {
+            state = kParseCompressionLevel;
           }
           else {
             warning("failed to interpret \"%s\" at line %zu", token.c_str(), lineno);
@@ -246,6 +252,23 @@ namespace Gzip {
           current_host_configuration->add_disallow(token);
           state = kParseStart;
           break;
+        case kParseBackgroundFetch:
+          current_host_configuration->set_background_fetch(token == "true");
+          state = kParseStart;
+          break;
+        case kParseCompressionLevel:
+          if (token == "auto") {
+            current_host_configuration->set_compression_level(COMPRESSION_LEVEL_AUTO);
+          } else {
+            int level = atoi(token.c_str());
+            if (level >= 1 && level <= 9) {
+              current_host_configuration->set_compression_level(level);
+            } else {
+              warning("invalid compression level \"%s\" at line %zu", token.c_str(), lineno);
+            }
+          }
+          state = kParseStart;
+          break;
         }
       }
     }
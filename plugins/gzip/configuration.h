@@ -28,6 +28,7 @@
 #include <string>
 #include <vector>
 #include "debug_macros.h"
+#include "misc.h"
 
 namespace Gzip  { 
   class HostConfiguration {
@@ -37,6 +38,8 @@ namespace Gzip  {
       , enabled_(true)
       , cache_(true)
       , remove_accept_encoding_(false)
+      , background_fetch_(false)
+      , compression_level_(ZLIB_COMPRESSION_LEVEL)
     {}
 
     inline bool enabled() { return enabled_; }
@@ -45,6 +48,10 @@ namespace Gzip  {
     inline void set_cache(bool x) { cache_ = x; } 
     inline bool remove_accept_encoding() { return remove_accept_encoding_; }
     inline void set_remove_accept_encoding(bool x) { remove_accept_encoding_ = x; } 
+    inline bool background_fetch() { return background_fetch_; }
+    inline void set_background_fetch(bool x) { background_fetch_ = x; } 
+    inline int compression_level() { return compression_level_; }
+    inline void set_compression_level(int x) { compression_level_ = x; } 
     inline std::string host() { return host_; }
     void add_disallow(const std::string & disallow);
     void add_compressible_content_type(const std::string & content_type);
@@ -56,6 +63,8 @@ namespace Gzip  {
     bool enabled_;
     bool cache_;
     bool remove_accept_encoding_;
+    bool background_fetch_;
+    int compression_level_;
     std::vector<std::string> compressible_content_types_;
     std::vector<std::string> disallows_;
     DISALLOW_COPY_AND_ASSIGN(HostConfiguration);
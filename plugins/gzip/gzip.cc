@@ -23,6 +23,9 @@
 
 #include <string>
 #include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include <zlib.h>
 #include <ts/ts.h>
 #include "debug_macros.h"
@@ -38,16 +41,21 @@ using namespace Gzip;
 //FIXME: look into autoscaling the compression level based on connection speed
 // a gprs device might benefit from a higher compression ratio, whereas a desktop w. high bandwith
 // might be served better with little or no compression at all
+// (compression-level auto scales it on the cpu headroom of the box instead)
 //FIXME: look into compressing from the task thread pool
 //FIXME: make normalizing accept encoding configurable
 
-// from mod_deflate:
-// ZLIB's compression algorithm uses a
-// 0-9 based scale that GZIP does where '1' is 'Best speed' 
-// and '9' is 'Best compression'. Testing has proved level '6' 
-// to be about the best level to use in an HTTP Server. 
+//how often we sample our cpu usage for compression-level auto
+const int CPU_SAMPLE_INTERVAL_MS = 1000;
+//below this cpu utilization, auto uses ZLIB_COMPRESSION_LEVEL, above the
+//high mark it uses level 1, and it scales linearly in between
+const double CPU_UTILIZATION_LOW = 0.5;
+const double CPU_UTILIZATION_HIGH = 0.9;
 
-const int ZLIB_COMPRESSION_LEVEL = 6;
+//don't start another background fetch for an url within this many seconds
+const int BACKGROUND_FETCH_TIMEOUT = 60;
+const int BACKGROUND_FETCH_SLOTS = 1024;
+const int BACKGROUND_FETCH_EVENT = 63000;
 
 int arg_idx_hooked;
 int arg_idx_host_configuration;
@@ -58,8 +66,18 @@ const char * global_hidden_header_name;
 Configuration* config = NULL;
 const char *dictionary = NULL;
 
+//compression level for compression-level auto, updated by gzip_cpu_sample()
+static volatile int auto_compression_level = ZLIB_COMPRESSION_LEVEL;
+
+//url hash and start time of the recent background fetches
+static TSMutex background_fetch_mutex;
+static struct {
+  uint32_t hash;
+  time_t started;
+} background_fetches[BACKGROUND_FETCH_SLOTS];
+
 static GzipData *
-gzip_data_alloc(int compression_type)
+gzip_data_alloc(int compression_type, int compression_level)
 {
   GzipData *data;
   int err;
@@ -84,7 +102,11 @@ gzip_data_alloc(int compression_type)
 
   int window_bits = (compression_type == COMPRESSION_TYPE_GZIP) ? WINDOW_BITS_GZIP : WINDOW_BITS_DEFLATE;
 
-  err = deflateInit2(&data->zstrm, ZLIB_COMPRESSION_LEVEL, Z_DEFLATED, window_bits, ZLIB_MEMLEVEL, Z_DEFAULT_STRATEGY);
+  if (compression_level == COMPRESSION_LEVEL_AUTO) {
+    compression_level = auto_compression_level;
+  }
+
+  err = deflateInit2(&data->zstrm, compression_level, Z_DEFLATED, window_bits, ZLIB_MEMLEVEL, Z_DEFAULT_STRATEGY);
 
   if (err != Z_OK) {
     fatal("gzip-transform: ERROR: deflateInit (%d)!", err);
@@ -452,8 +474,12 @@ gzip_transform(TSCont contp, TSEvent event, void * /* edata ATS_UNUSED */)
 }
 
 
+//returns whether the response should be compressed for this client. if
+//the client can't take a compressed response, but it would have been
+//compressed otherwise, *client_unable is set.
 static int
-gzip_transformable(TSHttpTxn txnp, int server, HostConfiguration * host_configuration, int *compress_type)
+gzip_transformable(TSHttpTxn txnp, int server, HostConfiguration * host_configuration, int *compress_type,
+                   int *client_unable = NULL)
 {
   /* Server response header */
   TSMBuffer bufp;
@@ -518,15 +544,14 @@ gzip_transformable(TSHttpTxn txnp, int server, HostConfiguration * host_configur
 
     TSHandleMLocRelease(cbuf, chdr, cfield);
     TSHandleMLocRelease(cbuf, TS_NULL_MLOC, chdr);
-
-    if (!compression_acceptable) {
-      info("no acceptable encoding found in request header, not compressible");
-      return 0;
-    }
   } else {
-    info("no acceptable encoding found in request header, not compressible");
+    compression_acceptable = 0;
     TSHandleMLocRelease(cbuf, chdr, cfield);
     TSHandleMLocRelease(cbuf, TS_NULL_MLOC, chdr);
+  }
+
+  if (!compression_acceptable && !client_unable) {
+    info("no acceptable encoding found in request header, not compressible");
     return 0;
   }
 
@@ -560,6 +585,10 @@ gzip_transformable(TSHttpTxn txnp, int server, HostConfiguration * host_configur
   int rv = host_configuration->ContentTypeIsCompressible(value, len);
   if (!rv) { 
     info("content-type [%.*s] not compressible", len, value);
+  } else if (!compression_acceptable) {
+    info("no acceptable encoding found in request header, not compressible");
+    *client_unable = 1;
+    rv = 0;
   }
   TSHandleMLocRelease(bufp, hdr_loc, field_loc);
   TSHandleMLocRelease(bufp, TS_NULL_MLOC, hdr_loc);
@@ -592,13 +621,153 @@ gzip_transform_add(TSHttpTxn txnp, int /* server ATS_UNUSED */, HostConfiguratio
   GzipData *data;
 
   connp = TSTransformCreate(gzip_transform, txnp);
-  data = gzip_data_alloc(compress_type);
+  data = gzip_data_alloc(compress_type, hc->compression_level());
   data->txn = txnp;
 
   TSContDataSet(connp, data);
   TSHttpTxnHookAdd(txnp, TS_HTTP_RESPONSE_TRANSFORM_HOOK, connp);
 }
 
+//store compressible responses with a Vary: Accept-Encoding, also when we
+//don't compress them. otherwise the uncompressed alternate would be served
+//(and compressed on the fly) to every client that takes a compressed one,
+//instead of them getting the compressed alternate from the cache.
+static void
+gzip_cache_vary(TSHttpTxn txnp, HostConfiguration * hc)
+{
+  TSMBuffer bufp;
+  TSMLoc hdr_loc;
+
+  if (!hc->cache()) {
+    return;
+  }
+
+  if (TSHttpTxnServerRespGet(txnp, &bufp, &hdr_loc) == TS_SUCCESS) {
+    gzip_vary_header(bufp, hdr_loc);
+    TSHandleMLocRelease(bufp, TS_NULL_MLOC, hdr_loc);
+  }
+}
+
+static int
+background_fetch_done(TSCont contp, TSEvent event, void * /* edata ATS_UNUSED */)
+{
+  debug("background fetch done (%d)", event);
+  TSContDestroy(contp);
+  return 0;
+}
+
+//a client that can't take a compressed response missed on a compressible
+//url. fetch it once more in the background on behalf of the clients that
+//can, so that the compressed alternate is in the cache before they ask.
+static void
+gzip_background_fetch(TSHttpTxn txnp)
+{
+  TSMBuffer bufp;
+  TSMLoc hdr_loc, field_loc;
+  int url_len, host_len;
+  const char *host;
+  uint32_t hash;
+  time_t now;
+  bool busy;
+
+  if (TSHttpIsInternalRequest(txnp) == TS_SUCCESS) {
+    return;
+  }
+
+  char *url = TSHttpTxnEffectiveUrlStringGet(txnp, &url_len);
+  if (!url) {
+    return;
+  }
+
+  hash = 0x811c9dc5;
+  for (int i = 0; i < url_len; i++) {
+    hash = (hash ^ (unsigned char) url[i]) * 0x01000193;
+  }
+  now = time(NULL);
+
+  TSMutexLock(background_fetch_mutex);
+  int slot = hash % BACKGROUND_FETCH_SLOTS;
+  busy = background_fetches[slot].hash == hash && now - background_fetches[slot].started < BACKGROUND_FETCH_TIMEOUT;
+  if (!busy) {
+    background_fetches[slot].hash = hash;
+    background_fetches[slot].started = now;
+  }
+  TSMutexUnlock(background_fetch_mutex);
+
+  if (busy) {
+    TSfree(url);
+    return;
+  }
+
+  string request("GET ");
+  request.append(url, url_len);
+  request.append(" HTTP/1.1\r\n");
+  TSfree(url);
+
+  if (TSHttpTxnClientReqGet(txnp, &bufp, &hdr_loc) == TS_SUCCESS) {
+    field_loc = TSMimeHdrFieldFind(bufp, hdr_loc, TS_MIME_FIELD_HOST, TS_MIME_LEN_HOST);
+    if (field_loc) {
+      host = TSMimeHdrFieldValueStringGet(bufp, hdr_loc, field_loc, -1, &host_len);
+      request.append("Host: ");
+      request.append(host, host_len);
+      request.append("\r\n");
+      TSHandleMLocRelease(bufp, hdr_loc, field_loc);
+    }
+    TSHandleMLocRelease(bufp, TS_NULL_MLOC, hdr_loc);
+  }
+  //the form normalize_accept_encoding() puts it in, so the alternate matches
+  request.append("Accept-Encoding: gzip\r\n\r\n");
+
+  TSFetchEvent events;
+  events.success_event_id = BACKGROUND_FETCH_EVENT;
+  events.failure_event_id = BACKGROUND_FETCH_EVENT + 1;
+  events.timeout_event_id = BACKGROUND_FETCH_EVENT + 2;
+
+  info("starting background fetch");
+  TSCont contp = TSContCreate(background_fetch_done, TSMutexCreate());
+  TSFetchUrl(request.data(), request.size(), TSHttpTxnClientAddrGet(txnp), contp, AFTER_BODY, events);
+}
+
+//sample the cpu usage of the process, and derive the compression level
+//used by compression-level auto from it.
+static int
+gzip_cpu_sample(TSCont contp, TSEvent /* event ATS_UNUSED */, void * /* edata ATS_UNUSED */)
+{
+  static double last_cpu = 0, last_wall = 0;
+  static long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+  struct rusage ru;
+  struct timeval tv;
+
+  if (getrusage(RUSAGE_SELF, &ru) == 0 && gettimeofday(&tv, NULL) == 0) {
+    double cpu = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000000.0;
+    double wall = tv.tv_sec + tv.tv_usec / 1000000.0;
+
+    if (last_wall > 0 && wall > last_wall && ncpus > 0) {
+      double utilization = (cpu - last_cpu) / ((wall - last_wall) * ncpus);
+      int level;
+
+      if (utilization <= CPU_UTILIZATION_LOW) {
+        level = ZLIB_COMPRESSION_LEVEL;
+      } else if (utilization >= CPU_UTILIZATION_HIGH) {
+        level = 1;
+      } else {
+        level = ZLIB_COMPRESSION_LEVEL - (int) ((ZLIB_COMPRESSION_LEVEL - 1) * (utilization - CPU_UTILIZATION_LOW) /
+                                                (CPU_UTILIZATION_HIGH - CPU_UTILIZATION_LOW));
+      }
+
+      if (level != auto_compression_level) {
+        debug("cpu utilization %.2f, compression level %d", utilization, level);
+        auto_compression_level = level;
+      }
+    }
+    last_cpu = cpu;
+    last_wall = wall;
+  }
+
+  TSContSchedule(contp, CPU_SAMPLE_INTERVAL_MS, TS_THREAD_POOL_DEFAULT);
+  return 0;
+}
+
 static int
 cache_transformable(TSHttpTxn txnp)
 {
@@ -686,8 +855,15 @@ transform_plugin(TSCont /* contp ATS_UNUSED */, TSEvent event, void *edata)
           }
 
           int allowed = !TSHttpTxnArgGet(txnp, arg_idx_url_disallowed);
-          if ( allowed && gzip_transformable(txnp, 1, hc, &compress_type)) {
+          int client_unable = 0;
+          if ( allowed && gzip_transformable(txnp, 1, hc, &compress_type, &client_unable)) {
+            gzip_cache_vary(txnp, hc);
             gzip_transform_add(txnp, 1, hc, compress_type);
+          } else if (allowed && client_unable) {
+            gzip_cache_vary(txnp, hc);
+            if (hc->cache() && hc->background_fetch()) {
+              gzip_background_fetch(txnp);
+            }
           }
         }
         TSHttpTxnReenable(txnp, TS_EVENT_HTTP_CONTINUE);
@@ -794,6 +970,11 @@ TSPluginInit(int argc, const char *argv[])
   TSMgmtUpdateRegister(management_contp, TAG);
   read_configuration(management_contp);
 
+  background_fetch_mutex = TSMutexCreate();
+
+  TSCont cpu_contp = TSContCreate(gzip_cpu_sample, TSMutexCreate());
+  TSContSchedule(cpu_contp, CPU_SAMPLE_INTERVAL_MS, TS_THREAD_POOL_DEFAULT);
+
   TSCont transform_contp = TSContCreate(transform_plugin, NULL);
   TSHttpHookAdd(TS_HTTP_READ_REQUEST_HDR_HOOK, transform_contp);
   TSHttpHookAdd(TS_HTTP_READ_RESPONSE_HDR_HOOK, transform_contp);
@@ -34,6 +34,15 @@ static const int ZLIB_MEMLEVEL = 9;     //min=1 (optimize for memory),max=9 (opt
 static const int WINDOW_BITS_DEFLATE = -15;
 static const int WINDOW_BITS_GZIP = 31;
 
+// from mod_deflate:
+// ZLIB's compression algorithm uses a
+// 0-9 based scale that GZIP does where '1' is 'Best speed' 
+// and '9' is 'Best compression'. Testing has proved level '6' 
+// to be about the best level to use in an HTTP Server. 
+static const int ZLIB_COMPRESSION_LEVEL = 6;
+//pick the level from the cpu headroom, see gzip_cpu_sample()
+static const int COMPRESSION_LEVEL_AUTO = 0;
+
 //misc
 static const int COMPRESSION_TYPE_DEFLATE = 1;
 static const int COMPRESSION_TYPE_GZIP = 2;
@@ -4619,6 +4619,8 @@ TSHttpTxnClientRespGet(TSHttpTxn txnp, TSMBuffer *bufp, TSMLoc *obj)
   HttpSM *sm = (HttpSM *) txnp;
   HTTPHdr *hptr = &(sm->t_state.hdr_info.client_response);
 
+  // The plugin may change the response, which must not show in the cache response.
+  sm->t_state.own_cache_response();
   if (hptr->valid()) {
     *(reinterpret_cast<HTTPHdr**>(bufp)) = hptr;
     *obj = reinterpret_cast<TSMLoc>(hptr->m_http);
@@ -7514,7 +7516,7 @@ TSAIOWrite(int fd, off_t offset, char* buf, const size_t bufSize, TSCont contp)
 TSReturnCode
 TSAIOThreadNumSet(int thread_num)
 {
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
   (void)thread_num;
   return TS_SUCCESS;
 #else
@@ -7857,6 +7859,9 @@ _conf_to_memberp(TSOverridableConfigKey conf,
     typ = OVERRIDABLE_TYPE_STRING;
     ret = &overridableHttpConfig->global_user_agent_header;
     break;
+  case TS_CONFIG_HTTP_SPECULATIVE_DNS:
+    ret = &overridableHttpConfig->speculative_dns;
+    break;
 
     // This helps avoiding compiler warnings, yet detect unhandled enum members.
   case TS_CONFIG_NULL:
@@ -8109,6 +8114,8 @@ TSHttpTxnConfigFind(const char* name, int length, TSOverridableConfigKey *conf,
   case 33:
     if (!strncmp(name, "proxy.config.http.cache.fuzz.time", length))
       cnf = TS_CONFIG_HTTP_CACHE_FUZZ_TIME;
+    else if (!strncmp(name, "proxy.config.http.speculative_dns", length))
+      cnf = TS_CONFIG_HTTP_SPECULATIVE_DNS;
     break;
 
   case 34:
@@ -7420,6 +7420,7 @@ const char *SDK_Overridable_Configs[TS_CONFIG_LAST_ENTRY] = {
   "proxy.config.http.cache.range.write",
   "proxy.config.http.post.check.content_length.enabled",
   "proxy.config.http.global_user_agent_header",
+  "proxy.config.http.speculative_dns",
 };
 
 REGRESSION_TEST(SDK_API_OVERRIDABLE_CONFIGS) (RegressionTest * test, int /* atype ATS_UNUSED */, int *pstatus)
@@ -392,16 +392,22 @@ CB_After_Cache_Init()
 
   start = ink_atomic_swap(&delay_listen_for_cache_p, -1);
 
-  // Check for cache BC after the cache is initialized and before listen, if possible.
-  if (cacheProcessor.min_stripe_version.ink_major < CACHE_DB_MAJOR_VERSION) {
-    // Versions before 23 need the MMH hash.
-    if (cacheProcessor.min_stripe_version.ink_major < 23) {
-      Debug("cache_bc", "Pre 4.0 stripe (cache version %d.%d) found, forcing MMH hash for cache URLs"
-        , cacheProcessor.min_stripe_version.ink_major, cacheProcessor.min_stripe_version.ink_minor
-        );
-      URLHashContext::Setting = URLHashContext::MMH;
-    }
+  // Make cache URL keys with the hash the cache was written with, set after the cache
+  // is initialized and before listen, if possible. Pre 4.0 stripes always report MMH.
+  switch (cacheProcessor.key_hash) {
+  case CACHE_KEY_HASH_MD5:
+    URLHashContext::Setting = URLHashContext::MD5;
+    break;
+  case CACHE_KEY_HASH_MURMUR3:
+    URLHashContext::Setting = URLHashContext::MURMUR3;
+    break;
+  default:
+    URLHashContext::Setting = URLHashContext::MMH;
+    break;
   }
+  Debug("cache_bc", "Cache versions %d.%d to %d.%d, key hash %d", cacheProcessor.min_stripe_version.ink_major,
+        cacheProcessor.min_stripe_version.ink_minor, cacheProcessor.max_stripe_version.ink_major,
+        cacheProcessor.max_stripe_version.ink_minor, cacheProcessor.key_hash);
 
   if (1 == start) {
     Debug("http_listen", "Delayed listen enable, cache initialization finished");
@@ -1002,9 +1008,16 @@ check_system_constants()
 static void
 init_http_header()
 {
+  int intern_header_values = 0;
+
   url_init();
   mime_init();
   http_init();
+
+  REC_ReadConfigInteger(intern_header_values, "proxy.config.http.intern_header_values");
+  if (intern_header_values) {
+    hdr_intern_init();
+  }
 }
 
 struct AutoStopCont: public Continuation
@@ -1648,6 +1661,7 @@ REGRESSION_TEST(Hdrs) (RegressionTest * t, int atype, int *pstatus) {
 static void *
 mgmt_restart_shutdown_callback(void *, char *, int /* data_len ATS_UNUSED */)
 {
+  ram_cache_index_save_on_shutdown();
   sync_cache_dir_on_shutdown();
   return NULL;
 }
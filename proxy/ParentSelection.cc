@@ -47,6 +47,7 @@ static const char *retry_var = "proxy.config.http.parent_proxy.retry_time";
 static const char *enable_var = "proxy.config.http.parent_proxy_routing_enable";
 static const char *threshold_var = "proxy.config.http.parent_proxy.fail_threshold";
 static const char *dns_parent_only_var = "proxy.config.http.no_dns_just_forward_to_parent";
+static const char *load_factor_var = "proxy.config.http.parent_proxy.consistent_hash_load_factor";
 
 static const char *ParentResultStr[] = {
   "Parent_Undefined",
@@ -121,6 +122,9 @@ ParentConfig::startup()
 
   //   DNS Parent Only
   parentConfigUpdate->attach(dns_parent_only_var);
+
+  //   Consistent hash load factor
+  parentConfigUpdate->attach(load_factor_var);
 }
 
 void
@@ -804,6 +808,7 @@ ParentRecord::DefaultInit(char *val)
 void
 ParentRecord::buildConsistentHash(void) {
   ATSHash64Sip24 hash;
+  float load_factor = 0;
   int i;
 
   if (chash) {
@@ -815,6 +820,9 @@ ParentRecord::buildConsistentHash(void) {
   for (i = 0; i < num_parents; i++) {
     chash->insert(&(this->parents[i]), this->parents[i].weight, (ATSHash64 *) &hash);
   }
+
+  REC_ReadConfigFloat(load_factor, load_factor_var);
+  chash->set_load_factor(load_factor);
 }
 
 // char* ParentRecord::Init(matcher_line* line_info)
@@ -65,7 +65,7 @@ struct ParentResult
 {
   ParentResult()
     : r(PARENT_UNDEFINED), hostname(NULL), port(0), line_number(0), epoch(NULL), rec(NULL),
-      last_parent(0), start_parent(0), wrap_around(false), retry(false)
+      last_parent(0), start_parent(0), wrap_around(false), retry(false), chashIter(0)
   { memset(foundParents, 0, sizeof(foundParents)); };
 
   // For outside consumption
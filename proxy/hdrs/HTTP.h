@@ -871,7 +871,9 @@ HTTPHdr::copy(const HTTPHdr *hdr)
   if (valid()) {
     http_hdr_copy_onto(hdr->m_http, hdr->m_heap, m_http, m_heap, (m_heap != hdr->m_heap) ? true : false);
   } else {
-    m_heap = new_HdrHeap();
+    // Room for the copy and a field block of edits in one heap, so large
+    // cached headers are not spread over overflow heaps.
+    m_heap = new_HdrHeap(HDR_HEAP_HDR_SIZE + hdr->m_heap->obj_space_used() + sizeof(MIMEFieldBlockImpl));
     m_http = http_hdr_clone(hdr->m_http, hdr->m_heap, m_heap);
     m_mime = m_http->m_fields_impl;
   }
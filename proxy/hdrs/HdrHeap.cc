@@ -45,6 +45,119 @@ static HdrHeap proto_heap;
 Allocator strHeapAllocator("hdrStrHeap", HDR_STR_HEAP_DEFAULT_SIZE);
 static HdrStrHeap str_proto_heap;
 
+char *hdr_intern_start = NULL;
+int hdr_intern_len = 0;
+bool hdr_intern_enabled = false;
+
+// Values common enough across origins that sharing them beats
+//  giving every header its own copy.  Matching is exact, case
+//  included, since the bytes go back out on the wire as they are.
+static const char *hdr_intern_values[] = {
+  "text/html", "text/html; charset=utf-8", "text/html; charset=UTF-8", "text/html;charset=UTF-8",
+  "text/plain", "text/plain; charset=utf-8", "text/plain; charset=UTF-8", "text/css", "text/css; charset=utf-8",
+  "text/javascript", "text/javascript; charset=utf-8", "text/xml", "application/javascript",
+  "application/javascript; charset=utf-8", "application/x-javascript", "application/json",
+  "application/json; charset=utf-8", "application/xml", "application/octet-stream", "application/x-www-form-urlencoded",
+  "image/jpeg", "image/png", "image/gif", "image/webp", "image/svg+xml", "image/x-icon", "video/mp4",
+  "font/woff", "font/woff2", "application/font-woff",
+  "no-cache", "no-store", "private", "public", "must-revalidate", "max-age=0", "max-age=60", "max-age=300",
+  "max-age=600", "max-age=3600", "max-age=86400", "max-age=604800", "max-age=2592000", "max-age=31536000",
+  "public, max-age=3600", "public, max-age=86400", "public, max-age=604800", "public, max-age=31536000",
+  "private, max-age=0", "no-cache, no-store", "no-cache, no-store, must-revalidate", "no-store, no-cache, must-revalidate",
+  "no-store, no-cache, must-revalidate, post-check=0, pre-check=0", "private, no-cache, no-store, must-revalidate",
+  "Accept-Encoding", "Accept-Encoding, User-Agent", "Origin", "User-Agent", "Cookie", "Accept-Encoding,User-Agent",
+  "keep-alive", "Keep-Alive", "close", "Close", "chunked", "bytes", "none", "gzip", "deflate", "br", "identity",
+  "gzip, deflate", "gzip, deflate, br", "*/*", "*", "nosniff", "SAMEORIGIN", "DENY", "1; mode=block", "0", "-1",
+  "ATS", "Apache", "nginx", "Microsoft-IIS/7.5", "Microsoft-IIS/8.5", "AmazonS3", "cloudflare",
+  "en-US,en;q=0.9", "en-US,en;q=0.8", "en-US", "en"
+};
+
+struct HdrInternSlot
+{
+  const char *str;
+  int len;
+};
+
+// Power of two, and well over twice the number of values so probes
+//  stay short.
+#define HDR_INTERN_SLOTS 256
+
+static HdrInternSlot hdr_intern_slots[HDR_INTERN_SLOTS];
+static int hdr_intern_max_len = 0;
+
+static inline unsigned int
+hdr_intern_hash(const char *str, int len)
+{
+  unsigned int h = 2166136261U;
+
+  for (int i = 0; i < len; i++) {
+    h = (h ^ (unsigned char) str[i]) * 16777619U;
+  }
+  return h;
+}
+
+// void hdr_intern_init()
+//
+//   Builds the interned value table, once, and turns interning on.
+//   Must be called before any other thread is using headers.
+//
+void
+hdr_intern_init()
+{
+  if (hdr_intern_start == NULL) {
+    int total = 0;
+
+    for (unsigned i = 0; i < SIZEOF(hdr_intern_values); i++) {
+      total += strlen(hdr_intern_values[i]);
+    }
+    ink_release_assert(SIZEOF(hdr_intern_values) * 2 <= HDR_INTERN_SLOTS);
+
+    char *p = (char *) ats_malloc(total);
+
+    hdr_intern_start = p;
+    for (unsigned i = 0; i < SIZEOF(hdr_intern_values); i++) {
+      int len = strlen(hdr_intern_values[i]);
+      unsigned int slot = hdr_intern_hash(hdr_intern_values[i], len) & (HDR_INTERN_SLOTS - 1);
+
+      while (hdr_intern_slots[slot].str) {
+        slot = (slot + 1) & (HDR_INTERN_SLOTS - 1);
+      }
+      memcpy(p, hdr_intern_values[i], len);
+      hdr_intern_slots[slot].str = p;
+      hdr_intern_slots[slot].len = len;
+      if (len > hdr_intern_max_len) {
+        hdr_intern_max_len = len;
+      }
+      p += len;
+    }
+    hdr_intern_len = total;
+  }
+  hdr_intern_enabled = true;
+}
+
+// const char* hdr_intern_lookup(const char* str, int len)
+//
+//   Returns the interned copy of str or NULL if it isn't one
+//    of the interned values or interning is off.
+//
+const char *
+hdr_intern_lookup(const char *str, int len)
+{
+  if (!hdr_intern_enabled || len <= 0 || len > hdr_intern_max_len) {
+    return NULL;
+  }
+
+  unsigned int slot = hdr_intern_hash(str, len) & (HDR_INTERN_SLOTS - 1);
+
+  while (hdr_intern_slots[slot].str) {
+    if (hdr_intern_slots[slot].len == len && memcmp(hdr_intern_slots[slot].str, str, len) == 0) {
+      return hdr_intern_slots[slot].str;
+    }
+    slot = (slot + 1) & (HDR_INTERN_SLOTS - 1);
+  }
+  return NULL;
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -323,6 +436,131 @@ HdrHeap::duplicate_str(const char *str, int nbytes)
   return (new_str);
 }
 
+// const char* HdrHeap::intern_str(const char* str, int nbytes)
+//
+//  Returns the interned copy of str, with the interned table
+//   attached to the heap, or NULL if the caller has to copy
+//   the string itself.
+//
+const char *
+HdrHeap::intern_str(const char *str, int nbytes)
+{
+  const char *interned = hdr_intern_lookup(str, nbytes);
+
+  if (interned && attach_interned_strs()) {
+    return interned;
+  }
+  return NULL;
+}
+
+// bool HdrHeap::attach_interned_strs()
+//
+//  Attaches the interned table as a read only string heap.
+//   Returns false if there is no slot left for it, we don't
+//   coalesce just to make one.
+//
+bool
+HdrHeap::attach_interned_strs()
+{
+  int free_slot = -1;
+
+  ink_assert(m_writeable);
+  for (int i = 0; i < HDR_BUF_RONLY_HEAPS; i++) {
+    if (m_ronly_heap[i].m_heap_start == NULL) {
+      if (free_slot < 0) {
+        free_slot = i;
+      }
+    } else if (m_ronly_heap[i].m_heap_start == hdr_intern_start) {
+      return true;
+    }
+  }
+
+  if (free_slot < 0) {
+    return false;
+  }
+
+  // No reference count, the table is never freed
+  m_ronly_heap[free_slot].m_ref_count_ptr = NULL;
+  m_ronly_heap[free_slot].m_heap_start = hdr_intern_start;
+  m_ronly_heap[free_slot].m_heap_len = hdr_intern_len;
+  m_ronly_heap[free_slot].m_locked = false;
+  return true;
+}
+
+bool
+HdrHeap::interned_strs() const
+{
+  if (hdr_intern_start) {
+    for (int i = 0; i < HDR_BUF_RONLY_HEAPS; i++) {
+      if (m_ronly_heap[i].m_heap_start == hdr_intern_start) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static int
+release_interned(HdrHeap *heap, char *dest)
+{
+  int len = 0;
+
+  for (HdrHeap *h = heap; h; h = h->m_next) {
+    for (char *data = h->m_data_start; data < h->m_free_start; data += ((HdrHeapObjImpl *) data)->m_length) {
+      HdrHeapObjImpl *obj = (HdrHeapObjImpl *) data;
+
+      if (obj->m_type == HDR_HEAP_OBJ_MIME_HEADER) {
+        len += ((MIMEHdrImpl *) obj)->m_first_fblock.release_interned_strs(dest ? dest + len : NULL);
+      } else if (obj->m_type == HDR_HEAP_OBJ_FIELD_BLOCK) {
+        len += ((MIMEFieldBlockImpl *) obj)->release_interned_strs(dest ? dest + len : NULL);
+      }
+    }
+  }
+  return len;
+}
+
+// void HdrHeap::release_interned_strs()
+//
+//  Copies the interned values into the read/write string
+//   heap and detaches the interned table.  Unlike a coalesce
+//   this leaves every other string, and how it prints, alone.
+//
+void
+HdrHeap::release_interned_strs()
+{
+  int len = release_interned(this, NULL);
+  char *dest = NULL;
+
+  ink_assert(m_writeable);
+  if (len > 0) {
+    if (m_read_write_heap) {
+      dest = m_read_write_heap->allocate(len);
+    }
+    if (dest == NULL) {
+      // No room, let a coalesce copy them with everything else
+      coalesce_str_heaps(0, false);
+      return;
+    }
+    release_interned(this, dest);
+  }
+
+  for (int i = 0; i < HDR_BUF_RONLY_HEAPS; i++) {
+    if (m_ronly_heap[i].m_heap_start == hdr_intern_start) {
+      // Keep the slots packed at the front
+      for (; i < HDR_BUF_RONLY_HEAPS - 1; i++) {
+        m_ronly_heap[i].m_ref_count_ptr = m_ronly_heap[i + 1].m_ref_count_ptr;
+        m_ronly_heap[i].m_heap_start = m_ronly_heap[i + 1].m_heap_start;
+        m_ronly_heap[i].m_heap_len = m_ronly_heap[i + 1].m_heap_len;
+        m_ronly_heap[i].m_locked = m_ronly_heap[i + 1].m_locked;
+      }
+      m_ronly_heap[i].m_ref_count_ptr = NULL;
+      m_ronly_heap[i].m_heap_start = NULL;
+      m_ronly_heap[i].m_heap_len = 0;
+      m_ronly_heap[i].m_locked = false;
+      break;
+    }
+  }
+}
 
 // int HdrHeap::demote_rw_str_heap()
 //
@@ -362,8 +600,12 @@ HdrHeap::demote_rw_str_heap()
 //     since saves doing bounds checks every string.  At
 //     expense of doing far more copying
 //
+//  Unless keep_interned is false, interned field values
+//     stay where they are and values that can be interned
+//     are, instead of being copied.
+//
 void
-HdrHeap::coalesce_str_heaps(int incoming_size)
+HdrHeap::coalesce_str_heaps(int incoming_size, bool keep_interned)
 {
   int new_heap_size = incoming_size;
   ink_assert(incoming_size >= 0);
@@ -372,7 +614,7 @@ HdrHeap::coalesce_str_heaps(int incoming_size)
   new_heap_size += required_space_for_evacuation();
 
   HdrStrHeap *new_heap = new_HdrStrHeap(new_heap_size);
-  evacuate_from_str_heaps(new_heap);
+  int interned = evacuate_from_str_heaps(new_heap, keep_interned);
   m_lost_string_space = 0;
 
   // At this point none of the currently used string
@@ -394,15 +636,26 @@ HdrHeap::coalesce_str_heaps(int incoming_size)
   //   string heap slots or be for incoming heaps
   //   If we don't have any free heaps, we are screwed
   ink_assert(heaps_removed > 0 || incoming_size > 0 || m_ronly_heap[0].m_heap_start == NULL);
+
+  if (interned > 0) {
+    bool attached = attach_interned_strs();
+    ink_release_assert(attached);
+  }
 }
 
-void
-HdrHeap::evacuate_from_str_heaps(HdrStrHeap * new_heap)
+// int HdrHeap::evacuate_from_str_heaps(HdrStrHeap* new_heap, bool keep_interned)
+//
+//  Returns the number of strings left pointing at the
+//   interned table
+//
+int
+HdrHeap::evacuate_from_str_heaps(HdrStrHeap * new_heap, bool keep_interned)
 {
 //    printf("Str Evac\n");
   // Loop over the objects in heap and call the evacuation
   //  function in each one
   HdrHeap *h = this;
+  int interned = 0;
   ink_assert(m_writeable);
 
   while (h) {
@@ -419,10 +672,10 @@ HdrHeap::evacuate_from_str_heaps(HdrStrHeap * new_heap)
         ((HTTPHdrImpl *) obj)->move_strings(new_heap);
         break;
       case HDR_HEAP_OBJ_MIME_HEADER:
-        ((MIMEHdrImpl *) obj)->move_strings(new_heap);
+        interned += ((MIMEHdrImpl *) obj)->move_strings(new_heap, keep_interned);
         break;
       case HDR_HEAP_OBJ_FIELD_BLOCK:
-        ((MIMEFieldBlockImpl *) obj)->move_strings(new_heap);
+        interned += ((MIMEFieldBlockImpl *) obj)->move_strings(new_heap, keep_interned);
         break;
       case HDR_HEAP_OBJ_EMPTY:
       case HDR_HEAP_OBJ_RAW:
@@ -438,6 +691,8 @@ HdrHeap::evacuate_from_str_heaps(HdrStrHeap * new_heap)
     h = h->m_next;
 
   }
+
+  return interned;
 }
 
 size_t
@@ -553,6 +808,12 @@ HdrHeap::marshal_length()
 {
   int len;
 
+  // The interned table isn't marshalled, take the values
+  //  it holds for us back into our own string heap
+  if (interned_strs()) {
+    release_interned_strs();
+  }
+
   // If there is more than one HdrHeap block, we'll
   //  coalesce the HdrHeap blocks together so we
   //  only need one block header
@@ -619,6 +880,11 @@ HdrHeap::marshal(char *buf, int len)
 {
   ink_assert((((uintptr_t) buf) & HDR_PTR_ALIGNMENT_MASK) == 0);
 
+  // Normally already done by marshal_length()
+  if (interned_strs()) {
+    release_interned_strs();
+  }
+
   HdrHeap *marshal_hdr = (HdrHeap *) buf;
   char *b = buf + HDR_HEAP_HDR_SIZE;
 
@@ -1041,7 +1307,9 @@ HdrHeap::inherit_string_heaps(const HdrHeap * inherit_from)
     inherit_str_size = inherit_from->m_read_write_heap->m_heap_size;
   }
   for (index = 0; index < HDR_BUF_RONLY_HEAPS; index++) {
-    if (inherit_from->m_ronly_heap[index].m_heap_start != NULL) {
+    if (inherit_from->m_ronly_heap[index].m_heap_start == hdr_intern_start && interned_strs()) {
+      // Already attached, takes no new slot
+    } else if (inherit_from->m_ronly_heap[index].m_heap_start != NULL) {
       free_slots--;
       inherit_str_size += inherit_from->m_ronly_heap[index].m_heap_len;
     } else {
@@ -1075,6 +1343,9 @@ HdrHeap::inherit_string_heaps(const HdrHeap * inherit_from)
     }
     // Copy over read only string heaps
     for (int i = 0; i < HDR_BUF_RONLY_HEAPS; i++) {
+      if (inherit_from->m_ronly_heap[i].m_heap_start == hdr_intern_start && interned_strs()) {
+        continue;
+      }
       if (inherit_from->m_ronly_heap[i].m_heap_start) {
         result = attach_str_heap(inherit_from->m_ronly_heap[i].m_heap_start,
                                  inherit_from->m_ronly_heap[i].m_heap_len,
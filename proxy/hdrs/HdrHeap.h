@@ -155,6 +155,29 @@ struct StrHeapDesc
 
 class IOBufferBlock;
 
+// Interned field values
+//
+//   A read only table of common field values (Content-Type,
+//   Cache-Control, Vary ...) built once at startup and shared by
+//   every heap.  A heap that points a field at an interned value
+//   attaches the table as one of its read only string heaps, with no
+//   reference count since the table is never freed.  Interned values
+//   are copied back into the heap before it is marshalled, so the
+//   table never ends up in the cache.  Host values are never interned
+//   since the URL may share them.
+extern char *hdr_intern_start;
+extern int hdr_intern_len;
+extern bool hdr_intern_enabled;
+
+void hdr_intern_init();
+const char *hdr_intern_lookup(const char *str, int len);
+
+inline bool
+hdr_str_interned(const char *str)
+{
+  return (uintptr_t) str - (uintptr_t) hdr_intern_start < (uintptr_t) hdr_intern_len;
+}
+
 class HdrStrHeap:public RefCountObj
 {
 public:
@@ -193,6 +216,7 @@ public:
   char *expand_str(const char *old_str, int old_len, int new_len);
   char *duplicate_str(const char *str, int nbytes);
   void free_string(const char *s, int len);
+  const char *intern_str(const char *str, int nbytes);
 
   // Marshalling
   inkcoreapi int marshal_length();
@@ -202,6 +226,8 @@ public:
   /// Callers should round up to HDR_PTR_SIZE to get the actual footprint.
   int unmarshal_size() const; // TBD - change this name, it's confusing.
   // One option - overload marshal_length to return this value if @a magic is HDR_BUF_MAGIC_MARSHALED.
+  /// Bytes of objects in this heap and its overflow heaps, strings not included.
+  int obj_space_used() const;
 
   void inherit_string_heaps(const HdrHeap * inherit_from);
   int attach_block(IOBufferBlock * b, const char *use_start);
@@ -263,10 +289,13 @@ public:
   uint32_t m_free_size;
 
   int demote_rw_str_heap();
-  void coalesce_str_heaps(int incoming_size = 0);
-  void evacuate_from_str_heaps(HdrStrHeap * new_heap);
+  void coalesce_str_heaps(int incoming_size = 0, bool keep_interned = true);
+  int evacuate_from_str_heaps(HdrStrHeap * new_heap, bool keep_interned = false);
   size_t required_space_for_evacuation();
   int attach_str_heap(char *h_start, int h_len, RefCountObj * h_ref_obj, int *index);
+  bool attach_interned_strs();
+  bool interned_strs() const;
+  void release_interned_strs();
 
   /** Struct to prevent garbage collection on heaps.
       This bumps the reference count to the heap containing the pointer
@@ -306,7 +335,7 @@ public:
 inline void
 HdrHeap::free_string(const char *s, int len)
 {
-  if (s && len > 0) {
+  if (s && len > 0 && !hdr_str_interned(s)) {
     m_lost_string_space += len;
   }
 }
@@ -316,6 +345,16 @@ HdrHeap::unmarshal_size() const {
   return m_size + m_ronly_heap[0].m_heap_len;
 }
 
+inline int
+HdrHeap::obj_space_used() const {
+  int used = 0;
+
+  for (const HdrHeap *h = this; h; h = h->m_next) {
+    used += h->m_free_start - h->m_data_start;
+  }
+  return used;
+}
+
 
 //
 struct MarshalXlate
@@ -0,0 +1,92 @@
+/** @file
+
+  Block scanning of header text
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/****************************************************************************
+
+   HdrScan.h
+
+   Description: Search header text for any of a few delimiters, 32 or 16
+                bytes at a time where the compiler targets AVX2 or SSE2,
+                otherwise a byte at a time. Single delimiters are left to
+                memchr(), which libc already vectorizes.
+
+
+ ****************************************************************************/
+
+#ifndef _HDR_SCAN_H_
+#define _HDR_SCAN_H_
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The byte at a time version, also the reference for the regression test.
+inline const char *
+hdr_scan_for_scalar(const char *s, const char *e, char c0, char c1, char c2)
+{
+  for (; s < e; ++s) {
+    if (*s == c0 || *s == c1 || *s == c2)
+      return s;
+  }
+  return e;
+}
+
+// First of c0, c1 or c2 in [s, e), e if there is none.
+inline const char *
+hdr_scan_for(const char *s, const char *e, char c0, char c1, char c2)
+{
+#if defined(__AVX2__)
+  if (e - s >= 32) {
+    const __m256i v0 = _mm256_set1_epi8(c0);
+    const __m256i v1 = _mm256_set1_epi8(c1);
+    const __m256i v2 = _mm256_set1_epi8(c2);
+    for (; e - s >= 32; s += 32) {
+      __m256i b = _mm256_loadu_si256((const __m256i *)s);
+      unsigned m = _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(b, v0),
+                                                                        _mm256_cmpeq_epi8(b, v1)),
+                                                        _mm256_cmpeq_epi8(b, v2)));
+      if (m)
+        return s + __builtin_ctz(m);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  if (e - s >= 16) {
+    const __m128i v0 = _mm_set1_epi8(c0);
+    const __m128i v1 = _mm_set1_epi8(c1);
+    const __m128i v2 = _mm_set1_epi8(c2);
+    for (; e - s >= 16; s += 16) {
+      __m128i b = _mm_loadu_si128((const __m128i *)s);
+      unsigned m = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(b, v0), _mm_cmpeq_epi8(b, v1)),
+                                                  _mm_cmpeq_epi8(b, v2)));
+      if (m)
+        return s + __builtin_ctz(m);
+    }
+  }
+#endif
+  return hdr_scan_for_scalar(s, e, c0, c1, c2);
+}
+
+#endif
@@ -41,6 +41,7 @@
 #include "URL.h"
 #include "HttpCompat.h"
 
+#include "HdrScan.h"
 #include "HdrTest.h"
 
 //////////////////////
@@ -48,7 +49,7 @@
 //////////////////////
 
 int
-HdrTest::go(RegressionTest * t, int /* atype ATS_UNUSED */)
+HdrTest::go(RegressionTest * t, int atype)
 {
   HdrTest::rtest = t;
   int status = 1;
@@ -77,6 +78,13 @@ HdrTest::go(RegressionTest * t, int /* atype ATS_UNUSED */)
   status = status & test_http_mutation();
   status = status & test_mime();
   status = status & test_http();
+  status = status & test_hdrtoken_tokenize();
+  status = status & test_scan();
+  status = status & test_http_parser_fuzz();
+  status = status & test_http_hdr_copy_large();
+  status = status & test_http_hdr_intern();
+  if (atype >= REGRESSION_TEST_EXTENDED)
+    status = status & bench_http_parser();
 
   return (status ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED);
 }
@@ -2246,6 +2254,260 @@ HdrTest::test_parse_comma_list()
   return (failures_to_status("test_parse_comma_list", failures));
 }
 
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_hdrtoken_tokenize()
+{
+  char buf[64];
+  int failures = 0;
+
+  bri_box("test_hdrtoken_tokenize");
+
+  for (int i = 0; i < hdrtoken_num_wks; i++) {
+    const char *wks = hdrtoken_index_to_wks(i);
+    int len = hdrtoken_index_to_length(i);
+    const char *out = NULL;
+
+    // any case, from a copy so it is not recognized as the wks itself
+    ink_release_assert(len < (int)sizeof(buf));
+    for (int j = 0; j < len; j++)
+      buf[j] = (j & 1) ? ParseRules::ink_toupper(wks[j]) : ParseRules::ink_tolower(wks[j]);
+    if (hdrtoken_tokenize(buf, len, &out) != i || out != wks) {
+      printf("FAILED: '%.*s' is not tokenized as '%s'\n", len, buf, wks);
+      ++failures;
+    }
+    // the same length but another string, and the string with a character less or more
+    buf[len - 1] ^= 0x01;
+    if (hdrtoken_tokenize(buf, len) >= 0 && strncasecmp(buf, hdrtoken_index_to_wks(hdrtoken_tokenize(buf, len)), len)) {
+      printf("FAILED: '%.*s' is tokenized as a different string\n", len, buf);
+      ++failures;
+    }
+    buf[len - 1] ^= 0x01;
+    buf[len] = 'x';
+    if (hdrtoken_tokenize(buf, len - 1) >= 0 && hdrtoken_index_to_length(hdrtoken_tokenize(buf, len - 1)) != len - 1) {
+      printf("FAILED: '%.*s' is tokenized with the wrong length\n", len - 1, buf);
+      ++failures;
+    }
+    if (hdrtoken_tokenize(buf, len + 1) >= 0 && hdrtoken_index_to_length(hdrtoken_tokenize(buf, len + 1)) != len + 1) {
+      printf("FAILED: '%.*s' is tokenized with the wrong length\n", len + 1, buf);
+      ++failures;
+    }
+  }
+  if (hdrtoken_tokenize("X-Not-Well-Known", 16) >= 0 || hdrtoken_tokenize("", 0) >= 0) {
+    printf("FAILED: a string that is not well-known is tokenized\n");
+    ++failures;
+  }
+
+  return (failures_to_status("test_hdrtoken_tokenize", failures));
+}
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_scan()
+{
+  static const char alphabet[] = "abc/;?#=&%\r\n:";
+  char buf[160];
+  int failures = 0;
+
+  bri_box("test_scan");
+
+  for (int i = 0; i < 20000; i++) {
+    int len = lrand48() % 128;
+    int offset = lrand48() % 32;
+    int density = 1 + lrand48() % 64;   // most buffers have no match for a while
+    for (int j = 0; j < len; j++)
+      buf[offset + j] = (lrand48() % density) ? 'x' : alphabet[lrand48() % (sizeof(alphabet) - 1)];
+    const char *s = buf + offset, *e = s + len;
+    const char *r = hdr_scan_for(s, e, ';', '?', '#');
+    if (r != hdr_scan_for_scalar(s, e, ';', '?', '#')) {
+      printf("FAILED: hdr_scan_for(;?#) length %d offset %d found %d\n", len, offset, (int)(r - s));
+      ++failures;
+    }
+    r = hdr_scan_for(s, e, '\r', '\n', ':');
+    if (r != hdr_scan_for_scalar(s, e, '\r', '\n', ':')) {
+      printf("FAILED: hdr_scan_for(CR LF :) length %d offset %d found %d\n", len, offset, (int)(r - s));
+      ++failures;
+    }
+  }
+
+  return (failures_to_status("test_scan", failures));
+}
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+static void
+random_string(char *s, int len, const char *alphabet)
+{
+  int n = strlen(alphabet);
+  for (int i = 0; i < len; i++)
+    s[i] = alphabet[lrand48() % n];
+  s[len] = 0;
+}
+
+static bool
+url_component_is(const char *what, const char *s, int len, const char *ref, int ref_len)
+{
+  if (len == ref_len && (!len || !memcmp(s, ref, len)))
+    return true;
+  printf("FAILED: %s is '%.*s', should be '%.*s'\n", what, len, s ? s : "", ref_len, ref);
+  return false;
+}
+
+static int
+print_hdr(HTTPHdr *hdr, char *buf, int size)
+{
+  int index = 0, offset = 0;
+  hdr->print(buf, size, &index, &offset);
+  return index;
+}
+
+int
+HdrTest::test_http_parser_fuzz()
+{
+  static const char *methods[] = { "GET", "POST", "HEAD", "PURGE", "OPTIONS" };
+  static const char *names[] = { "Host", "Accept", "Accept-Encoding", "Cookie", "User-Agent", "X-Forwarded-For" };
+  static const char url_chars[] = "abcdefghijklmnopqrstuvwxyzABCXYZ0123456789-._~%/=&;?#";
+  static const char value_chars[] = "abcdefghijklmnopqrstuvwxyz ABCXYZ0123456789-._~%/=&;?#,:\"()";
+  char url[256], value[128], request[4096], print1[8192], print2[8192];
+  int failures = 0;
+
+  bri_box("test_http_parser_fuzz");
+
+  for (int i = 0; i < 2000; i++) {
+    // a random request, with continuation lines and LF only line ends now and then
+    int url_len = lrand48() % 200;
+    url[0] = '/';
+    random_string(url + 1, url_len, url_chars);
+    int len = snprintf(request, sizeof(request), "%s %s HTTP/1.%d\r\n", methods[lrand48() % 5], url, (int)(lrand48() % 2));
+    for (int n = lrand48() % 10; n > 0; n--) {
+      random_string(value, lrand48() % 100, value_chars);
+      len += snprintf(request + len, sizeof(request) - len, "%s: %s%s", names[lrand48() % 6], value,
+                      (lrand48() % 8) ? "\r\n" : "\n");
+      if (!(lrand48() % 16))
+        len += snprintf(request + len, sizeof(request) - len, "\tcontinued\r\n");
+    }
+    len += snprintf(request + len, sizeof(request) - len, "\r\n");
+
+    // parsed all at once
+    HTTPHdr whole, pieces;
+    HTTPParser parser;
+    const char *start = request;
+    whole.create(HTTP_TYPE_REQUEST);
+    http_parser_init(&parser);
+    MIMEParseResult err1 = whole.parse_req(&parser, &start, request + len, true);
+    http_parser_clear(&parser);
+
+    // and in random pieces, which glues the lines in the scanner
+    MIMEParseResult err2 = PARSE_CONT;
+    pieces.create(HTTP_TYPE_REQUEST);
+    http_parser_init(&parser);
+    for (int done = 0; done < len && err2 == PARSE_CONT;) {
+      int piece = 1 + lrand48() % 40;
+      if (piece > len - done)
+        piece = len - done;
+      start = request + done;
+      err2 = pieces.parse_req(&parser, &start, request + done + piece, done + piece == len);
+      done = start - request;
+    }
+    http_parser_clear(&parser);
+
+    if (err1 != err2) {
+      printf("FAILED: request %d parses to %d at once and %d in pieces\n%s", i, err1, err2, request);
+      ++failures;
+    } else if (err1 == PARSE_DONE) {
+      int l1 = print_hdr(&whole, print1, sizeof(print1));
+      int l2 = print_hdr(&pieces, print2, sizeof(print2));
+      if (l1 != l2 || memcmp(print1, print2, l1)) {
+        printf("FAILED: request %d prints as\n%.*s\nand in pieces\n%.*s\n", i, l1, print1, l2, print2);
+        ++failures;
+      }
+
+      // the URL components against a byte at a time split of the URL
+      const char *p = url + 1, *params = NULL, *query = NULL, *fragment = NULL;
+      int path_len = strcspn(p, ";?#"), params_len = 0, query_len = 0, fragment_len = 0;
+      const char *c = p + path_len;
+      if (*c == ';') {
+        params = c + 1;
+        params_len = strcspn(params, "?#");
+        c = params + params_len;
+      }
+      if (*c == '?') {
+        query = c + 1;
+        query_len = strcspn(query, "#");
+        c = query + query_len;
+      }
+      if (*c == '#') {
+        fragment = c + 1;
+        fragment_len = strlen(fragment);
+      }
+      URL *u = whole.url_get();
+      const char *s;
+      int l;
+      s = u->path_get(&l);
+      bool ok = url_component_is("path", s, l, p, path_len);
+      s = u->params_get(&l);
+      ok = url_component_is("params", s, l, params, params_len) && ok;
+      s = u->query_get(&l);
+      ok = url_component_is("query", s, l, query, query_len) && ok;
+      s = u->fragment_get(&l);
+      ok = url_component_is("fragment", s, l, fragment, fragment_len) && ok;
+      if (!ok) {
+        printf("   in url %s\n", url);
+        ++failures;
+      }
+    }
+    whole.destroy();
+    pieces.destroy();
+  }
+
+  return (failures_to_status("test_http_parser_fuzz", failures));
+}
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::bench_http_parser()
+{
+  static const char request[] =
+    "GET /images/products/2015/large/a8f5f167f44f4964e6c998dee827110c.jpg?width=640&height=480&quality=85 HTTP/1.1\r\n"
+    "Host: static.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:38.0) Gecko/20100101 Firefox/38.0\r\n"
+    "Accept: image/png,image/*;q=0.8,*/*;q=0.5\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Referer: http://www.example.com/products/category/shoes?page=2&sort=price\r\n"
+    "Cookie: session=8c3e1b0f2a4d4e6f9a7b5c3d1e0f2a4b; prefs=lang%3Den%26cur%3DEUR; _ga=GA1.2.123456789.1420070400\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+  static const int n = 200000;
+
+  bri_box("bench_http_parser");
+
+  ink_hrtime t = ink_get_hrtime_internal();
+  for (int i = 0; i < n; i++) {
+    HTTPHdr hdr;
+    HTTPParser parser;
+    const char *start = request;
+    hdr.create(HTTP_TYPE_REQUEST);
+    http_parser_init(&parser);
+    MIMEParseResult err = hdr.parse_req(&parser, &start, request + sizeof(request) - 1, true);
+    http_parser_clear(&parser);
+    hdr.destroy();
+    if (err != PARSE_DONE)
+      return (failures_to_status("bench_http_parser", 1));
+  }
+  t = ink_get_hrtime_internal() - t;
+  rprintf(rtest, "  HdrTest bench_http_parser: %d requests of %d bytes, %" PRId64 " ns/request, %" PRId64 " MB/s\n",
+          n, (int)sizeof(request) - 1, (int64_t)(t / n), (int64_t)(((double)n * (sizeof(request) - 1) * 1000) / t));
+  return (failures_to_status("bench_http_parser", 0));
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -2276,3 +2538,197 @@ HdrTest::failures_to_status(const char *testname, int nfail)
   return ((nfail > 0) ? 0 : 1);
 }
 
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+// A response with many Set-Cookie and Link fields, as copied for every
+// cache hit, copies into one heap and prints the same as the original.
+int
+HdrTest::test_http_hdr_copy_large()
+{
+  static const int FIELDS = 96;
+  static const int BUF_SIZE = 16384;
+  char *resp = (char *)ats_malloc(BUF_SIZE);
+  char *buf1 = (char *)ats_malloc(BUF_SIZE);
+  char *buf2 = (char *)ats_malloc(BUF_SIZE);
+  int len = 0;
+  int failures = 0;
+
+  bri_box("test_http_hdr_copy_large");
+
+  len += snprintf(resp + len, BUF_SIZE - len, "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\n");
+  for (int i = 0; i < FIELDS; ++i) {
+    if (i % 2)
+      len += snprintf(resp + len, BUF_SIZE - len, "Set-Cookie: c%d=%08x; path=/; HttpOnly\r\n", i, i * 2654435761u);
+    else
+      len += snprintf(resp + len, BUF_SIZE - len, "Link: </static/%d.css>; rel=preload; as=style\r\n", i);
+  }
+  len += snprintf(resp + len, BUF_SIZE - len, "Content-Length: 0\r\n\r\n");
+
+  HTTPHdr orig, copy;
+  HTTPParser parser;
+  const char *start = resp, *end = resp + len;
+
+  http_parser_init(&parser);
+  orig.create(HTTP_TYPE_RESPONSE);
+  if (orig.parse_resp(&parser, &start, end, true) != PARSE_DONE) {
+    printf("FAILED: large response did not parse\n");
+    ++failures;
+  } else {
+    copy.copy(&orig);
+
+    if (copy.m_heap->m_next != NULL) {
+      printf("FAILED: copy of %d fields needed overflow heaps\n", FIELDS + 2);
+      ++failures;
+    }
+    if (copy.fields_count() != orig.fields_count()) {
+      printf("FAILED: copy has %d fields, should be %d\n", copy.fields_count(), orig.fields_count());
+      ++failures;
+    }
+
+    int len1 = print_hdr(&orig, buf1, BUF_SIZE);
+    int len2 = print_hdr(&copy, buf2, BUF_SIZE);
+
+    if (len1 != len2 || memcmp(buf1, buf2, len1)) {
+      printf("FAILED: copy prints differently from the original\n");
+      ++failures;
+    }
+
+    // Editing the copy leaves the original alone.
+    copy.field_delete(MIME_FIELD_SET_COOKIE, MIME_LEN_SET_COOKIE);
+    copy.value_set(MIME_FIELD_AGE, MIME_LEN_AGE, "10", 2);
+    if (orig.field_find(MIME_FIELD_SET_COOKIE, MIME_LEN_SET_COOKIE) == NULL ||
+        orig.field_find(MIME_FIELD_AGE, MIME_LEN_AGE) != NULL) {
+      printf("FAILED: editing the copy changed the original\n");
+      ++failures;
+    }
+    copy.destroy();
+  }
+
+  orig.destroy();
+  http_parser_clear(&parser);
+  ats_free(resp);
+  ats_free(buf1);
+  ats_free(buf2);
+
+  return (failures_to_status("test_http_hdr_copy_large", failures));
+}
+
+int
+HdrTest::test_http_hdr_intern()
+{
+  static const char resp[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Cache-Control: max-age=3600\r\n"
+    "Vary: Accept-Encoding\r\n"
+    "Server:  intern-test/1.0\r\n"
+    "Content-Length: 10\r\n\r\n";
+  static const char edited[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Vary: Accept-Encoding\r\n"
+    "Server:  intern-test/1.0\r\n"
+    "Content-Length: 10\r\n"
+    "Age: 0\r\n\r\n";
+  static const int BUF_SIZE = 4096;
+  char *buf1 = (char *)ats_malloc(BUF_SIZE);
+  char *buf2 = (char *)ats_malloc(BUF_SIZE);
+  char *marshal_buf = (char *)ats_malloc(BUF_SIZE);
+  bool was_enabled = hdr_intern_enabled;
+  int failures = 0;
+  int len, value_len;
+
+  bri_box("test_http_hdr_intern");
+
+  hdr_intern_init();
+
+  HTTPHdr hdr, copy, marshal_hdr;
+  HTTPParser parser;
+  const char *start = resp, *end = resp + sizeof(resp) - 1;
+
+  http_parser_init(&parser);
+  hdr.create(HTTP_TYPE_RESPONSE);
+  if (hdr.parse_resp(&parser, &start, end, true) != PARSE_DONE) {
+    printf("FAILED: response did not parse\n");
+    ++failures;
+    goto done;
+  }
+
+  // Parsing from a buffer we don't own copies the strings, common
+  //  values are shared instead.
+  if (!hdr_str_interned(hdr.value_get(MIME_FIELD_CONTENT_TYPE, MIME_LEN_CONTENT_TYPE, &value_len)) ||
+      !hdr_str_interned(hdr.value_get(MIME_FIELD_VARY, MIME_LEN_VARY, &value_len)) ||
+      hdr_str_interned(hdr.value_get(MIME_FIELD_SERVER, MIME_LEN_SERVER, &value_len))) {
+    printf("FAILED: parsed values not interned as expected\n");
+    ++failures;
+  }
+
+  hdr.value_set(MIME_FIELD_CACHE_CONTROL, MIME_LEN_CACHE_CONTROL, "no-cache", 8);
+  hdr.value_set(MIME_FIELD_AGE, MIME_LEN_AGE, "0", 1);
+  if (!hdr_str_interned(hdr.value_get(MIME_FIELD_CACHE_CONTROL, MIME_LEN_CACHE_CONTROL, &value_len)) ||
+      !hdr.is_cache_control_set(HTTP_VALUE_NO_CACHE)) {
+    printf("FAILED: set value not interned or cooked\n");
+    ++failures;
+  }
+
+  len = print_hdr(&hdr, buf1, BUF_SIZE);
+  if (len != (int) sizeof(edited) - 1 || memcmp(buf1, edited, len)) {
+    printf("FAILED: interned header prints as '%.*s'\n", len, buf1);
+    ++failures;
+  }
+
+  // Copies share the table, coalescing keeps the values in it.
+  copy.create(HTTP_TYPE_RESPONSE);
+  copy.copy(&hdr);
+  if (print_hdr(&copy, buf2, BUF_SIZE) != len || memcmp(buf1, buf2, len)) {
+    printf("FAILED: copy prints differently\n");
+    ++failures;
+  }
+  copy.m_heap->coalesce_str_heaps();
+  copy.m_heap->sanity_check_strs();
+  if (!copy.m_heap->interned_strs() ||
+      !hdr_str_interned(copy.value_get(MIME_FIELD_CONTENT_TYPE, MIME_LEN_CONTENT_TYPE, &value_len)) ||
+      !hdr_str_interned(copy.value_get(MIME_FIELD_CACHE_CONTROL, MIME_LEN_CACHE_CONTROL, &value_len))) {
+    printf("FAILED: coalesced copy lost interned values\n");
+    ++failures;
+  }
+
+  // Marshalling takes the values back, the table stays out of the buffer.
+  {
+    int marshal_len = hdr.m_heap->marshal_length();
+    RefCountObj ref;
+
+    ref.m_refcount = 100;
+    if (hdr.m_heap->interned_strs() ||
+        marshal_len - (int) HDR_HEAP_HDR_SIZE - hdr.m_heap->obj_space_used() >= hdr_intern_len ||
+        hdr_str_interned(hdr.value_get(MIME_FIELD_CONTENT_TYPE, MIME_LEN_CONTENT_TYPE, &value_len))) {
+      printf("FAILED: interned values left in a heap about to be marshalled\n");
+      ++failures;
+    }
+    marshal_len = hdr.m_heap->marshal(marshal_buf, BUF_SIZE);
+    marshal_hdr.create(HTTP_TYPE_RESPONSE);
+    marshal_hdr.unmarshal(marshal_buf, marshal_len, &ref);
+    if (print_hdr(&marshal_hdr, buf2, BUF_SIZE) != len || memcmp(buf1, buf2, len)) {
+      printf("FAILED: unmarshalled header prints differently\n");
+      ++failures;
+    }
+    if (print_hdr(&hdr, buf2, BUF_SIZE) != len || memcmp(buf1, buf2, len)) {
+      printf("FAILED: marshalling changed how the header prints\n");
+      ++failures;
+    }
+  }
+
+  copy.destroy();
+
+done:
+  hdr.destroy();
+  http_parser_clear(&parser);
+  hdr_intern_enabled = was_enabled;
+  ats_free(buf1);
+  ats_free(buf2);
+  ats_free(marshal_buf);
+
+  return (failures_to_status("test_http_hdr_intern", failures));
+}
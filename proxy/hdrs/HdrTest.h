@@ -70,6 +70,12 @@ private:
   int test_mime();
   int test_http();
   int test_http_mutation();
+  int test_hdrtoken_tokenize();
+  int test_scan();
+  int test_http_parser_fuzz();
+  int test_http_hdr_copy_large();
+  int test_http_hdr_intern();
+  int bench_http_parser();
 
   int test_http_hdr_print_and_copy_aux(int testnum, const char *req, const char *req_tgt, const char *rsp,
                                        const char *rsp_tgt);
@@ -31,9 +31,11 @@
 #include "Regex.h"
 #include "URL.h"
 
-/* 
- You SHOULD add to _hdrtoken_commonly_tokenized_strs, with the same ordering
- ** important, ordering matters **
+/*
+ Well-known strings are looked up both by the DFA below, built from
+ _hdrtoken_strs as anchored case insensitive regexps, and by the perfect
+ hash built from the same list in hdrtoken_hash_init(). For the DFA
+ ** ordering matters **
  
  You want a regexp like 'Accept' after "greedier" choices so it doesn't match 'Accept-Ranges' earlier than
  it should. The regexp are anchored (^Accept), but I dont see a way with the current system to 
@@ -344,28 +346,23 @@ DFA *hdrtoken_strs_dfa = NULL;
  *                                                                     *
  ***********************************************************************/
 
-#define	HDRTOKEN_HASH_TABLE_SIZE	65536
-#define	HDRTOKEN_HASH_TABLE_MASK	HDRTOKEN_HASH_TABLE_SIZE-1
+// The well-known strings are looked up with a perfect hash: the hash of
+// a string picks a bucket, whose displacement is mixed into the hash to
+// get a slot that no other well-known string has. hdrtoken_hash_init()
+// finds the displacements, the largest buckets first.
 
-struct HdrTokenHashBucket
-{
-  const char *wks;
-  uint32_t hash;
-};
+#define HDRTOKEN_HASH_TABLE_BITS	9
+#define HDRTOKEN_HASH_TABLE_SIZE	(1 << HDRTOKEN_HASH_TABLE_BITS)
+#define HDRTOKEN_HASH_BUCKETS		64
+#define HDRTOKEN_HASH_MAX_DISP		65536
 
-HdrTokenHashBucket hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];
+static uint16_t hdrtoken_hash_disp[HDRTOKEN_HASH_BUCKETS];
+static int16_t hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];   // slot -> wks_idx, -1 if none
 
 /**
-  basic FNV hash
+  basic FNV hash, case insensitive: clearing bit 5 folds the letters
+  together, and the other characters consistently
 **/
-#define TINY_MASK(x) (((uint32_t)1<<(x))-1)
-
-inline uint32_t
-hash_to_slot(uint32_t hash)
-{
-  return ((hash>>15) ^ hash) & TINY_MASK(15);
-}
-
 inline uint32_t
 hdrtoken_hash(const unsigned char *string, unsigned int length)
 {
@@ -375,162 +372,19 @@ hdrtoken_hash(const unsigned char *string, unsigned int length)
   uint32_t hash = InitialFNV;
 
   for (size_t i = 0; i < length; i++)  {
-      hash = hash ^ (toupper(string[i])); 
-      hash = hash * FNVMultiple;          
+      hash = hash ^ (string[i] & 0xDF);
+      hash = hash * FNVMultiple;
   }
 
   return hash;
 }
 
-/*-------------------------------------------------------------------------
-  -------------------------------------------------------------------------*/
-
-static const char *_hdrtoken_commonly_tokenized_strs[] = {
-  // MIME Field names
-  "Accept-Charset",
-  "Accept-Encoding",
-  "Accept-Language",
-  "Accept-Ranges",
-  "Accept",
-  "Age",
-  "Allow",
-  "Approved",                   // NNTP
-  "Authorization",
-  "Bytes",                      // NNTP
-  "Cache-Control",
-  "Client-ip",
-  "Connection",
-  "Content-Base",
-  "Content-Encoding",
-  "Content-Language",
-  "Content-Length",
-  "Content-Location",
-  "Content-MD5",
-  "Content-Range",
-  "Content-Type",
-  "Control",                    // NNTP
-  "Cookie",
-  "Date",
-  "Distribution",               // NNTP
-  "Etag",
-  "Expect",
-  "Expires",
-  "Followup-To",                // NNTP
-  "From",
-  "Host",
-  "If-Match",
-  "If-Modified-Since",
-  "If-None-Match",
-  "If-Range",
-  "If-Unmodified-Since",
-  "Keep-Alive",
-  "Keywords",                   // NNTP
-  "Last-Modified",
-  "Lines",                      // NNTP
-  "Location",
-  "Max-Forwards",
-  "Message-ID",                 // NNTP
-  "MIME-Version",
-  "Newsgroups",                 // NNTP
-  "Organization",               // NNTP
-  "Path",                       // NNTP
-  "Pragma",
-  "Proxy-Authenticate",
-  "Proxy-Authorization",
-  "Proxy-Connection",
-  "Public",
-  "Range",
-  "References",                 // NNTP
-  "Referer",
-  "Reply-To",                   // NNTP
-  "Retry-After",
-  "Sender",                     // NNTP
-  "Server",
-  "Set-Cookie",
-  "Subject",                    // NNTP
-  "Summary",                    // NNTP
-  "Transfer-Encoding",
-  "Upgrade",
-  "User-Agent",
-  "Vary",
-  "Via",
-  "Warning",
-  "Www-Authenticate",
-  "Xref",                       // NNTP
-  "@DataInfo",                  // Internal Hack
-  
-  // Accept-Encoding
-  "compress",
-  "deflate",
-  "gzip",
-  "identity",
-  
-  // Cache-Control flags
-  "max-age",
-  "max-stale",
-  "min-fresh",
-  "must-revalidate",
-  "no-cache",
-  "no-store",
-  "no-transform",
-  "only-if-cached",
-  "private",
-  "proxy-revalidate",
-  "s-maxage",
-  "need-revalidate-once",
-  
-  // HTTP miscellaneous
-  "none",
-  "chunked",
-  "close",
-  
-  // WS
-  "websocket",
-  "Sec-WebSocket-Key",
-  "Sec-WebSocket-Version",
+inline uint32_t
+hash_to_slot(uint32_t hash, uint32_t disp)
+{
+  return ((hash ^ disp) * 0x9E3779B1U) >> (32 - HDRTOKEN_HASH_TABLE_BITS);
+}
 
-  // URL schemes
-  "file",
-  "ftp",
-  "gopher",
-  "https",
-  "http",
-  "mailto",
-  "news",
-  "nntp",
-  "prospero",
-  "telnet",
-  "tunnel",
-  "wais",
-  "pnm",
-  "rtspu",
-  "rtsp",
-  "mmsu",
-  "mmst",
-  "mms",
-  "wss",
-  "ws",
-  
-  // HTTP methods
-  "CONNECT",
-  "DELETE",
-  "GET",
-  "POST",
-  "HEAD",
-  "ICP_QUERY",
-  "OPTIONS",
-  "PURGE",
-  "PUT",
-  "TRACE",
-  "PUSH",
-  
-  // Header extensions
-  "X-ID",
-  "X-Forwarded-For",
-  "TE",
-  "Strict-Transport-Security",
-  "100-continue"
-};
 
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
@@ -538,34 +392,60 @@ static const char *_hdrtoken_commonly_tokenized_strs[] = {
 void
 hdrtoken_hash_init()
 {
-  uint32_t i;
-  int num_collisions;
-
-  memset(hdrtoken_hash_table, 0, sizeof(hdrtoken_hash_table));
-  num_collisions = 0;
-
-  for (i = 0; i < (int) SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
-    // convert the common string to the well-known token
-    unsigned const char *wks;
-    int wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_commonly_tokenized_strs[i],
-                                        (int) strlen(_hdrtoken_commonly_tokenized_strs[i]),
-                                        (const char **) &wks);
-    ink_release_assert(wks_idx >= 0);
-
-    uint32_t hash = hdrtoken_hash(wks, hdrtoken_str_lengths[wks_idx]);
-    uint32_t slot = hash_to_slot(hash);
-
-    if (hdrtoken_hash_table[slot].wks) {
-      printf("ERROR: hdrtoken_hash_table[%u] collision: '%s' replacing '%s'\n",
-             slot, (const char*)wks, hdrtoken_hash_table[slot].wks);
-      ++num_collisions;
-    }
-    hdrtoken_hash_table[slot].wks = (const char *)wks;
-    hdrtoken_hash_table[slot].hash = hash;
+  int nwks = (int) SIZEOF(_hdrtoken_strs);
+  uint32_t hash[SIZEOF(_hdrtoken_strs)];
+  int bucket_size[HDRTOKEN_HASH_BUCKETS];
+  int order[HDRTOKEN_HASH_BUCKETS];
+  int i, b;
+
+  ink_release_assert(nwks <= HDRTOKEN_HASH_TABLE_SIZE / 2);
+  memset(hdrtoken_hash_table, 0xFF, sizeof(hdrtoken_hash_table));
+  memset(bucket_size, 0, sizeof(bucket_size));
+
+  for (i = 0; i < nwks; i++) {
+    hash[i] = hdrtoken_hash((const unsigned char *)hdrtoken_strs[i], hdrtoken_str_lengths[i]);
+    ++bucket_size[hash[i] % HDRTOKEN_HASH_BUCKETS];
+  }
+  for (b = 0; b < HDRTOKEN_HASH_BUCKETS; b++) {
+    int j = b;
+    for (; j > 0 && bucket_size[order[j - 1]] < bucket_size[b]; j--)
+      order[j] = order[j - 1];
+    order[j] = b;
   }
 
-  if (num_collisions > 0)
-    abort();
+  for (int k = 0; k < HDRTOKEN_HASH_BUCKETS && bucket_size[order[k]]; k++) {
+    uint32_t slots[SIZEOF(_hdrtoken_strs)];
+    uint32_t disp;
+    int n = 0;
+
+    b = order[k];
+    for (disp = 0; disp < HDRTOKEN_HASH_MAX_DISP; disp++) {
+      for (n = 0, i = 0; i < nwks; i++) {
+        if ((int) (hash[i] % HDRTOKEN_HASH_BUCKETS) != b)
+          continue;
+        uint32_t slot = hash_to_slot(hash[i], disp);
+        if (hdrtoken_hash_table[slot] >= 0)
+          break;
+        int m = 0;
+        while (m < n && slots[m] != slot)
+          ++m;
+        if (m < n)
+          break;
+        slots[n++] = slot;
+      }
+      if (i == nwks)
+        break;
+    }
+    if (disp == HDRTOKEN_HASH_MAX_DISP) {
+      printf("ERROR: no perfect hash for the %d well-known strings of bucket %d\n", bucket_size[b], b);
+      abort();
+    }
+    hdrtoken_hash_disp[b] = disp;
+    for (i = 0; i < nwks; i++) {
+      if ((int) (hash[i] % HDRTOKEN_HASH_BUCKETS) == b)
+        hdrtoken_hash_table[hash_to_slot(hash[i], disp)] = i;
+    }
+  }
 }
 
 
@@ -716,7 +596,6 @@ int
 hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_out)
 {
   int wks_idx;
-  HdrTokenHashBucket *bucket;
 
   ink_assert(string != NULL);
 
@@ -728,15 +607,13 @@ hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_ou
   }
 
   uint32_t hash = hdrtoken_hash((const unsigned char *) string, (unsigned int) string_len);
-  uint32_t slot = hash_to_slot(hash);
+  wks_idx = hdrtoken_hash_table[hash_to_slot(hash, hdrtoken_hash_disp[hash % HDRTOKEN_HASH_BUCKETS])];
 
-  bucket = &(hdrtoken_hash_table[slot]);
-  if ((bucket->wks != NULL) &&
-      (bucket->hash == hash) &&
-      (hdrtoken_wks_to_length(bucket->wks) == string_len)) {
-    wks_idx = hdrtoken_wks_to_index(bucket->wks);
+  if ((wks_idx >= 0) &&
+      (hdrtoken_str_lengths[wks_idx] == string_len) &&
+      !strncasecmp(string, hdrtoken_strs[wks_idx], string_len)) {
     if (wks_string_out)
-      *wks_string_out = bucket->wks;
+      *wks_string_out = hdrtoken_strs[wks_idx];
     return wks_idx;
   }
 
@@ -2050,10 +2050,14 @@ mime_field_value_set(HdrHeap *heap,
 
   heap->free_string(field->m_ptr_value, field->m_len_value);
 
-  if (must_copy_string && value)
-    field->m_ptr_value = heap->duplicate_str(value, length);
-  else
+  if (must_copy_string && value) {
+    // The URL may share the Host value, keep it in the heap
+    field->m_ptr_value = (field->m_wks_idx != MIME_WKSIDX_HOST) ? heap->intern_str(value, length) : NULL;
+    if (field->m_ptr_value == NULL)
+      field->m_ptr_value = heap->duplicate_str(value, length);
+  } else {
     field->m_ptr_value = value;
+  }
 
   field->m_len_value = length;
   field->m_n_v_raw_printable = 0;
@@ -2535,23 +2539,37 @@ mime_parser_parse(MIMEParser *parser, HdrHeap *heap, MIMEHdrImpl *mh, const char
 
     int total_line_length = (int) (field_line_last - field_line_first + 1);
 
+    ///////////////////////
+    // tokenize the name //
+    ///////////////////////
+
+    int field_name_wks_idx = hdrtoken_tokenize(field_name_first, field_name_length);
+
     //////////////////////////////////////////////////////////////////////
     // if we can't leave the name & value in the real buffer, copy them //
     //////////////////////////////////////////////////////////////////////
 
+    int n_v_raw_printable = true;
+
     if (must_copy_strings || (!line_is_real)) {
-      int length = total_line_length;
-      char *dup = heap->duplicate_str(field_name_first, length);
-      intptr_t delta = dup - field_name_first;
+      // The URL may share the Host value, keep it in the heap
+      const char *interned = (field_name_wks_idx != MIME_WKSIDX_HOST) ?
+        heap->intern_str(field_value_first, field_value_length) : NULL;
+
+      if (interned) {
+        // Only the name is copied, so the line can't be printed raw
+        field_name_first = heap->duplicate_str(field_name_first, field_name_length);
+        field_value_first = interned;
+        n_v_raw_printable = false;
+      } else {
+        int length = total_line_length;
+        char *dup = heap->duplicate_str(field_name_first, length);
+        intptr_t delta = dup - field_name_first;
 
-      field_name_first += delta;
-      field_value_first += delta;
+        field_name_first += delta;
+        field_value_first += delta;
+      }
     }
-    ///////////////////////
-    // tokenize the name //
-    ///////////////////////
-
-    int field_name_wks_idx = hdrtoken_tokenize(field_name_first, field_name_length);
 
     ///////////////////////////////////////////
     // build and insert the new field object //
@@ -2562,7 +2580,7 @@ mime_parser_parse(MIMEParser *parser, HdrHeap *heap, MIMEHdrImpl *mh, const char
     mime_field_name_value_set(heap, mh, field,
                               field_name_wks_idx,
                               field_name_first, field_name_length,
-                              field_value_first, field_value_length, true, total_line_length, 0);
+                              field_value_first, field_value_length, n_v_raw_printable, total_line_length, 0);
     mime_hdr_field_attach(mh, field, 1, NULL);
   }
 }
@@ -3595,9 +3613,11 @@ MIMEFieldBlockImpl::unmarshal(intptr_t offset)
   }
 }
 
-void
-MIMEFieldBlockImpl::move_strings(HdrStrHeap *new_heap)
+int
+MIMEFieldBlockImpl::move_strings(HdrStrHeap *new_heap, bool keep_interned)
 {
+  int interned = 0;
+
   for (uint32_t index = 0; index < m_freetop; index++) {
     MIMEField *field = &(m_field_slots[index]);
 
@@ -3607,9 +3627,44 @@ MIMEFieldBlockImpl::move_strings(HdrStrHeap *new_heap)
       field->m_n_v_raw_printable = 0;
 
       HDR_MOVE_STR(field->m_ptr_name, field->m_len_name);
-      HDR_MOVE_STR(field->m_ptr_value, field->m_len_value);
+
+      const char *interned_value = NULL;
+      if (keep_interned && field->m_ptr_value && field->m_wks_idx != MIME_WKSIDX_HOST) {
+        interned_value = hdr_str_interned(field->m_ptr_value) ? field->m_ptr_value :
+          hdr_intern_lookup(field->m_ptr_value, field->m_len_value);
+      }
+      if (interned_value) {
+        field->m_ptr_value = interned_value;
+        interned++;
+      } else {
+        HDR_MOVE_STR(field->m_ptr_value, field->m_len_value);
+      }
     }
   }
+
+  return interned;
+}
+
+// Copies the interned values to dest and points the fields at the
+//  copies.  With a NULL dest only counts the bytes needed.
+int
+MIMEFieldBlockImpl::release_interned_strs(char *dest)
+{
+  int len = 0;
+
+  for (uint32_t index = 0; index < m_freetop; index++) {
+    MIMEField *field = &(m_field_slots[index]);
+
+    if ((field->is_live() || field->is_detached()) && hdr_str_interned(field->m_ptr_value)) {
+      if (dest) {
+        memcpy(dest + len, field->m_ptr_value, field->m_len_value);
+        field->m_ptr_value = dest + len;
+      }
+      len += field->m_len_value;
+    }
+  }
+
+  return len;
 }
 
 size_t
@@ -3658,10 +3713,10 @@ MIMEHdrImpl::unmarshal(intptr_t offset)
   m_first_fblock.unmarshal(offset);
 }
 
-void
-MIMEHdrImpl::move_strings(HdrStrHeap *new_heap)
+int
+MIMEHdrImpl::move_strings(HdrStrHeap *new_heap, bool keep_interned)
 {
-  m_first_fblock.move_strings(new_heap);
+  return m_first_fblock.move_strings(new_heap, keep_interned);
 }
 
 size_t
@@ -169,8 +169,9 @@ struct MIMEFieldBlockImpl:public HdrHeapObjImpl
   // Marshaling Functions
   int marshal(MarshalXlate * ptr_xlate, int num_ptr, MarshalXlate * str_xlate, int num_str);
   void unmarshal(intptr_t offset);
-  void move_strings(HdrStrHeap * new_heap);
+  int move_strings(HdrStrHeap * new_heap, bool keep_interned = false);
   size_t strings_length();
+  int release_interned_strs(char *dest);
 
   // Sanity Check Functions
   void check_strings(HeapCheck * heaps, int num_heaps);
@@ -242,7 +243,7 @@ struct MIMEHdrImpl:public HdrHeapObjImpl
   // Marshaling Functions
   int marshal(MarshalXlate * ptr_xlate, int num_ptr, MarshalXlate * str_xlate, int num_str);
   void unmarshal(intptr_t offset);
-  void move_strings(HdrStrHeap * new_heap);
+  int move_strings(HdrStrHeap * new_heap, bool keep_interned = false);
   size_t strings_length();
 
   // Sanity Check Functions
@@ -28,6 +28,7 @@
 #include "MIME.h"
 #include "HTTP.h"
 #include "Diags.h"
+#include "HdrScan.h"
 
 const char *URL_SCHEME_FILE;
 const char *URL_SCHEME_FTP;
@@ -108,6 +109,9 @@ URLHashContext::URLHashContext() {
   case MMH:
     new(_obj) MMHContext;
     break;
+  case MURMUR3:
+    new(_obj) Murmur3Context;
+    break;
   default: ink_assert("Invalid global URL hash context");
   };
 }
@@ -209,6 +213,7 @@ url_init()
 
     ink_assert(URLHashContext::OBJ_SIZE >= sizeof(MD5Context));
     ink_assert(URLHashContext::OBJ_SIZE >= sizeof(MMHContext));
+    ink_assert(URLHashContext::OBJ_SIZE >= sizeof(Murmur3Context));
 
   }
 }
@@ -1314,7 +1319,6 @@ url_parse_http(HdrHeap * heap, URLImpl * url, const char **start, const char *en
   const char *query_end = NULL;
   const char *fragment_start = NULL;
   const char *fragment_end = NULL;
-  char mask;
 
   err = url_parse_internet(heap, url, start, end, copy_strings);
   if (err < 0)
@@ -1325,52 +1329,36 @@ url_parse_http(HdrHeap * heap, URLImpl * url, const char **start, const char *en
     goto done;
 
   path_start = cur;
-  mask = ';' & '?' & '#';
-parse_path2:
-  if ((*cur & mask) == mask) {
-    if (*cur == ';') {
-      path_end = cur;
-      goto parse_params1;
-    }
-    if (*cur == '?') {
-      path_end = cur;
-      goto parse_query1;
-    }
-    if (*cur == '#') {
-      path_end = cur;
-      goto parse_fragment1;
-    }
-  } else {
-    ink_assert((*cur != ';') && (*cur != '?') && (*cur != '#'));
-  }
-  GETNEXT(done);
-  goto parse_path2;
+  cur = hdr_scan_for(cur, end, ';', '?', '#');
+  if (cur >= end)
+    goto done;
+  path_end = cur;
+  if (*cur == ';')
+    goto parse_params1;
+  if (*cur == '?')
+    goto parse_query1;
+  goto parse_fragment1;
 
 parse_params1:
   params_start = cur + 1;
   GETNEXT(done);
-parse_params2:
-  if (*cur == '?') {
-    params_end = cur;
+  cur = hdr_scan_for(cur, end, '?', '#', '#');
+  if (cur >= end)
+    goto done;
+  params_end = cur;
+  if (*cur == '?')
     goto parse_query1;
-  }
-  if (*cur == '#') {
-    params_end = cur;
-    goto parse_fragment1;
-  }
-  GETNEXT(done);
-  goto parse_params2;
+  goto parse_fragment1;
 
 parse_query1:
   query_start = cur + 1;
   GETNEXT(done);
-parse_query2:
-  if (*cur == '#') {
-    query_end = cur;
-    goto parse_fragment1;
+  cur = static_cast<const char *>(memchr(cur, '#', end - cur));
+  if (!cur) {
+    cur = end;
+    goto done;
   }
-  GETNEXT(done);
-  goto parse_query2;
+  query_end = cur;
 
 parse_fragment1:
   fragment_start = cur + 1;
@@ -99,7 +99,7 @@ public:
   /// Finalize and extract the @a hash.
   virtual bool finalize(CryptoHash& hash);
 
-  enum HashType { UNSPECIFIED, MD5, MMH }; ///< What type of hash we really are.
+  enum HashType { UNSPECIFIED, MD5, MMH, MURMUR3 }; ///< What type of hash we really are.
   static HashType Setting;
 
   /// Size of storage for placement @c new of hashing context.
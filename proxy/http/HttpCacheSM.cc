@@ -57,6 +57,7 @@ HttpCacheAction::cancel(Continuation * c)
   ink_assert(this->cancelled == 0);
 
   this->cancelled = 1;
+  sm->collapse_release();
   if (sm->pending_action)
     sm->pending_action->cancel();
 }
@@ -71,10 +72,180 @@ HttpCacheSM::HttpCacheSM():
   open_read_cb(false), open_write_cb(false), open_read_tries(0),
   read_request_hdr(NULL), read_config(NULL),
   read_pin_in_cache(0), retry_write(true), open_write_tries(0),
-  lookup_url(NULL), lookup_max_recursive(0), current_lookup_level(0)
+  lookup_url(NULL), lookup_max_recursive(0), current_lookup_level(0),
+  collapse_entry(NULL), collapse_bucket(0), collapse_leader(false),
+  collapse_waiting(false), collapse_waited(false), collapse_thread(NULL), collapse_wake(NULL)
 {
 }
 
+//////////////////////////////////////////////////////////////////////////
+//
+//  Collapsing of concurrent misses
+//
+//  The first state machine to miss on a cache key becomes the leader
+//  and goes to the origin server, the ones missing after it wait on
+//  its entry in the table below. Once the leader has decided what to
+//  write to the cache, or failed, it removes the entry and wakes the
+//  waiters on their own threads, and they look the cache up again.
+//  By then the leader's write has its headers, so with read while
+//  writer they read the object as it arrives. A waiter gives up on
+//  the leader after collapse_timeout and only ever waits once, so a
+//  second miss goes to the origin server.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#define HTTP_COLLAPSE_BUCKETS 256
+
+struct HttpCollapseEntry
+{
+  INK_MD5 key;
+  DLL<HttpCacheSM, HttpCacheSM::Link_collapse_link> waiters;
+  LINK(HttpCollapseEntry, link);
+};
+
+struct HttpCollapseBucket
+{
+  HttpCollapseBucket()
+  {
+    ink_mutex_init(&lock, "HttpCollapseBucket");
+  }
+
+  ink_mutex lock;
+  DLL<HttpCollapseEntry> entries;
+};
+
+static HttpCollapseBucket collapse_table[HTTP_COLLAPSE_BUCKETS];
+
+// Called on a miss, or on a busy document we are not going to wait
+//   for otherwise. Returns true if we wait for a leader.
+bool
+HttpCacheSM::collapse_miss(bool busy)
+{
+  if (!master_sm->t_state.http_config_param->cache_collapse_misses || collapse_waited)
+    return false;
+
+  // A new lookup, e.g. after a redirect, no longer leads the old one
+  collapse_release();
+
+  INK_MD5 key;
+  HttpCollapseEntry *e;
+
+  lookup_url->hash_get(&key);
+  collapse_bucket = key.fold() % HTTP_COLLAPSE_BUCKETS;
+  HttpCollapseBucket *bucket = &collapse_table[collapse_bucket];
+
+  ink_mutex_acquire(&bucket->lock);
+  for (e = bucket->entries.head; e; e = e->link.next) {
+    if (e->key == key)
+      break;
+  }
+  if (e == NULL) {
+    // Somebody writing without leading is not worth waiting for
+    if (!busy) {
+      e = new HttpCollapseEntry;
+      e->key = key;
+      bucket->entries.push(e);
+      collapse_entry = e;
+      collapse_leader = true;
+    }
+    ink_mutex_release(&bucket->lock);
+    return false;
+  }
+  e->waiters.push(this);
+  collapse_entry = e;
+  collapse_waiting = true;
+  collapse_waited = true;
+  collapse_thread = this_ethread();
+  ink_mutex_release(&bucket->lock);
+
+  Debug("http_cache", "[%" PRId64 "] [collapse_miss] waiting for the leader", master_sm->sm_id);
+  HTTP_INCREMENT_DYN_STAT(http_cache_collapsed_stat);
+  open_read_cb = false;
+  SET_HANDLER(&HttpCacheSM::state_collapse_wait);
+  pending_action =
+    mutex->thread_holding->schedule_in(this, HRTIME_MSECONDS(master_sm->t_state.http_config_param->cache_collapse_timeout));
+  return true;
+}
+
+void
+HttpCacheSM::do_collapse_release()
+{
+  HttpCollapseBucket *bucket = &collapse_table[collapse_bucket];
+  bool waiting = collapse_waiting;
+  HttpCacheSM *w;
+
+  ink_mutex_acquire(&bucket->lock);
+  if (collapse_leader) {
+    bucket->entries.remove(collapse_entry);
+    while ((w = collapse_entry->waiters.pop())) {
+      w->collapse_entry = NULL;
+      w->collapse_wake = w->collapse_thread->schedule_imm(w);
+    }
+    delete collapse_entry;
+    collapse_leader = false;
+  } else {
+    if (collapse_entry)
+      collapse_entry->waiters.remove(this);
+    // We hold our mutex, so a wake up not yet delivered can be cancelled
+    if (collapse_wake) {
+      collapse_wake->cancel();
+      collapse_wake = NULL;
+    }
+    collapse_waiting = false;
+  }
+  collapse_entry = NULL;
+  ink_mutex_release(&bucket->lock);
+
+  // The timeout
+  if (waiting && pending_action) {
+    pending_action->cancel();
+    pending_action = NULL;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+//
+//  HttpCacheSM::state_collapse_wait()
+//
+//  Waiting for the leader of a miss. The events are:
+// - EVENT_IMMEDIATE
+//   - the leader is done, look up the cache again
+// - EVENT_INTERVAL
+//   - the leader took longer than collapse_timeout, look up the
+//     cache again and go to the origin server if it still misses
+//
+//////////////////////////////////////////////////////////////////////////
+int
+HttpCacheSM::state_collapse_wait(int event, void * /* data ATS_UNUSED */)
+{
+  STATE_ENTER(&HttpCacheSM::state_collapse_wait, event);
+  ink_assert(captive_action.cancelled == 0);
+
+  switch (event) {
+  case EVENT_IMMEDIATE:
+    ink_mutex_acquire(&collapse_table[collapse_bucket].lock);
+    collapse_wake = NULL;
+    ink_mutex_release(&collapse_table[collapse_bucket].lock);
+    break;
+
+  case EVENT_INTERVAL:
+    pending_action = NULL;
+    HTTP_INCREMENT_DYN_STAT(http_cache_collapse_timeouts_stat);
+    Debug("http_cache", "[%" PRId64 "] [state_collapse_wait] timed out waiting for the leader", master_sm->sm_id);
+    break;
+
+  default:
+    ink_release_assert(0);
+  }
+
+  // Cancels the timeout or a wake up still pending
+  collapse_release();
+  SET_HANDLER(&HttpCacheSM::state_cache_open_read);
+  do_cache_open_read();
+
+  return EVENT_DONE;
+}
+
 //////////////////////////////////////////////////////////////////////////
 //
 //  HttpCacheSM::state_cache_open_read()
@@ -126,13 +297,19 @@ HttpCacheSM::state_cache_open_read(int event, void *data)
         open_read_cb = false;
         do_schedule_in();
       } else {
-        // Give up; the update didn't finish in time
+        // Give up; the update didn't finish in time, unless
+        // the writer leads a collapsed miss we can wait for.
         // HttpSM will inform HttpTransact to 'proxy-only'
+        if (collapse_miss(true))
+          break;
         open_read_cb = true;
         master_sm->handleEvent(event, data);
       }
     } else {
-      // Simple miss in the cache.
+      // Simple miss in the cache, wait if somebody else
+      // is already fetching the document.
+      if (data == (void *) -ECACHE_NO_DOC && collapse_miss(false))
+        break;
       open_read_cb = true;
       master_sm->handleEvent(event, data);
     }
@@ -175,6 +352,9 @@ HttpCacheSM::state_cache_open_write(int event, void *data)
   case CACHE_EVENT_OPEN_WRITE_FAILED:
     // The cache is hosed or full or something.
     // Forward the failure to the main sm
+    if ((intptr_t) data == -ECACHE_NOT_ADMITTED)
+      master_sm->t_state.cache_info.not_admitted = true;
+    collapse_release();
     open_write_cb = true;
     master_sm->handleEvent(event, data);
     break;
@@ -294,10 +474,19 @@ HttpCacheSM::open_write(URL * url, HTTPHdr * request, CacheHTTPInfo * old_info,
   // Changed by YTS Team, yamsat Plugin
   if (open_write_tries > master_sm->redirection_tries &&
       open_write_tries > master_sm->t_state.http_config_param->max_cache_open_write_retries) {
+    collapse_release();
     master_sm->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *) -ECACHE_DOC_BUSY);
     return ACTION_RESULT_DONE;
   }
 
+  // A transaction is counted by cache admission once, so that writing the
+  // transformed copy as well doesn't admit a document on its first request.
+  if (master_sm->t_state.cache_info.not_admitted && !old_info) {
+    collapse_release();
+    master_sm->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *) -ECACHE_NOT_ADMITTED);
+    return ACTION_RESULT_DONE;
+  }
+
   Action *action_handle = cacheProcessor.open_write(this,
                                                     0,
                                                     url,
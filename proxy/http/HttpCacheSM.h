@@ -43,6 +43,7 @@
 class HttpSM;
 class HttpCacheSM;
 class CacheLookupHttpConfig;
+struct HttpCollapseEntry;
 
 struct HttpCacheAction:public Action
 {
@@ -105,6 +106,7 @@ public:
   }
   inline void abort_write()
   {
+    collapse_release();
     if (cache_write_vc) {
       HTTP_DECREMENT_DYN_STAT(http_current_cache_connections_stat);
       cache_write_vc->do_io(VIO::ABORT);
@@ -113,6 +115,7 @@ public:
   }
   inline void close_write()
   {
+    collapse_release();
     if (cache_write_vc) {
       HTTP_DECREMENT_DYN_STAT(http_current_cache_connections_stat);
       cache_write_vc->do_io(VIO::CLOSE);
@@ -143,6 +146,16 @@ public:
     lookup_url = url;
   }
 
+  // Concurrent misses on the same cache key wait for the first one,
+  //   the leader, which wakes them once it knows what it writes to
+  //   the cache. Releasing either stops leading or stops waiting.
+  inline void collapse_release()
+  {
+    if (collapse_leader || collapse_waiting)
+      do_collapse_release();
+  }
+  LINK(HttpCacheSM, collapse_link);
+
 private:
 
   void do_schedule_in();
@@ -150,6 +163,10 @@ private:
 
   int state_cache_open_read(int event, void *data);
   int state_cache_open_write(int event, void *data);
+  int state_collapse_wait(int event, void *data);
+
+  bool collapse_miss(bool busy);
+  void do_collapse_release();
 
   HttpCacheAction captive_action;
   bool open_read_cb;
@@ -171,6 +188,16 @@ private:
   // to keep track of multiple cache lookups
   int lookup_max_recursive;
   int current_lookup_level;
+
+  // Collapsing of misses. The entry and wake event of a waiting
+  //   state machine change under the lock of its bucket.
+  HttpCollapseEntry *collapse_entry;
+  int collapse_bucket;
+  bool collapse_leader;
+  bool collapse_waiting;
+  bool collapse_waited;
+  EThread *collapse_thread;
+  Event *collapse_wake;
 };
 
 #endif
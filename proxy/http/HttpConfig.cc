@@ -58,6 +58,7 @@
 
 
 RecRawStatBlock *http_rsb;
+RecHistogram *http_latency[http_latency_phases];
 #define HTTP_CLEAR_DYN_STAT(x) \
 do { \
 	RecSetRawStatSum(http_rsb, x, 0); \
@@ -491,6 +492,22 @@ register_stat_callbacks()
                      "proxy.process.http.cache_deletes",
                      RECD_COUNTER, RECP_PERSISTENT, (int) http_cache_deletes_stat, RecRawStatSyncCount);
 
+  RecRegisterRawStat(http_rsb, RECT_PROCESS,
+                     "proxy.process.http.cache_collapsed",
+                     RECD_COUNTER, RECP_PERSISTENT, (int) http_cache_collapsed_stat, RecRawStatSyncCount);
+
+  RecRegisterRawStat(http_rsb, RECT_PROCESS,
+                     "proxy.process.http.cache_collapse_timeouts",
+                     RECD_COUNTER, RECP_PERSISTENT, (int) http_cache_collapse_timeouts_stat, RecRawStatSyncCount);
+
+  RecRegisterRawStat(http_rsb, RECT_PROCESS,
+                     "proxy.process.http.speculative_dns_lookups",
+                     RECD_COUNTER, RECP_PERSISTENT, (int) http_speculative_dns_lookups_stat, RecRawStatSyncCount);
+
+  RecRegisterRawStat(http_rsb, RECT_PROCESS,
+                     "proxy.process.http.origin_prewarm_connections",
+                     RECD_COUNTER, RECP_PERSISTENT, (int) http_origin_prewarm_connections_stat, RecRawStatSyncCount);
+
   RecRegisterRawStat(http_rsb, RECT_PROCESS,
                      "proxy.process.http.tunnels",
                      RECD_COUNTER, RECP_PERSISTENT, (int) http_tunnels_stat, RecRawStatSyncCount);
@@ -1198,12 +1215,24 @@ register_stat_callbacks()
                      RECD_COUNTER, RECP_PERSISTENT,
                      (int) http_total_x_redirect_stat, RecRawStatSyncCount);
 
+  RecRegisterRawStat(http_rsb, RECT_PROCESS,
+                     "proxy.process.http.origin_connection_count_contention",
+                     RECD_COUNTER, RECP_PERSISTENT,
+                     (int) http_origin_connection_count_contention_stat, RecRawStatSyncCount);
+
   RecRegisterRawStat(http_rsb, RECT_PROCESS,
                      "proxy.process.https.incoming_requests",
                      RECD_COUNTER, RECP_PERSISTENT, (int) https_incoming_requests_stat, RecRawStatSyncCount);
   RecRegisterRawStat(http_rsb, RECT_PROCESS,
                      "proxy.process.https.total_client_connections",
                      RECD_COUNTER, RECP_PERSISTENT, (int) https_total_client_connections_stat, RecRawStatSyncCount);
+
+  // Latency histograms
+  http_latency[http_latency_dns] = RecAllocateHistogram("proxy.process.http.latency.dns");
+  http_latency[http_latency_connect] = RecAllocateHistogram("proxy.process.http.latency.connect");
+  http_latency[http_latency_origin_first_byte] = RecAllocateHistogram("proxy.process.http.latency.origin_first_byte");
+  http_latency[http_latency_cache_open_read] = RecAllocateHistogram("proxy.process.http.latency.cache_open_read");
+  http_latency[http_latency_total] = RecAllocateHistogram("proxy.process.http.latency.total");
 }
 
 
@@ -1246,6 +1275,8 @@ HttpConfig::startup()
   HttpEstablishStaticConfigLongLong(c.oride.server_tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
   HttpEstablishStaticConfigLongLong(c.oride.origin_max_connections, "proxy.config.http.origin_max_connections");
   HttpEstablishStaticConfigLongLong(c.origin_min_keep_alive_connections, "proxy.config.http.origin_min_keep_alive_connections");
+  HttpEstablishStaticConfigLongLong(c.origin_prewarm_max_sessions, "proxy.config.http.origin_prewarm.max_sessions");
+  HttpEstablishStaticConfigLongLong(c.origin_prewarm_window, "proxy.config.http.origin_prewarm.window");
   HttpEstablishStaticConfigLongLong(c.attach_server_session_to_client, "proxy.config.http.attach_server_session_to_client");
 
   HttpEstablishStaticConfigByte(c.parent_proxy_routing_enable, "proxy.config.http.parent_proxy_routing_enable");
@@ -1255,6 +1286,7 @@ HttpConfig::startup()
   HttpEstablishStaticConfigByte(c.no_dns_forward_to_parent, "proxy.config.http.no_dns_just_forward_to_parent");
   HttpEstablishStaticConfigByte(c.uncacheable_requests_bypass_parent, "proxy.config.http.uncacheable_requests_bypass_parent");
   HttpEstablishStaticConfigByte(c.oride.doc_in_cache_skip_dns, "proxy.config.http.doc_in_cache_skip_dns");
+  HttpEstablishStaticConfigByte(c.oride.speculative_dns, "proxy.config.http.speculative_dns");
 
   HttpEstablishStaticConfigByte(c.no_origin_server_dns, "proxy.config.http.no_origin_server_dns");
   HttpEstablishStaticConfigByte(c.use_client_target_addr, "proxy.config.http.use_client_target_addr");
@@ -1383,6 +1415,10 @@ HttpConfig::startup()
   // open write failure retries
   HttpEstablishStaticConfigLongLong(c.max_cache_open_write_retries, "proxy.config.http.cache.max_open_write_retries");
 
+  // collapsing of concurrent misses
+  HttpEstablishStaticConfigByte(c.cache_collapse_misses, "proxy.config.http.cache.collapse_misses");
+  HttpEstablishStaticConfigLongLong(c.cache_collapse_timeout, "proxy.config.http.cache.collapse_timeout");
+
   HttpEstablishStaticConfigByte(c.oride.cache_http, "proxy.config.http.cache.http");
   HttpEstablishStaticConfigByte(c.oride.cache_cluster_cache_local, "proxy.config.http.cache.cluster_cache_local");
   HttpEstablishStaticConfigByte(c.oride.cache_ignore_client_no_cache, "proxy.config.http.cache.ignore_client_no_cache");
@@ -1515,6 +1551,8 @@ HttpConfig::reconfigure()
   params->oride.server_tcp_init_cwnd = m_master.oride.server_tcp_init_cwnd;
   params->oride.origin_max_connections = m_master.oride.origin_max_connections;
   params->origin_min_keep_alive_connections = m_master.origin_min_keep_alive_connections;
+  params->origin_prewarm_max_sessions = m_master.origin_prewarm_max_sessions;
+  params->origin_prewarm_window = m_master.origin_prewarm_window;
   params->attach_server_session_to_client = m_master.attach_server_session_to_client;
 
   if (params->oride.origin_max_connections &&
@@ -1641,6 +1679,10 @@ HttpConfig::reconfigure()
   // open write failure retries
   params->max_cache_open_write_retries = m_master.max_cache_open_write_retries;
 
+  // collapsing of concurrent misses
+  params->cache_collapse_misses = INT_TO_BOOL(m_master.cache_collapse_misses);
+  params->cache_collapse_timeout = m_master.cache_collapse_timeout;
+
   params->oride.cache_http = INT_TO_BOOL(m_master.oride.cache_http);
   params->oride.cache_cluster_cache_local = INT_TO_BOOL(m_master.oride.cache_cluster_cache_local);
   params->oride.cache_ignore_client_no_cache = INT_TO_BOOL(m_master.oride.cache_ignore_client_no_cache);
@@ -1682,6 +1724,7 @@ params->push_method_enabled = INT_TO_BOOL(m_master.push_method_enabled);
   params->record_cop_page = INT_TO_BOOL(m_master.record_cop_page);
   params->oride.send_http11_requests = m_master.oride.send_http11_requests;
   params->oride.doc_in_cache_skip_dns = INT_TO_BOOL(m_master.oride.doc_in_cache_skip_dns);
+  params->oride.speculative_dns = m_master.oride.speculative_dns;
   params->oride.default_buffer_size_index = m_master.oride.default_buffer_size_index;
   params->oride.default_buffer_water_mark = m_master.oride.default_buffer_water_mark;
   params->enable_http_info = INT_TO_BOOL(m_master.enable_http_info);
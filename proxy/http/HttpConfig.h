@@ -140,6 +140,10 @@ enum
   http_cache_writes_stat,
   http_cache_updates_stat,
   http_cache_deletes_stat,
+  http_cache_collapsed_stat,
+  http_cache_collapse_timeouts_stat,
+  http_speculative_dns_lookups_stat,
+  http_origin_prewarm_connections_stat,
 
   http_tunnels_stat,
   http_throttled_proxy_only_stat,
@@ -266,6 +270,8 @@ enum
 
   http_total_x_redirect_stat,
 
+  http_origin_connection_count_contention_stat,
+
   // Times
   http_total_transactions_time_stat,
   http_total_transactions_think_time_stat,
@@ -340,6 +346,22 @@ enum
 
 extern RecRawStatBlock *http_rsb;
 
+// Latency histograms of the transaction phases, from the milestones
+enum HttpLatencyPhase
+{
+  http_latency_dns,
+  http_latency_connect,
+  http_latency_origin_first_byte,
+  http_latency_cache_open_read,
+  http_latency_total,
+
+  http_latency_phases
+};
+
+extern RecHistogram *http_latency[http_latency_phases];
+
+#define HTTP_LATENCY(x, t) RecIncrHistogram(http_latency[x], mutex->thread_holding, t)
+
 /* Stats should only be accessed using these macros */
 #define HTTP_INCREMENT_DYN_STAT(x) RecIncrRawStat(http_rsb, mutex->thread_holding, (int) x, 1)
 #define HTTP_DECREMENT_DYN_STAT(x) RecIncrRawStat(http_rsb, mutex->thread_holding, (int) x, -1)
@@ -406,7 +428,7 @@ struct OverridableHttpConfigParams {
       cache_ignore_auth(0), cache_urls_that_look_dynamic(1), cache_required_headers(2),
       cache_range_lookup(1), cache_range_write(0),
       insert_request_via_string(1), insert_response_via_string(0), doc_in_cache_skip_dns(1),
-      flow_control_enabled(0), accept_encoding_filter_enabled(0), normalize_ae_gzip(0),
+      speculative_dns(0), flow_control_enabled(0), accept_encoding_filter_enabled(0), normalize_ae_gzip(0),
       negative_caching_lifetime(1800), negative_revalidating_lifetime(1800),
       sock_recv_buffer_size_out(0), sock_send_buffer_size_out(0), sock_option_flag_out(0),
       sock_packet_mark_out(0), sock_packet_tos_out(0), server_tcp_init_cwnd(0),
@@ -506,6 +528,7 @@ struct OverridableHttpConfigParams {
   //  DOC IN CACHE NO DNS//
   //////////////////////
   MgmtByte doc_in_cache_skip_dns;
+  MgmtByte speculative_dns;
   MgmtByte flow_control_enabled;
 
   ////////////////////////////////////////////////////////
@@ -653,6 +676,8 @@ public:
 
   MgmtInt server_max_connections;
   MgmtInt origin_min_keep_alive_connections; // TODO: This one really ought to be overridable, but difficult right now.
+  MgmtInt origin_prewarm_max_sessions;
+  MgmtInt origin_prewarm_window;
   MgmtInt attach_server_session_to_client;
 
   MgmtByte parent_proxy_routing_enable;
@@ -711,6 +736,10 @@ public:
   // open write failure retries.
   MgmtInt max_cache_open_write_retries;
 
+  // collapsing of concurrent misses on the same cache key.
+  MgmtByte cache_collapse_misses;
+  MgmtInt cache_collapse_timeout;       // time is in mseconds
+
   ///////////////////
   // cache control //
   ///////////////////
@@ -888,6 +917,8 @@ HttpConfigParams::HttpConfigParams()
     proxy_hostname_len(0),
     server_max_connections(0),
     origin_min_keep_alive_connections(0),
+    origin_prewarm_max_sessions(0),
+    origin_prewarm_window(100),
     parent_proxy_routing_enable(0),
     disable_ssl_parenting(0),
     enable_url_expandomatic(0),
@@ -917,6 +948,8 @@ HttpConfigParams::HttpConfigParams()
     cache_vary_default_images(NULL),
     cache_vary_default_other(NULL),
     max_cache_open_write_retries(1),
+    cache_collapse_misses(0),
+    cache_collapse_timeout(2000),
     cache_enable_default_vary_headers(0),
     cache_post_method(0),
     connect_ports_string(NULL),
@@ -22,6 +22,34 @@
  */
 
 #include "HttpConnectionCount.h"
+#include "HttpConfig.h"
 
 
 ConnectionCount ConnectionCount::_connectionCount;
+
+ConnectionCount::Counter *
+ConnectionCount::getCounter(const IpEndpoint& addr)
+{
+  ConnAddr caddr(addr);
+  // The IPv4 hash is just the address, mix it so that hosts in the same
+  // network don't all end up in the same shard.
+  uint32_t h = (uint32_t) ConnAddrHashFns::hash(caddr) * 0x9e3779b1;
+  Shard *shard = &_shards[(h >> 16) & (SHARDS - 1)];
+  Counter *counter;
+
+  if (!ink_mutex_try_acquire(&shard->_mutex)) {
+    EThread *t = this_ethread();
+
+    if (t) {
+      RecIncrRawStat(http_rsb, t, (int) http_origin_connection_count_contention_stat, 1);
+    }
+    ink_mutex_acquire(&shard->_mutex);
+  }
+  if ((counter = shard->_hostCount.get(caddr)) == NULL) {
+    counter = new Counter;
+    shard->_hostCount.put(caddr, counter);
+  }
+  ink_mutex_release(&shard->_mutex);
+
+  return counter;
+}
@@ -29,10 +29,25 @@
 
 /**
  * Singleton class to keep track of the number of connections per host
+ *
+ * The table is split in shards on the address hash, each with its own
+ * lock, and the count for a host is an atomic counter that is never
+ * freed once created. Only finding the counter takes a shard lock, callers
+ * which hold on to the counter (see HttpServerSession) can update it
+ * without locking at all.
  */
 class ConnectionCount
 {
 public:
+  /**
+   * Per host connection counter
+   */
+  struct Counter {
+    volatile int count;
+
+    Counter() : count(0) { }
+  };
+
   /**
    * Static method to get the instance of the class
    * @return Returns a pointer to the instance of the class
@@ -41,16 +56,20 @@ public:
     return &_connectionCount;
   }
 
+  /**
+   * Gets the counter for the host, creating it if needed
+   * @param ip IP address of the host
+   * @return The counter, valid for the lifetime of the process
+   */
+  Counter *getCounter(const IpEndpoint& addr);
+
   /**
    * Gets the number of connections for the host
    * @param ip IP address of the host
    * @return Number of connections
    */
   int getCount(const IpEndpoint& addr) {
-    ink_mutex_acquire(&_mutex);
-    int count = _hostCount.get(ConnAddr(addr));
-    ink_mutex_release(&_mutex);
-    return count;
+    return getCounter(addr)->count;
   }
 
   /**
@@ -59,11 +78,15 @@ public:
    * @param delta Default is +1, can be set to negative to decrement
    */
   void incrementCount(const IpEndpoint& addr, const int delta = 1) {
-    ConnAddr caddr(addr);
-    ink_mutex_acquire(&_mutex);
-    int count = _hostCount.get(caddr);
-    _hostCount.put(caddr, count + delta);
-    ink_mutex_release(&_mutex);
+    incrementCount(getCounter(addr), delta);
+  }
+
+  /**
+   * Change the connection count through a counter from getCounter()
+   * @return The new number of connections
+   */
+  static int incrementCount(Counter *counter, const int delta = 1) {
+    return ink_atomic_increment(&counter->count, delta) + delta;
   }
 
   struct ConnAddr {
@@ -82,15 +105,24 @@ public:
   };
 
 private:
+  // Number of shards in the table, a power of 2.
+  static const int SHARDS = 64;
+
+  struct Shard {
+    HashMap<ConnAddr, ConnAddrHashFns, Counter *> _hostCount;
+    ink_mutex _mutex;
+  };
+
   // Hide the constructor and copy constructor
   ConnectionCount() {
-    ink_mutex_init(&_mutex, "ConnectionCountMutex");
+    for (int i = 0; i < SHARDS; ++i) {
+      ink_mutex_init(&_shards[i]._mutex, "ConnectionCountMutex");
+    }
   }
   ConnectionCount(const ConnectionCount & /* x ATS_UNUSED */) { }
 
   static ConnectionCount _connectionCount;
-  HashMap<ConnAddr, ConnAddrHashFns, int> _hostCount;
-  ink_mutex _mutex;
+  Shard _shards[SHARDS];
 };
 
 #endif
@@ -321,7 +321,7 @@ HttpSM::HttpSM()
     server_buffer_reader(NULL),
     transform_info(), post_transform_info(), has_active_plugin_agents(false),
     second_cache_sm(NULL),
-    default_handler(NULL), pending_action(NULL), historical_action(NULL),
+    default_handler(NULL), pending_action(NULL), historical_action(NULL), speculative_dns(NULL),
     last_action(HttpTransact::SM_ACTION_UNDEFINED),
     // TODO:  Now that bodies can be empty, should the body counters be set to -1 ? TS-2213
     client_request_hdr_bytes(0), client_request_body_bytes(0),
@@ -2003,7 +2003,6 @@ HttpSM::process_srv_info(HostDBInfo * r)
 
   /* we didnt get any SRV records, continue w normal lookup */
   if (!r || !r->is_srv || !r->round_robin) {
-    t_state.dns_info.srv_hostname[0] = '\0';
     t_state.dns_info.srv_lookup_success = false;
     t_state.srv_lookup = false;
     DebugSM("dns_srv", "No SRV records were available, continuing to lookup %s", t_state.dns_info.lookup_name);
@@ -2011,12 +2010,13 @@ HttpSM::process_srv_info(HostDBInfo * r)
     HostDBRoundRobin *rr = r->rr();
     HostDBInfo *srv = NULL;
     if (rr) {
+      if (!t_state.dns_info.srv_hostname)
+        t_state.dns_info.srv_hostname = static_cast<char *>(t_state.arena.alloc(MAXDNAME, 1));
       srv = rr->select_best_srv(t_state.dns_info.srv_hostname, &mutex.m_ptr->thread_holding->generator,
           ink_cluster_time(), (int) t_state.txn_conf->down_server_timeout);
     }
     if (!srv) {
       t_state.dns_info.srv_lookup_success = false;
-      t_state.dns_info.srv_hostname[0] = '\0';
       t_state.srv_lookup = false;
       DebugSM("dns_srv", "SRV records empty for %s", t_state.dns_info.lookup_name);
     } else {
@@ -4394,6 +4394,77 @@ HttpSM::do_range_setup_if_necessary()
 }
 
 
+// HostDB lookup of the origin server started together with the cache
+//   lookup. It shares the mutex of the state machine, which cancels
+//   it on a hit; otherwise the lookup after the miss finds the result
+//   in HostDB, or waits for the same DNS query.
+struct HttpSpeculativeDNS: public Continuation
+{
+  HttpSpeculativeDNS(HttpSM * sm_arg)
+    : Continuation(sm_arg->mutex), sm(sm_arg), action(NULL)
+  {
+    SET_HANDLER(&HttpSpeculativeDNS::state_hostdb_lookup);
+  }
+
+  int state_hostdb_lookup(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+  {
+    sm->speculative_dns = NULL;
+    delete this;
+    return EVENT_DONE;
+  }
+
+  HttpSM *sm;
+  Action *action;
+};
+
+void
+HttpSM::start_speculative_dns()
+{
+  url_mapping *map = t_state.url_map.getMapping();
+
+  if (map && t_state.txn_conf->speculative_dns == 2)
+    map->count_cache_lookup();
+
+  if (t_state.txn_conf->speculative_dns == 0 ||
+      (t_state.txn_conf->speculative_dns == 2 && (map == NULL || !map->mostly_misses())))
+    return;
+
+  // Only the origin server, and only if it is not looked up already
+  if (speculative_dns || t_state.force_dns || t_state.srv_lookup || t_state.dns_info.lookup_success ||
+      t_state.http_config_param->parent_proxy_routing_enable || t_state.dns_info.lookup_name == NULL ||
+      !t_state.cache_info.directives.does_client_permit_dns_storing || ua_session == NULL)
+    return;
+
+  DebugSM("http_seq", "[HttpSM::start_speculative_dns] [%" PRId64 "] Looking up %s during the cache lookup",
+          sm_id, t_state.dns_info.lookup_name);
+  HTTP_INCREMENT_DYN_STAT(http_speculative_dns_lookups_stat);
+
+  HostDBProcessor::Options opt;
+  opt.port = t_state.server_info.port;
+  opt.flags = HostDBProcessor::HOSTDB_DO_NOT_FORCE_DNS;
+  opt.timeout = (t_state.api_txn_dns_timeout_value != -1) ? t_state.api_txn_dns_timeout_value : 0;
+  opt.host_res_style = ua_session->host_res_style;
+
+  // The lookup may be done, and speculative_dns cleared, on return
+  speculative_dns = new HttpSpeculativeDNS(this);
+  HttpSpeculativeDNS *dns = speculative_dns;
+  Action *dns_lookup_action_handle = hostDBProcessor.getbyname_re(dns, t_state.dns_info.lookup_name, 0, opt);
+  if (dns_lookup_action_handle != ACTION_RESULT_DONE) {
+    dns->action = dns_lookup_action_handle;
+  }
+}
+
+void
+HttpSM::cancel_speculative_dns()
+{
+  if (speculative_dns) {
+    ink_assert(speculative_dns->action);
+    speculative_dns->action->cancel();
+    delete speculative_dns;
+    speculative_dns = NULL;
+  }
+}
+
 void
 HttpSM::do_cache_lookup_and_read()
 {
@@ -4416,6 +4487,7 @@ HttpSM::do_cache_lookup_and_read()
     c_url = t_state.cache_info.lookup_url;
 
   DebugSM("http_seq", "[HttpSM::do_cache_lookup_and_read] [%" PRId64 "] Issuing cache lookup for URL %s",  sm_id, c_url->string_get(&t_state.arena));
+  start_speculative_dns();
   Action *cache_action_handle = cache_sm.open_read(c_url,
                                                    &t_state.hdr_info.client_request,
                                                    &(t_state.cache_info.config),
@@ -5571,6 +5643,10 @@ HttpSM::perform_cache_write_action()
     ink_release_assert(0);
     break;
   }
+
+  // Any write has its headers now, wake the misses collapsed on
+  //   ours so that they can read while we write
+  cache_sm.collapse_release();
 }
 
 
@@ -6580,6 +6656,7 @@ HttpSM::kill_this()
       pending_action->cancel();
       pending_action = NULL;
     }
+    cancel_speculative_dns();
 
     cache_sm.end_both();
     if (second_cache_sm)
@@ -6762,6 +6839,17 @@ HttpSM::update_stats()
   }
 #endif
 
+  // Latency of the phases the transaction went through
+  HTTP_LATENCY(http_latency_total, total_time);
+  if (milestones.dns_lookup_begin != 0 && milestones.dns_lookup_end >= milestones.dns_lookup_begin)
+    HTTP_LATENCY(http_latency_dns, milestones.dns_lookup_end - milestones.dns_lookup_begin);
+  if (milestones.server_connect != 0 && milestones.server_connect_end >= milestones.server_connect)
+    HTTP_LATENCY(http_latency_connect, milestones.server_connect_end - milestones.server_connect);
+  if (milestones.server_begin_write != 0 && milestones.server_first_read >= milestones.server_begin_write)
+    HTTP_LATENCY(http_latency_origin_first_byte, milestones.server_first_read - milestones.server_begin_write);
+  if (milestones.cache_open_read_begin != 0 && milestones.cache_open_read_end >= milestones.cache_open_read_begin)
+    HTTP_LATENCY(http_latency_cache_open_read, milestones.cache_open_read_end - milestones.cache_open_read_begin);
+
   HttpTransact::update_size_and_time_stats(&t_state, total_time, ua_write_time, os_read_time, client_request_hdr_bytes,
                                            client_request_body_bytes, client_response_hdr_bytes, client_response_body_bytes,
                                            server_request_hdr_bytes, server_request_body_bytes, server_response_hdr_bytes,
@@ -6945,6 +7033,7 @@ void
 HttpSM::call_transact_and_set_next_state(TransactEntryFunc_t f)
 {
   last_action = t_state.next_action;    // remember where we were
+  t_state.own_cache_response();
 
   // The callee can either specify a method to call in to Transact,
   //   or call with NULL which indicates that Transact should use
@@ -7186,6 +7275,9 @@ HttpSM::set_next_state()
       ink_assert(t_state.cache_info.action == HttpTransact::CACHE_DO_SERVE ||
                  t_state.cache_info.action == HttpTransact::CACHE_DO_SERVE_AND_DELETE ||
                  t_state.cache_info.action == HttpTransact::CACHE_DO_SERVE_AND_UPDATE);
+      if (t_state.url_map.getMapping() && t_state.txn_conf->speculative_dns == 2)
+        t_state.url_map.getMapping()->count_cache_hit();
+      cancel_speculative_dns();
       release_server_session(true);
       t_state.source = HttpTransact::SOURCE_CACHE;
 
@@ -7200,8 +7292,7 @@ HttpSM::set_next_state()
         tunnel.tunnel_run(p);
       } else {
         ink_assert((t_state.hdr_info.client_response.valid()? true : false) == true);
-        t_state.hdr_info.cache_response.create(HTTP_TYPE_RESPONSE);
-        t_state.hdr_info.cache_response.copy(&t_state.hdr_info.client_response);
+        t_state.share_cache_response();
 
         perform_cache_write_action();
         t_state.api_next_action = HttpTransact::SM_ACTION_API_SEND_RESPONSE_HDR;
@@ -7589,6 +7680,7 @@ HttpSM::redirect_request(const char *redirect_url, const int redirect_len)
   //(bug 2540703) Clear the previous response if we will attempt the redirect
   if (t_state.hdr_info.client_response.valid()) {
     // XXX - doing a destroy() for now, we can do a fileds_clear() if we have performance issue
+    t_state.own_cache_response();
     t_state.hdr_info.client_response.destroy();
   }
 
@@ -7609,6 +7701,7 @@ HttpSM::redirect_request(const char *redirect_url, const int redirect_len)
   t_state.request_sent_time = 0;
   t_state.response_received_time = 0;
   t_state.cache_info.write_lock_state = HttpTransact::CACHE_WL_INIT;
+  t_state.cache_info.not_admitted = false;
   t_state.next_action = HttpTransact::SM_ACTION_REDIRECT_READ;
   // we have a new OS and need to have DNS lookup the new OS
   t_state.dns_info.lookup_success = false;
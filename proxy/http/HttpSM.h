@@ -75,6 +75,7 @@ class HttpServerSession;
 class AuthHttpAdapter;
 
 class HttpSM;
+struct HttpSpeculativeDNS;
 typedef int (HttpSM::*HttpSMHandler) (int event, void *data);
 
 enum HttpVC_t
@@ -189,6 +190,7 @@ class HttpSM: public Continuation
 {
   friend class HttpPagesHandler;
   friend class CoreUtils;
+  friend struct HttpSpeculativeDNS;
 public:
   HttpSM();
   void cleanup();
@@ -333,6 +335,9 @@ protected:
   Action *historical_action;
   Continuation *schedule_cont;
 
+  // Origin server lookup running with the cache lookup
+  HttpSpeculativeDNS *speculative_dns;
+
   HTTPParser http_parser;
   void start_sub_sm();
 
@@ -403,6 +408,8 @@ protected:
   void do_hostdb_lookup();
   void do_hostdb_reverse_lookup();
   void do_cache_lookup_and_read();
+  void start_speculative_dns();
+  void cancel_speculative_dns();
   void do_http_server_open(bool raw = false);
   void do_setup_post_tunnel(HttpVC_t to_vc_type);
   void do_cache_prepare_write();
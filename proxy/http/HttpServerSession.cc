@@ -77,11 +77,12 @@ HttpServerSession::new_connection(NetVConnection *new_vc)
   if (enable_origin_connection_limiting == true) {
     if (connection_count == NULL)
       connection_count = ConnectionCount::getInstance();
-    connection_count->incrementCount(server_ip);
+    connection_counter = connection_count->getCounter(server_ip);
+    int count = ConnectionCount::incrementCount(connection_counter);
     char addrbuf[INET6_ADDRSTRLEN];
     Debug("http_ss", "[%" PRId64 "] new connection, ip: %s, count: %u", 
         con_id, 
-        ats_ip_ntop(&server_ip.sa, addrbuf, sizeof(addrbuf)), connection_count->getCount(server_ip));
+        ats_ip_ntop(&server_ip.sa, addrbuf, sizeof(addrbuf)), count);
   }
 #ifdef LAZY_BUF_ALLOC
   read_buffer = new_empty_MIOBuffer(HTTP_SERVER_RESP_HDR_BUFFER_INDEX);
@@ -130,16 +131,18 @@ HttpServerSession::do_io_close(int alerrno)
   // Check to see if we are limiting the number of connections
   // per host
   if (enable_origin_connection_limiting == true) {
-    if (connection_count->getCount(server_ip) > 0) {
-      connection_count->incrementCount(server_ip, -1);
+    // No lock needed, we kept the counter from new_connection().
+    int count = ConnectionCount::incrementCount(connection_counter, -1);
+    if (count >= 0) {
       char addrbuf[INET6_ADDRSTRLEN];
       Debug("http_ss", "[%" PRId64 "] connection closed, ip: %s, count: %u",
             con_id, 
             ats_ip_ntop(&server_ip.sa, addrbuf, sizeof(addrbuf)), 
-            connection_count->getCount(server_ip));
+            count);
     } else {
+      ConnectionCount::incrementCount(connection_counter);
       Error("[%" PRId64 "] number of connections should be greater than zero: %u",
-            con_id, connection_count->getCount(server_ip));
+            con_id, count + 1);
     }
   }
 
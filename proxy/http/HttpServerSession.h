@@ -77,7 +77,7 @@ public:
       sharing_match(TS_SERVER_SESSION_SHARING_MATCH_BOTH),
       sharing_pool(TS_SERVER_SESSION_SHARING_POOL_GLOBAL),
       enable_origin_connection_limiting(false),
-      connection_count(NULL), read_buffer(NULL),
+      connection_count(NULL), connection_counter(NULL), read_buffer(NULL),
       server_vc(NULL), magic(HTTP_SS_MAGIC_DEAD), buf_reader(NULL)
     { 
       ink_zero(server_ip);
@@ -151,6 +151,7 @@ public:
   // singleton that keeps track of the connection counts.
   bool enable_origin_connection_limiting;
   ConnectionCount *connection_count;
+  ConnectionCount::Counter *connection_counter;
 
   // The ServerSession owns the following buffer which use
   //   for parsing the headers.  The server session needs to
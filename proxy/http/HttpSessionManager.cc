@@ -41,12 +41,14 @@ void
 initialize_thread_for_http_sessions(EThread *thread, int /* thread_index ATS_UNUSED */)
 {
   thread->server_session_pool = new ServerSessionPool;
+  // Per thread pools warm up sessions on their own thread.
+  thread->schedule_every(thread->server_session_pool, HTTP_PREWARM_INTERVAL);
 }
 
 HttpSessionManager httpSessionManager;
 
 ServerSessionPool::ServerSessionPool()
-  : Continuation(new_ProxyMutex()), m_ip_pool(1023), m_host_pool(1023)
+  : Continuation(new_ProxyMutex()), m_ip_pool(1023), m_host_pool(1023), m_demand(127)
 {
   SET_HANDLER(&ServerSessionPool::eventHandler);
   m_ip_pool.setExpansionPolicy(IPHashTable::MANUAL);
@@ -130,8 +132,169 @@ ServerSessionPool::releaseSession(HttpServerSession* ss)
   Debug("http_ss", "[%" PRId64 "] [release session] " "session placed into shared pool", ss->con_id);
 }
 
+/** Opens one session to an origin ahead of requests, then puts it in the pool.
+ */
+struct OriginPrewarmer: public Continuation
+{
+  OriginPrewarmer(OriginDemand *d) : Continuation(new_ProxyMutex()), demand(d)
+  {
+    SET_HANDLER(&OriginPrewarmer::handle_connect);
+  }
+
+  int handle_connect(int event, void *data);
+
+  OriginDemand *demand;
+};
+
+int
+OriginPrewarmer::handle_connect(int event, void *data)
+{
+  if (event == NET_EVENT_OPEN) {
+    NetVConnection *netvc = static_cast<NetVConnection *>(data);
+    HttpServerSession *session = (TS_SERVER_SESSION_SHARING_POOL_THREAD == demand->sharing_pool) ?
+      THREAD_ALLOC_INIT(httpServerSessionAllocator, mutex->thread_holding) :
+      httpServerSessionAllocator.alloc();
+
+    session->sharing_pool = demand->sharing_pool;
+    session->sharing_match = demand->sharing_match;
+    session->enable_origin_connection_limiting = demand->enable_origin_connection_limiting;
+    ats_ip_copy(&session->server_ip, &demand->addr);
+    session->new_connection(netvc);
+    session->hostname_hash = demand->hostname_hash;
+    session->to_parent_proxy = demand->to_parent_proxy;
+    if (session->to_parent_proxy) {
+      HTTP_INCREMENT_DYN_STAT(http_current_parent_proxy_connections_stat);
+      HTTP_INCREMENT_DYN_STAT(http_total_parent_proxy_connections_stat);
+    }
+    netvc->set_inactivity_timeout(HRTIME_SECONDS(demand->keep_alive_no_activity_timeout_out));
+    HTTP_INCREMENT_DYN_STAT(http_origin_prewarm_connections_stat);
+    Debug("http_ss", "[%" PRId64 "] [prewarm] session opened ahead of requests", session->con_id);
+    session->release();
+  } else {
+    ip_port_text_buffer ipb;
+    Debug("http_ss", "[prewarm] could not connect to %s", ats_ip_nptop(&demand->addr.sa, ipb, sizeof(ipb)));
+  }
+
+  // The pool may forget the origin once nothing is opening to it, so this is the last use.
+  ink_atomic_increment(&demand->opening, -1);
+  delete this;
+  return 0;
+}
+
+void
+ServerSessionPool::noteDemand(sockaddr const* addr, INK_MD5 const& hostname_hash, HttpSM *sm)
+{
+  DemandTable::Location loc = m_demand.find(hostname_hash);
+  OriginDemand *d;
+
+  while (loc && !ats_ip_addr_port_eq(&loc->addr.sa, addr))
+    ++loc;
+
+  if (loc) {
+    d = loc;
+  } else {
+    d = new OriginDemand;
+    ats_ip_copy(&d->addr, addr);
+    d->hostname_hash = hostname_hash;
+    d->requests = 0;
+    d->rate = 0;
+    d->opening = 0;
+    m_demand.insert(d);
+  }
+
+  // Open sessions the way the latest transaction would have.
+  HttpTransact::State &s = sm->t_state;
+  d->sharing_match = static_cast<TSServerSessionSharingMatchType>(s.txn_conf->server_session_sharing_match);
+  d->sharing_pool = static_cast<TSServerSessionSharingPoolType>(s.txn_conf->server_session_sharing_pool);
+  d->to_parent_proxy = s.current.request_to == HttpTransact::PARENT_PROXY;
+  d->enable_origin_connection_limiting =
+    s.txn_conf->origin_max_connections > 0 || s.http_config_param->origin_min_keep_alive_connections > 0;
+  d->origin_max_connections = s.txn_conf->origin_max_connections;
+  d->keep_alive_no_activity_timeout_out = s.txn_conf->keep_alive_no_activity_timeout_out;
+  d->sock_recv_buffer_size_out = s.txn_conf->sock_recv_buffer_size_out;
+  d->sock_send_buffer_size_out = s.txn_conf->sock_send_buffer_size_out;
+  d->sock_option_flag_out = s.txn_conf->sock_option_flag_out;
+  d->sock_packet_mark_out = s.txn_conf->sock_packet_mark_out;
+  d->sock_packet_tos_out = s.txn_conf->sock_packet_tos_out;
+  ++d->requests;
+}
+
+void
+ServerSessionPool::prewarm()
+{
+  HttpConfigParams *params = HttpConfig::acquire();
+  int64_t max_sessions = params->origin_prewarm_max_sessions;
+  int64_t window = params->origin_prewarm_window;
+  int64_t server_max_connections = params->server_max_connections;
+  HttpConfig::release(params);
+
+  if (m_demand.count() == 0) {
+    return;
+  }
+
+  int64_t server_connections = 0;
+  HTTP_READ_GLOBAL_DYN_SUM(http_current_server_connections_stat, server_connections);
+
+  for (DemandTable::iterator last = m_demand.end(), spot = m_demand.begin(); spot != last;) {
+    OriginDemand *d = &*spot;
+    ++spot;
+
+    // Follow a rise in demand at once, a fall slowly, so a pool is not let go between bursts.
+    d->rate = std::max((double) d->requests, d->rate * 7 / 8);
+    d->requests = 0;
+
+    if ((d->rate < 0.1 || max_sessions <= 0) && d->opening == 0) {
+      m_demand.remove(m_demand.find(d));
+      delete d;
+      continue;
+    }
+    if (max_sessions <= 0) {
+      continue;
+    }
+
+    int idle = 0;
+    for (HostHashTable::Location loc = m_host_pool.find(d->hostname_hash); loc; ++loc) {
+      if (ats_ip_addr_port_eq(&loc->server_ip.sa, &d->addr.sa))
+        ++idle;
+    }
+
+    int64_t target = std::min(max_sessions, (int64_t) ceil(d->rate * HRTIME_MSECONDS(window) / HTTP_PREWARM_INTERVAL));
+    int64_t want = target - idle - d->opening;
+
+    if (d->origin_max_connections > 0) {
+      want = std::min(want, d->origin_max_connections - ConnectionCount::getInstance()->getCount(d->addr) - d->opening);
+    }
+    if (server_max_connections > 0) {
+      want = std::min(want, server_max_connections - server_connections);
+    }
+
+    if (want > 0) {
+      ip_port_text_buffer ipb;
+      Debug("http_ss", "[prewarm] opening %" PRId64 " sessions to %s, %d idle, %.1f requests/s", want,
+            ats_ip_nptop(&d->addr.sa, ipb, sizeof(ipb)), idle, d->rate * HRTIME_SECOND / HTTP_PREWARM_INTERVAL);
+    }
+
+    for (; want > 0; --want) {
+      OriginPrewarmer *prewarmer = new OriginPrewarmer(d);
+      NetVCOptions opt;
+
+      opt.f_blocking_connect = false;
+      opt.set_sock_param(d->sock_recv_buffer_size_out, d->sock_send_buffer_size_out, d->sock_option_flag_out,
+                         d->sock_packet_mark_out, d->sock_packet_tos_out);
+      opt.ip_family = d->addr.sa.sa_family;
+
+      ink_atomic_increment(&d->opening, 1);
+      ++server_connections;
+
+      MUTEX_LOCK(lock, prewarmer->mutex, this_ethread());
+      netProcessor.connect_re(prewarmer, &d->addr.sa, &opt);
+    }
+  }
+}
+
 //   Called from the NetProcessor to let us know that a
-//    connection has closed down
+//    connection has closed down, and every HTTP_PREWARM_INTERVAL
+//    to open sessions ahead of requests.
 //
 int
 ServerSessionPool::eventHandler(int event, void *data)
@@ -140,6 +303,10 @@ ServerSessionPool::eventHandler(int event, void *data)
   HttpServerSession *s = NULL;
 
   switch (event) {
+  case EVENT_INTERVAL:
+    prewarm();
+    return 0;
+
   case VC_EVENT_READ_READY:
     // The server sent us data.  This is unexpected so
     //   close the connection
@@ -169,7 +336,7 @@ ServerSessionPool::eventHandler(int event, void *data)
       if ((event == VC_EVENT_INACTIVITY_TIMEOUT || event == VC_EVENT_ACTIVE_TIMEOUT) &&
           s->state == HSS_KA_SHARED &&
           s->enable_origin_connection_limiting) {
-        bool connection_count_below_min = s->connection_count->getCount(s->server_ip) <= http_config_params->origin_min_keep_alive_connections;
+        bool connection_count_below_min = s->connection_counter->count <= http_config_params->origin_min_keep_alive_connections;
 
         if (connection_count_below_min) {
           Debug("http_ss", "[%" PRId64 "] [session_bucket] session received io notice [%s], "
@@ -212,6 +379,7 @@ void
 HttpSessionManager::init()
 {
   m_g_pool = new ServerSessionPool;
+  eventProcessor.schedule_every(m_g_pool, HTTP_PREWARM_INTERVAL, ET_NET);
 }
 
 // TODO: Should this really purge all keep-alive sessions?
@@ -227,6 +395,24 @@ HttpSessionManager::purge_keepalives()
   } // should we do something clever if we don't get the lock?
 }
 
+// Whether sessions for the transaction can be opened without it: plain
+// HTTP from the default local address.
+static bool
+prewarm_eligible(HttpSM *sm, HttpClientSession *ua_session)
+{
+  HttpTransact::State &s = sm->t_state;
+  int scheme = s.hdr_info.server_request.url_get()->scheme_get_wksidx();
+
+  if (scheme < 0) {
+    scheme = s.hdr_info.client_request.url_get()->scheme_get_wksidx();
+  }
+
+  return s.http_config_param->origin_prewarm_max_sessions > 0 && !s.is_websocket &&
+    scheme == URL_WKSIDX_HTTP && s.method != HTTP_WKSIDX_CONNECT &&
+    !ua_session->f_outbound_transparent && ua_session->outbound_port == 0 &&
+    !ua_session->outbound_ip4.isValid() && !ua_session->outbound_ip6.isValid();
+}
+
 HSMresult_t
 HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockaddr const* ip,
                                     const char *hostname, HttpClientSession *ua_session, HttpSM *sm)
@@ -258,13 +444,18 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
 
   // Now check to see if we have a connection in our shared connection pool
   EThread *ethread = this_ethread();
+  bool prewarm = prewarm_eligible(sm, ua_session);
 
   if (TS_SERVER_SESSION_SHARING_POOL_THREAD == sm->t_state.txn_conf->server_session_sharing_pool) {
     to_return = ethread->server_session_pool->acquireSession(ip, hostname_hash, match_style);
+    if (prewarm)
+      ethread->server_session_pool->noteDemand(ip, hostname_hash, sm);
   } else {
     MUTEX_TRY_LOCK(lock, m_g_pool->mutex, ethread);
     if (lock) {
       to_return = m_g_pool->acquireSession(ip, hostname_hash, match_style);
+      if (prewarm)
+        m_g_pool->noteDemand(ip, hostname_hash, sm);
       Debug("http_ss", "[acquire session] pool search %s", to_return ? "successful" : "failed");
     } else {
       Debug("http_ss", "[acquire session] could not acquire session due to lock contention");
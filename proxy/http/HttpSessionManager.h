@@ -44,6 +44,38 @@ class HttpSM;
 void
 initialize_thread_for_http_sessions(EThread *thread, int thread_index);
 
+/// How often session pools look at origin demand to pre-warm sessions.
+#define HTTP_PREWARM_INTERVAL HRTIME_SECONDS(1)
+
+/** Recent demand for sessions to one origin.
+
+    A pool keeps one of these for each origin it was asked for a session to while pre-warming
+    is enabled, with what it needs to open more sessions to the origin without a transaction.
+*/
+struct OriginDemand
+{
+  IpEndpoint addr; ///< Origin address and port.
+  INK_MD5 hostname_hash;
+  TSServerSessionSharingMatchType sharing_match;
+  TSServerSessionSharingPoolType sharing_pool;
+  bool to_parent_proxy;
+  bool enable_origin_connection_limiting;
+  // Settings of the last transaction that asked for a session.
+  int64_t origin_max_connections;
+  int64_t keep_alive_no_activity_timeout_out;
+  int64_t sock_recv_buffer_size_out;
+  int64_t sock_send_buffer_size_out;
+  int64_t sock_option_flag_out;
+  int64_t sock_packet_mark_out;
+  int64_t sock_packet_tos_out;
+
+  int requests; ///< Sessions asked for since the last interval.
+  double rate; ///< Recent sessions asked for per interval.
+  volatile int opening; ///< Connects in progress.
+
+  LINK(OriginDemand, hash_link);
+};
+
 /** A pool of server sessions.
 
     This is a continuation so that it can get callbacks from the server sessions.
@@ -88,8 +120,22 @@ public:
     static bool equal(Key lhs, Key rhs) { return lhs == rhs; }
   };
 
+  /// Interface class for the demand map.
+  struct DemandHashing
+  {
+    typedef uint64_t ID;
+    typedef INK_MD5 const& Key;
+    typedef OriginDemand Value;
+    typedef DList(OriginDemand, hash_link) ListHead;
+
+    static ID hash(Key key) { return key.fold(); }
+    static Key key(Value const* value) { return value->hostname_hash; }
+    static bool equal(Key lhs, Key rhs) { return lhs == rhs; }
+  };
+
   typedef TSHashTable<IPHashing> IPHashTable; ///< Sessions by IP address.
   typedef TSHashTable<HostHashing> HostHashTable; ///< Sessions by host name.
+  typedef TSHashTable<DemandHashing> DemandTable; ///< Origin demand by host name.
 
 public:
   /** Check if a session matches address and host name.
@@ -111,10 +157,20 @@ public:
   /// Close all sessions and then clear the table.
   void purge();
 
+  /** Note that @a sm asked for a session to an origin, for pre-warming.
+   */
+  void noteDemand(sockaddr const* addr, INK_MD5 const& host_hash, HttpSM *sm);
+  /** Open sessions to the origins in demand until there are enough idle ones.
+
+      Called every @c HTTP_PREWARM_INTERVAL.
+  */
+  void prewarm();
+
   // Pools of server sessions.
   // Note that each server session is stored in both pools.
   IPHashTable m_ip_pool;
   HostHashTable m_host_pool;
+  DemandTable m_demand;
 };
 
 enum HSMresult_t
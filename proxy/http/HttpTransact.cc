@@ -543,13 +543,14 @@ how_to_open_connection(HttpTransact::State* s)
       }
     }                           // the URL was remapped
     if (is_debug_tag_set("cdn")) {
-      char *d_url = s->hdr_info.server_request.url_get()->string_get(NULL);
-      if (d_url)
+      char *d_url = s->hdr_info.server_request.url_get()->string_get(&s->arena);
+      if (d_url) {
         DebugTxn("cdn", "URL: %s", d_url);
+        s->arena.str_free(d_url);
+      }
       char *d_hst = (char *) s->hdr_info.server_request.value_get(MIME_FIELD_HOST, MIME_LEN_HOST, &host_len);
       if (d_hst)
         DebugTxn("cdn", "Host Hdr: %s", d_hst);
-      ats_free(d_url);
     }
     s->cdn_remap_complete = true;       // It doesn't matter if there was an actual remap or not
     s->transact_return_point = HttpTransact::OSDNSLookup;
@@ -853,7 +854,8 @@ HttpTransact::EndRemapRequest(State* s)
     } else {
       build_error_response(s, HTTP_STATUS_MOVED_TEMPORARILY, "Redirect", "redirect#moved_temporarily", NULL);
     }
-    ats_free(s->remap_redirect);
+    s->arena.str_free(s->remap_redirect);
+    s->remap_redirect = NULL;
     s->reverse_proxy = false;
     goto done;
   }
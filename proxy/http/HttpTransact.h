@@ -647,6 +647,7 @@ public:
     CacheWriteLock_t write_lock_state;
     int lookup_count;
     bool is_ram_cache_hit;
+    bool not_admitted;          // a write was refused by cache admission, don't ask again
 
     _CacheLookupInfo()
       : action(CACHE_DO_UNDEFINED),
@@ -666,7 +667,8 @@ public:
         open_write_retries(0),
       write_lock_state(CACHE_WL_INIT),
       lookup_count(0),
-      is_ram_cache_hit(false)
+      is_ram_cache_hit(false),
+      not_admitted(false)
     { }
   } CacheLookupInfo;
 
@@ -779,7 +781,7 @@ public:
 
     bool lookup_success;
     char *lookup_name;
-    char srv_hostname[MAXDNAME];
+    char *srv_hostname; ///< MAXDNAME bytes from the transaction arena, on the first SRV lookup.
     LookingUp_t looking_up;
     bool srv_lookup_success;
     short srv_port;
@@ -791,10 +793,9 @@ public:
 
     _DNSLookupInfo()
     : attempts(0), os_addr_style(OS_ADDR_TRY_DEFAULT),
-        lookup_success(false), lookup_name(NULL), looking_up(UNDEFINED_LOOKUP),
+        lookup_success(false), lookup_name(NULL), srv_hostname(NULL), looking_up(UNDEFINED_LOOKUP),
         srv_lookup_success(false), srv_port(0), lookup_validated(true)
     {
-      srv_hostname[0] = '\0';
       srv_app.allotment.application1 = 0;
       srv_app.allotment.application2 = 0;
     }
@@ -1014,11 +1015,14 @@ public:
     RangeRecord *ranges;
 
     OverridableHttpConfigParams *txn_conf;
-    OverridableHttpConfigParams my_txn_conf; // Storage for plugins, to avoid malloc
+    OverridableHttpConfigParams *my_txn_conf; // Storage for plugins, from the arena on first override
 
     bool transparent_passthrough;
     bool range_in_cache;
 
+    // cache_response shares the heap of client_response, see share_cache_response()
+    bool cache_response_shared;
+
     // Methods
     void
     init()
@@ -1113,8 +1117,10 @@ public:
         range_output_cl(0),
         ranges(NULL),
         txn_conf(NULL),
+        my_txn_conf(NULL),
         transparent_passthrough(false),
-        range_in_cache(false)
+        range_in_cache(false),
+        cache_response_shared(false)
     {
       int i;
       char *via_ptr = via_string;
@@ -1174,6 +1180,10 @@ public:
       ParentConfig::release(parent_params);
       parent_params = NULL;
 
+      if (cache_response_shared) {
+        hdr_info.cache_response.clear();
+        cache_response_shared = false;
+      }
       hdr_info.client_request.destroy();
       hdr_info.client_response.destroy();
       hdr_info.server_request.destroy();
@@ -1196,7 +1206,11 @@ public:
       }
 
       url_map.clear();
+      // Everything carved from the arena (remap redirects, SRV names,
+      // overridden configs, stat blocks) goes at once here.
       arena.reset();
+      dns_info.srv_hostname = NULL;
+      my_txn_conf = NULL;
       pristine_url.clear();
 
       delete[] ranges;
@@ -1209,10 +1223,38 @@ public:
     void
     setup_per_txn_configs()
     {
-      if (txn_conf != &my_txn_conf) {
-        // Make sure we copy it first.
-        memcpy(&my_txn_conf, &http_config_param->oride, sizeof(my_txn_conf));
-        txn_conf = &my_txn_conf;
+      if (my_txn_conf == NULL) {
+        // Most transactions never override anything, so the copy is
+        // only made the first time a plugin asks for it.
+        my_txn_conf = static_cast<OverridableHttpConfigParams *>(arena.alloc(sizeof(OverridableHttpConfigParams)));
+        memcpy(my_txn_conf, &http_config_param->oride, sizeof(OverridableHttpConfigParams));
+        txn_conf = my_txn_conf;
+      }
+    }
+
+    // On a cache hit the response as served is kept for logging. Nothing
+    // changes client_response between building it and writing it to the
+    // client unless a plugin gets at it or Transact runs again, so until
+    // then cache_response is only an alias and the copy is made on demand.
+    void
+    share_cache_response()
+    {
+      // a copy made by own_cache_response() for an earlier response, e.g.
+      // before following a redirect, has a heap of its own
+      if (!cache_response_shared && hdr_info.cache_response.valid())
+        hdr_info.cache_response.destroy();
+      hdr_info.cache_response.copy_shallow(&hdr_info.client_response);
+      cache_response_shared = true;
+    }
+
+    void
+    own_cache_response()
+    {
+      if (cache_response_shared) {
+        cache_response_shared = false;
+        hdr_info.cache_response.clear();
+        if (hdr_info.client_response.valid())
+          hdr_info.cache_response.copy(&hdr_info.client_response);
       }
     }
 
@@ -101,3 +101,45 @@ REGRESSION_TEST(HttpTransact_is_request_valid)(RegressionTest *t, int /* level *
     }
   }
 }
+
+static void
+setup_redirect_response(HTTPHdr *h, const char *location)
+{
+  h->create(HTTP_TYPE_RESPONSE);
+  h->status_set(HTTP_STATUS_MOVED_TEMPORARILY);
+  h->value_set(MIME_FIELD_LOCATION, MIME_LEN_LOCATION, location, strlen(location));
+}
+
+// A cached redirect is served, the redirect is followed, and its target is
+// a cache hit too. The copy of the first response must go when the second
+// one is shared, which shows in the references to its string heap.
+REGRESSION_TEST(HttpTransact_share_cache_response)(RegressionTest *t, int /* level */, int *pstatus)
+{
+  HttpSM sm;
+  HttpTransact::State *s = &sm.t_state;
+  *pstatus = REGRESSION_TEST_PASSED;
+
+  init_sm(&sm);
+  setup_redirect_response(&s->hdr_info.client_response, "http://example.com/a");
+  s->share_cache_response();
+  s->own_cache_response();
+  Ptr<HdrStrHeap> strs = s->hdr_info.client_response.m_heap->m_read_write_heap;
+
+  s->hdr_info.client_response.destroy();
+  setup_redirect_response(&s->hdr_info.client_response, "http://example.com/b");
+  s->share_cache_response();
+
+  if (strs->refcount() != 1) {
+    rprintf(t, "HttpTransact::share_cache_response - the earlier copy was not freed, %d references\n", strs->refcount());
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+  if (s->hdr_info.cache_response.m_http != s->hdr_info.client_response.m_http) {
+    rprintf(t, "HttpTransact::share_cache_response - cache_response is not the served response\n");
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+
+  s->own_cache_response();
+  s->hdr_info.client_request.destroy();
+  s->hdr_info.client_response.destroy();
+  s->hdr_info.cache_response.destroy();
+}
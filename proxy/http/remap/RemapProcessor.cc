@@ -218,15 +218,18 @@ RemapProcessor::finish_remap(HttpTransact::State *s)
             }
           }
           tmp_redirect_buf[sizeof(tmp_redirect_buf) - 1] = 0;
-          *redirect_url = ats_strdup(tmp_redirect_buf);
+          *redirect_url = s->arena.str_store(tmp_redirect_buf, strlen(tmp_redirect_buf));
         }
-      } else {
-        *redirect_url = ats_strdup(rewrite_table->http_default_redirect_url);
+      } else if (rewrite_table->http_default_redirect_url) {
+        *redirect_url = s->arena.str_store(rewrite_table->http_default_redirect_url,
+                                           strlen(rewrite_table->http_default_redirect_url));
       }
 
       if (*redirect_url == NULL) {
-        *redirect_url = ats_strdup(map->filter_redirect_url ? map->filter_redirect_url :
-                                   rewrite_table->http_default_redirect_url);
+        const char *redirect = map->filter_redirect_url ? map->filter_redirect_url : rewrite_table->http_default_redirect_url;
+
+        if (redirect)
+          *redirect_url = s->arena.str_store(redirect, strlen(redirect));
       }
 
       return false;
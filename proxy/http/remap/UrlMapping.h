@@ -119,7 +119,30 @@ public:
   int getRank() const { return _rank; };
   void setRank(int rank) { _rank = rank; };
 
+  // The recent cache lookups of the rule and the ones served from
+  //   cache, halved as they grow. Only counted for speculative_dns 2.
+  void count_cache_lookup()
+  {
+    if (ink_atomic_increment(&cache_lookups, 1) == 1024) {
+      halve(&cache_lookups);
+      halve(&cache_hits);
+    }
+  }
+  void count_cache_hit() { ink_atomic_increment(&cache_hits, 1); }
+  bool mostly_misses() const { return cache_hits * 2 < cache_lookups; }
+
+  volatile unsigned int cache_lookups;
+  volatile unsigned int cache_hits;
+
 private:
+  static void halve(volatile unsigned int *count)
+  {
+    unsigned int n;
+    do {
+      n = *count;
+    } while (!ink_atomic_cas(count, n, n / 2));
+  }
+
   remap_plugin_info* _plugin_list[MAX_REMAP_PLUGIN_CHAIN];
   void* _instance_data[MAX_REMAP_PLUGIN_CHAIN];
   int _rank;
@@ -1287,7 +1287,8 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
         total_bytes = buffer_header->byte_count;
 
       } else if (logfile->m_file_format == LOG_FILE_ASCII
-                 || logfile->m_file_format == LOG_FILE_PIPE){
+                 || logfile->m_file_format == LOG_FILE_PIPE
+                 || logfile->m_file_format == LOG_FILE_COLUMNAR){
 
         buf = (char *)fdata->m_data;
         total_bytes = fdata->m_len;
@@ -1505,7 +1506,8 @@ Log::match_logobject(LogBufferHeader * header)
 
     if (fmt->valid()) {
       LogFileFormat file_format = header->log_object_flags & LogObject::BINARY ? LOG_FILE_BINARY :
-        (header->log_object_flags & LogObject::WRITES_TO_PIPE ? LOG_FILE_PIPE : LOG_FILE_ASCII);
+        (header->log_object_flags & LogObject::COLUMNAR ? LOG_FILE_COLUMNAR :
+         (header->log_object_flags & LogObject::WRITES_TO_PIPE ? LOG_FILE_PIPE : LOG_FILE_ASCII));
 
       obj = new LogObject(fmt, Log::config->logfile_dir,
                           header->log_filename(), file_format, NULL,
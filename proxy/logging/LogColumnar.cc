@@ -0,0 +1,418 @@
+/** @file
+
+  Columnar on-disk representation of LogBuffers.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "libts.h"
+#include "Map.h"
+
+#include "LogColumnar.h"
+#include "LogField.h"
+#include "LogFormat.h"
+#include "LogAccess.h"
+#include "LogLimits.h"
+
+// Field symbols whose (non aggregate) value is the entry timestamp.
+static const char *entry_time_symbols[] = { "cqts", "cqth", "cqtq", "cqtn", "cqtd", "cqtt" };
+
+static bool
+is_entry_time_field(LogField * field)
+{
+  if (field->aggregate() != LogField::NO_AGGREGATE)
+    return false;
+  for (unsigned i = 0; i < countof(entry_time_symbols); ++i) {
+    if (strcmp(field->symbol(), entry_time_symbols[i]) == 0)
+      return true;
+  }
+  return false;
+}
+
+static unsigned
+count_symbols(const char *fieldlist_str)
+{
+  unsigned n = 0;
+  bool in_symbol = false;
+
+  for (const char *p = fieldlist_str; *p; ++p) {
+    if (*p == ',') {
+      in_symbol = false;
+    } else if (!in_symbol) {
+      in_symbol = true;
+      ++n;
+    }
+  }
+  return n;
+}
+
+/*-------------------------------------------------------------------------
+  LogColumnBuilder
+
+  Accumulates the values of one column while the buffer is walked.
+  -------------------------------------------------------------------------*/
+
+struct LogColumnBuilder
+{
+  LogField *field;
+  LogColumnType type;
+  textBuffer data;
+  textBuffer dict;
+  uint32_t dict_count;
+  int64_t last;
+  HashMap<cchar *, StringHashFns, uint32_t> dict_index;  // value -> index + 1
+
+  LogColumnBuilder()
+    : field(NULL), type(LOG_COLUMN_INT), data(1024), dict(1024), dict_count(0), last(0)
+  { }
+
+  void add_varint(uint64_t v)
+  {
+    uint8_t tmp[10];
+    data.copyFrom(tmp, log_column_put_varint(tmp, v));
+  }
+
+  void add_int(int64_t v)
+  {
+    add_varint(log_column_zigzag(v - last));
+    last = v;
+  }
+
+  // str must be NUL terminated.
+  void add_str(Arena & arena, const char *str, int len)
+  {
+    uint32_t idx = dict_index.get(str);
+
+    if (idx == 0) {
+      uint8_t tmp[10];
+
+      dict.copyFrom(tmp, log_column_put_varint(tmp, len));
+      dict.copyFrom(str, len + 1);      // keep the NUL, so readers can use it in place
+      idx = ++dict_count;
+      dict_index.put(arena.str_store(str, len), idx);
+    }
+    add_varint(idx - 1);
+  }
+
+  size_t size() const { return dict.spaceUsed() + data.spaceUsed(); }
+};
+
+/*-------------------------------------------------------------------------
+  LogColumnEncoder::encode
+  -------------------------------------------------------------------------*/
+
+int
+LogColumnEncoder::encode(LogBufferHeader * buffer_header, char **block)
+{
+  ink_assert(buffer_header != NULL);
+  ink_assert(block != NULL);
+
+  *block = NULL;
+
+  if (buffer_header->version != LOG_SEGMENT_VERSION) {
+    Note("Invalid LogBuffer version %d in LogColumnEncoder; "
+         "current version is %d", buffer_header->version, LOG_SEGMENT_VERSION);
+    return -1;
+  }
+  if (buffer_header->format_type == LOG_FORMAT_TEXT) {
+    Note("Text logs can't be written in columnar format");
+    return -1;
+  }
+
+  char *fieldlist_str = buffer_header->fmt_fieldlist();
+  if (fieldlist_str == NULL) {
+    return -1;
+  }
+
+  LogFieldList fieldlist;
+  bool contains_aggregates = false;
+  unsigned n_fields = LogFormat::parse_symbol_string(fieldlist_str, &fieldlist, &contains_aggregates);
+
+  if (n_fields == 0 || n_fields != count_symbols(fieldlist_str)) {
+    Note("Cannot encode LogBuffer with fieldlist %s in columnar format", fieldlist_str);
+    return -1;
+  }
+
+  unsigned n_columns = n_fields + 1;
+  LogColumnBuilder *columns = new LogColumnBuilder[n_columns];
+  Arena arena;
+  char str_buf[LOG_MAX_FORMATTED_LINE];
+  unsigned col;
+  LogField *field;
+
+  columns[0].type = LOG_COLUMN_TIMESTAMP;
+  for (col = 1, field = fieldlist.first(); field; field = fieldlist.next(field), ++col) {
+    columns[col].field = field;
+    if (is_entry_time_field(field)) {
+      columns[col].type = LOG_COLUMN_ENTRY_TIME;
+    } else if (field->is_plain_int()) {
+      columns[col].type = LOG_COLUMN_INT;
+    } else {
+      columns[col].type = LOG_COLUMN_DICT;
+    }
+  }
+
+  LogBufferIterator iter(buffer_header);
+  LogEntryHeader *entry_header;
+  uint32_t entry_count = 0;
+  bool ok = true;
+
+  while (ok && (entry_header = iter.next())) {
+    char *read_from = (char *) entry_header + sizeof(LogEntryHeader);
+
+    columns[0].add_int(entry_header->timestamp);
+    columns[0].add_varint(entry_header->timestamp_usec);
+
+    for (col = 1; col < n_columns; ++col) {
+      LogColumnBuilder & c = columns[col];
+
+      switch (c.type) {
+      case LOG_COLUMN_ENTRY_TIME:
+        // space was reserved in the entry; skip it
+        read_from += INK_MIN_ALIGN;
+        break;
+      case LOG_COLUMN_INT:
+        c.add_int(LogAccess::unmarshal_int(&read_from));
+        break;
+      case LOG_COLUMN_DICT:
+        {
+          int len = (int) c.field->unmarshal(&read_from, str_buf, sizeof(str_buf) - 1);
+
+          if (len < 0) {
+            Note("Log entry field %s too large for columnar encoding", c.field->symbol());
+            ok = false;
+            break;
+          }
+          str_buf[len] = '\0';
+          c.add_str(arena, str_buf, len);
+        }
+        break;
+      default:
+        ink_assert(!"unexpected column type");
+        break;
+      }
+    }
+    ++entry_count;
+  }
+
+  int byte_count = -1;
+
+  if (ok) {
+    size_t fieldlist_len = strlen(fieldlist_str) + 1;
+    size_t column_offset = sizeof(LogColumnBlockHeader) + INK_ALIGN(fieldlist_len, sizeof(uint32_t));
+    size_t data_offset = column_offset + n_columns * sizeof(LogColumnHeader);
+    size_t total = data_offset;
+
+    for (col = 0; col < n_columns; ++col) {
+      total += columns[col].size();
+    }
+    // keep the next block in a file aligned
+    total = INK_ALIGN_DEFAULT(total);
+
+    char *buf = (char *)ats_malloc(total);
+    LogColumnBlockHeader *header = (LogColumnBlockHeader *) buf;
+    LogColumnHeader *column_headers = (LogColumnHeader *) (buf + column_offset);
+
+    memset(buf, 0, total);
+    header->cookie = LOG_COLUMN_BLOCK_COOKIE;
+    header->version = LOG_COLUMN_BLOCK_VERSION;
+    header->byte_count = total;
+    header->entry_count = entry_count;
+    header->column_count = n_columns;
+    header->low_timestamp = buffer_header->low_timestamp;
+    header->high_timestamp = buffer_header->high_timestamp;
+    header->fmt_fieldlist_offset = sizeof(LogColumnBlockHeader);
+    header->column_offset = column_offset;
+    memcpy(buf + header->fmt_fieldlist_offset, fieldlist_str, fieldlist_len);
+
+    size_t offset = data_offset;
+    for (col = 0; col < n_columns; ++col) {
+      LogColumnBuilder & c = columns[col];
+
+      column_headers[col].type = c.type;
+      column_headers[col].dict_count = c.dict_count;
+      column_headers[col].data_offset = offset;
+      column_headers[col].data_len = c.size();
+      if (c.dict.spaceUsed()) {
+        memcpy(buf + offset, c.dict.bufPtr(), c.dict.spaceUsed());
+        offset += c.dict.spaceUsed();
+      }
+      if (c.data.spaceUsed()) {
+        memcpy(buf + offset, c.data.bufPtr(), c.data.spaceUsed());
+        offset += c.data.spaceUsed();
+      }
+    }
+    ink_assert(INK_ALIGN_DEFAULT(offset) == total);
+
+    *block = buf;
+    byte_count = (int) total;
+  }
+
+  delete[] columns;
+  return byte_count;
+}
+
+/*-------------------------------------------------------------------------
+  LogColumnBlock
+  -------------------------------------------------------------------------*/
+
+LogColumnBlock::LogColumnBlock(LogColumnBlockHeader * header)
+  : m_header(header), m_valid(false)
+{
+  ink_assert(header != NULL);
+
+  if (header->cookie != LOG_COLUMN_BLOCK_COOKIE || header->version != LOG_COLUMN_BLOCK_VERSION) {
+    return;
+  }
+  if (header->column_count == 0 || header->fmt_fieldlist_offset < sizeof(LogColumnBlockHeader) ||
+      header->fmt_fieldlist_offset >= header->byte_count || header->column_offset < sizeof(LogColumnBlockHeader) ||
+      header->column_offset + (uint64_t) header->column_count * sizeof(LogColumnHeader) > header->byte_count) {
+    return;
+  }
+  if (memchr(header->fmt_fieldlist(), 0, header->byte_count - header->fmt_fieldlist_offset) == NULL ||
+      count_symbols(header->fmt_fieldlist()) + 1 != header->column_count) {
+    return;
+  }
+
+  LogColumnHeader *columns = header->columns();
+  for (unsigned i = 0; i < header->column_count; ++i) {
+    if (columns[i].type > LOG_COLUMN_ENTRY_TIME ||
+        (uint64_t) columns[i].data_offset + columns[i].data_len > header->byte_count) {
+      return;
+    }
+  }
+  if (columns[0].type != LOG_COLUMN_TIMESTAMP) {
+    return;
+  }
+
+  m_valid = true;
+}
+
+int
+LogColumnBlock::find_column(const char *symbol) const
+{
+  const char *p = m_header->fmt_fieldlist();
+  size_t len = strlen(symbol);
+  int col = 1;
+
+  while (*p) {
+    if (*p == ',') {
+      ++p;
+      continue;
+    }
+
+    const char *end = strchr(p, ',');
+    size_t sym_len = end ? (size_t) (end - p) : strlen(p);
+
+    if (sym_len == len && memcmp(p, symbol, len) == 0) {
+      return col;
+    }
+    ++col;
+    p += sym_len;
+  }
+
+  return -1;
+}
+
+int
+LogColumnBlock::decode_timestamps(int64_t * sec, int32_t * usec) const
+{
+  LogColumnHeader *column = &m_header->columns()[0];
+  const uint8_t *p = (const uint8_t *) m_header + column->data_offset;
+  const uint8_t *end = p + column->data_len;
+  int64_t last = 0;
+  uint64_t v;
+
+  for (unsigned i = 0; i < m_header->entry_count; ++i) {
+    if ((p = log_column_get_varint(p, end, &v)) == NULL)
+      return -1;
+    last += log_column_unzigzag(v);
+    if (sec)
+      sec[i] = last;
+    if ((p = log_column_get_varint(p, end, &v)) == NULL)
+      return -1;
+    if (usec)
+      usec[i] = (int32_t) v;
+  }
+
+  return m_header->entry_count;
+}
+
+int
+LogColumnBlock::decode_ints(unsigned col, int64_t * values) const
+{
+  ink_assert(col < m_header->column_count);
+
+  LogColumnHeader *column = &m_header->columns()[col];
+
+  switch (column->type) {
+  case LOG_COLUMN_TIMESTAMP:
+  case LOG_COLUMN_ENTRY_TIME:
+    return decode_timestamps(values, NULL);
+
+  case LOG_COLUMN_INT:
+    {
+      const uint8_t *p = (const uint8_t *) m_header + column->data_offset;
+      const uint8_t *end = p + column->data_len;
+      int64_t last = 0;
+      uint64_t v;
+
+      for (unsigned i = 0; i < m_header->entry_count; ++i) {
+        if ((p = log_column_get_varint(p, end, &v)) == NULL)
+          return -1;
+        last += log_column_unzigzag(v);
+        values[i] = last;
+      }
+    }
+    return m_header->entry_count;
+
+  default:
+    return -1;
+  }
+}
+
+int
+LogColumnBlock::decode_dict(unsigned col, const char **dict, uint32_t * indexes) const
+{
+  ink_assert(col < m_header->column_count);
+
+  LogColumnHeader *column = &m_header->columns()[col];
+
+  if (column->type != LOG_COLUMN_DICT)
+    return -1;
+
+  const uint8_t *p = (const uint8_t *) m_header + column->data_offset;
+  const uint8_t *end = p + column->data_len;
+  uint64_t v;
+
+  for (unsigned i = 0; i < column->dict_count; ++i) {
+    if ((p = log_column_get_varint(p, end, &v)) == NULL || v >= (uint64_t) (end - p) || p[v] != '\0')
+      return -1;
+    dict[i] = (const char *) p;
+    p += v + 1;
+  }
+
+  for (unsigned i = 0; i < m_header->entry_count; ++i) {
+    if ((p = log_column_get_varint(p, end, &v)) == NULL || v >= column->dict_count)
+      return -1;
+    indexes[i] = (uint32_t) v;
+  }
+
+  return m_header->entry_count;
+}
@@ -0,0 +1,182 @@
+/** @file
+
+  Columnar on-disk representation of LogBuffers.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef LOG_COLUMNAR_H
+#define LOG_COLUMNAR_H
+
+#include "libts.h"
+#include "LogBuffer.h"
+
+#define LOG_COLUMN_BLOCK_COOKIE 0xc01face
+#define LOG_COLUMN_BLOCK_VERSION 1
+
+/*-------------------------------------------------------------------------
+  LogColumnType
+
+  How the values of a single column are laid down in a column block.
+  All integers are stored as zigzag varints; integer and timestamp
+  columns store the delta from the previous row, so sorted or slowly
+  changing values (timestamps, ports, sizes of similar objects) take one
+  or two bytes per row.
+  -------------------------------------------------------------------------*/
+
+enum LogColumnType
+{
+  LOG_COLUMN_TIMESTAMP = 0,     // entry timestamps: (delta seconds, usec) per row
+  LOG_COLUMN_INT,               // delta-encoded int64 values
+  LOG_COLUMN_DICT,              // dictionary of distinct strings + one index per row
+  LOG_COLUMN_ENTRY_TIME         // no data, the value is the entry timestamp
+};
+
+/*-------------------------------------------------------------------------
+  LogColumnHeader
+
+  One of these per column, laid down as an array right after the
+  LogColumnBlockHeader.  Offsets are from the start of the block.
+  -------------------------------------------------------------------------*/
+
+struct LogColumnHeader
+{
+  uint32_t type;                // LogColumnType
+  uint32_t dict_count;          // number of distinct values (LOG_COLUMN_DICT)
+  uint32_t data_offset;         // offset to the column data
+  uint32_t data_len;            // length of the column data
+};
+
+/*-------------------------------------------------------------------------
+  LogColumnBlockHeader
+
+  This struct is laid down at the head of each column block, which holds
+  the entries of exactly one LogBuffer.  Column 0 is always the entry
+  timestamp; column i (i > 0) holds the (i-1)th field of fmt_fieldlist.
+  -------------------------------------------------------------------------*/
+
+struct LogColumnBlockHeader
+{
+  uint32_t cookie;              // so we can find it on disk
+  uint32_t version;             // in case we want to change it later
+  uint32_t byte_count;          // actual # of bytes for the block
+  uint32_t entry_count;         // number of rows in every column
+  uint32_t column_count;        // number of columns, including timestamps
+  uint32_t low_timestamp;       // lowest timestamp value of entries
+  uint32_t high_timestamp;      // highest timestamp value of entries
+  uint32_t fmt_fieldlist_offset;        // offset to format fieldlist string
+  uint32_t column_offset;       // offset to LogColumnHeader array
+
+  char *fmt_fieldlist() { return fmt_fieldlist_offset ? (char *) this + fmt_fieldlist_offset : NULL; }
+  LogColumnHeader *columns() { return (LogColumnHeader *) ((char *) this + column_offset); }
+};
+
+/*-------------------------------------------------------------------------
+  LogColumnEncoder
+
+  Converts a (row oriented) LogBuffer into a column block.  String-like
+  fields are stored in the form they would be printed in an ASCII log,
+  so a query against a column block sees the same values as one against
+  the ASCII log.
+  -------------------------------------------------------------------------*/
+
+class LogColumnEncoder
+{
+public:
+  // Returns the size of the block placed in *block (allocated with
+  // ats_malloc, the caller frees), or -1 if the buffer can't be encoded.
+  static int encode(LogBufferHeader * buffer_header, char **block);
+};
+
+/*-------------------------------------------------------------------------
+  LogColumnBlock
+
+  Read-only view of a column block, used by traffic_logquery.  The decode
+  functions fill caller supplied arrays of entry_count() elements, so a
+  scan can run a tight loop over a whole column at a time.
+  -------------------------------------------------------------------------*/
+
+class LogColumnBlock
+{
+public:
+  explicit LogColumnBlock(LogColumnBlockHeader * header);
+
+  bool valid() const { return m_valid; }
+  unsigned entry_count() const { return m_header->entry_count; }
+  unsigned column_count() const { return m_header->column_count; }
+  LogColumnBlockHeader *header() const { return m_header; }
+
+  // Returns the column index for the given fieldlist symbol, or -1.
+  int find_column(const char *symbol) const;
+  LogColumnType column_type(unsigned col) const { return (LogColumnType) m_header->columns()[col].type; }
+  unsigned dict_count(unsigned col) const { return m_header->columns()[col].dict_count; }
+
+  int decode_timestamps(int64_t * sec, int32_t * usec) const;
+  int decode_ints(unsigned col, int64_t * values) const;
+  int decode_dict(unsigned col, const char **dict, uint32_t * indexes) const;
+
+private:
+  LogColumnBlockHeader *m_header;
+  bool m_valid;
+};
+
+/*-------------------------------------------------------------------------
+  Varint helpers, shared by the encoder and the reader.
+  -------------------------------------------------------------------------*/
+
+static inline uint64_t
+log_column_zigzag(int64_t v)
+{
+  return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static inline int64_t
+log_column_unzigzag(uint64_t v)
+{
+  return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+static inline int
+log_column_put_varint(uint8_t * buf, uint64_t v)
+{
+  int n = 0;
+  while (v >= 0x80) {
+    buf[n++] = (uint8_t) (v | 0x80);
+    v >>= 7;
+  }
+  buf[n++] = (uint8_t) v;
+  return n;
+}
+
+static inline const uint8_t *
+log_column_get_varint(const uint8_t * p, const uint8_t * end, uint64_t * v)
+{
+  uint64_t result = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    uint8_t b = *p++;
+    result |= (uint64_t) (b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      *v = result;
+      return p;
+    }
+  }
+  return NULL;
+}
+
+#endif
@@ -2067,7 +2067,8 @@ LogConfig::read_xml_log_config(int from_memory)
         char *mode_str = mode.dequeue();
         file_type = (strncasecmp(mode_str, "bin", 3) == 0 ||
                      (mode_str[0] == 'b' && mode_str[1] == 0) ?
-                     LOG_FILE_BINARY : (strcasecmp(mode_str, "ascii_pipe") == 0 ? LOG_FILE_PIPE : LOG_FILE_ASCII));
+                     LOG_FILE_BINARY : (strcasecmp(mode_str, "ascii_pipe") == 0 ? LOG_FILE_PIPE :
+                                        (strcasecmp(mode_str, "columnar") == 0 ? LOG_FILE_COLUMNAR : LOG_FILE_ASCII)));
       }
       // rolling
       //
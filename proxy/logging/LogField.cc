@@ -391,6 +391,21 @@ LogField::unmarshal(char **buf, char *dest, int len)
   }
 }
 
+/*-------------------------------------------------------------------------
+  LogField::is_plain_int
+
+  True if the field is marshalled as a single int64 and printed as a
+  plain decimal number, i.e. its ASCII value can be recreated from the
+  integer alone.
+  -------------------------------------------------------------------------*/
+bool
+LogField::is_plain_int()
+{
+  if (m_type != sINT && m_type != dINT)
+    return false;
+  return m_alias_map == NULL && m_unmarshal_func == (UnmarshalFunc)LogAccess::unmarshal_int_to_str;
+}
+
 /*-------------------------------------------------------------------------
   LogField::display
   -------------------------------------------------------------------------*/
@@ -160,6 +160,7 @@ public:
   {
     return m_time_field;
   }
+  bool is_plain_int();
 
   void set_aggregate_op(Aggregate agg_op);
   void update_aggregate(int64_t val);
@@ -44,6 +44,7 @@
 #include "LogFilter.h"
 #include "LogFormat.h"
 #include "LogBuffer.h"
+#include "LogColumnar.h"
 #include "LogFile.h"
 #include "LogHost.h"
 #include "LogObject.h"
@@ -241,7 +242,7 @@ LogFile::open_file()
   // file.
   //
   if (!file_exists) {
-    if (m_file_format != LOG_FILE_BINARY && m_header != NULL) {
+    if ((m_file_format == LOG_FILE_ASCII || m_file_format == LOG_FILE_PIPE) && m_header != NULL) {
       Debug("log-file", "writing header to LogFile %s", m_name);
       writeln(m_header, strlen(m_header), m_fd, m_name);
     }
@@ -506,6 +507,10 @@ LogFile::preproc_and_try_delete(LogBuffer * lb)
     write_ascii_logbuffer3(buffer_header);
     ret = 0;
   }
+  else if (m_file_format == LOG_FILE_COLUMNAR) {
+    write_columnar_logbuffer(buffer_header);
+    ret = 0;
+  }
   else {
     Note("Cannot write LogBuffer to LogFile %s; invalid file format: %d",
          m_name, m_file_format);
@@ -693,6 +698,53 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader * buffer_header, const char *alt
   return total_bytes;
 }
 
+/*-------------------------------------------------------------------------
+  LogFile::write_columnar_logbuffer
+
+  Re-encode the given LogBuffer as a column block (see LogColumnar.h) and
+  hand it to the flush thread.  Like the ASCII conversion, this runs in
+  the preproc thread so the flush thread only ever does plain writes.
+  -------------------------------------------------------------------------*/
+
+int
+LogFile::write_columnar_logbuffer(LogBufferHeader * buffer_header)
+{
+  Debug("log-file", "entering LogFile::write_columnar_logbuffer for %s " "(this=%p)", m_name, this);
+  ink_assert(buffer_header != NULL);
+
+  ProxyMutex *mutex = this_thread()->mutex;
+  char *block = NULL;
+  int block_bytes = LogColumnEncoder::encode(buffer_header, &block);
+
+  if (block_bytes < 0) {
+    Error("Failed to convert LogBuffer to columnar format, have dropped (%" PRIu32 ") entries.",
+          buffer_header->entry_count);
+
+    RecIncrRawStat(log_rsb, mutex->thread_holding,
+                   log_stat_num_lost_before_flush_to_disk_stat,
+                   buffer_header->entry_count);
+
+    RecIncrRawStat(log_rsb, mutex->thread_holding,
+                   log_stat_bytes_lost_before_flush_to_disk_stat,
+                   buffer_header->byte_count);
+    return 0;
+  }
+
+  LogFlushData *flush_data = new LogFlushData(this, block, block_bytes);
+
+  RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_num_flush_to_disk_stat,
+                 buffer_header->entry_count);
+
+  RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat,
+                 block_bytes);
+
+  ink_atomiclist_push(Log::flush_data_list, flush_data);
+
+  Log::flush_notify->signal();
+
+  return block_bytes;
+}
+
 /*-------------------------------------------------------------------------
   LogFile::writeln
 
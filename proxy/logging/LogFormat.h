@@ -43,6 +43,7 @@ enum LogFileFormat
   LOG_FILE_BINARY,
   LOG_FILE_ASCII,
   LOG_FILE_PIPE, // ie. ASCII pipe
+  LOG_FILE_COLUMNAR, // per-buffer column blocks, see LogColumnar.h
   N_LOGFILE_TYPES
 };
 
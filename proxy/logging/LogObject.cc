@@ -110,6 +110,8 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir,
         m_flags |= BINARY;
     } else if (file_format == LOG_FILE_PIPE) {
         m_flags |= WRITES_TO_PIPE;
+    } else if (file_format == LOG_FILE_COLUMNAR) {
+        m_flags |= COLUMNAR;
     }
 
     generate_filenames(log_dir, basename, file_format);
@@ -241,6 +243,10 @@ LogObject::generate_filenames(const char *log_dir, const char *basename, LogFile
       ext = LOG_FILE_PIPE_OBJECT_FILENAME_EXTENSION;
       ext_len = 5;
       break;
+    case LOG_FILE_COLUMNAR:
+      ext = LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION;
+      ext_len = 5;
+      break;
     default:
       ink_assert(!"unknown file format");
     }
@@ -0,0 +1,683 @@
+/** @file
+
+  Filter and aggregate over columnar (and binary) log files.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "libts.h"
+#undef std  // FIXME: remove dependency on the STL
+#include "I_Layout.h"
+
+#define PROGRAM_NAME        "traffic_logquery"
+
+#include <sys/mman.h>
+
+#include "LogStandalone.cc"
+
+#include "LogField.h"
+#include "LogFormat.h"
+#include "LogBuffer.h"
+#include "LogColumnar.h"
+#include "LogObject.h"
+#include "Log.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+using namespace std;
+
+// logquery-specific command-line flags
+static char where_str[4096];
+static char group_symbol[256];
+static char sum_symbol[256];
+static int64_t begin_time = 0;
+static int64_t end_time = 0;
+static int limit = 0;
+static int columns_flag = 0;
+static char output_file[1024];
+static int output_fd = -1;
+int auto_clear_cache_flag = 0;
+
+static const ArgumentDescription argument_descriptions[] = {
+
+  {"where", 'w', "Filter, e.g. \"pssc>=500;shn=example.com\"", "S4095", where_str, NULL, NULL},
+  {"group", 'g', "Group results by this field symbol", "S255", group_symbol, NULL, NULL},
+  {"sum", 's', "Sum this field symbol", "S255", sum_symbol, NULL, NULL},
+  {"begin", 'b', "Only entries at or after this timestamp", "L", &begin_time, NULL, NULL},
+  {"end", 'e', "Only entries at or before this timestamp", "L", &end_time, NULL, NULL},
+  {"limit", 'l', "Show at most this many groups", "I", &limit, NULL, NULL},
+  {"columns", 'c', "List the columns of the file(s) and exit", "T", &columns_flag, NULL, NULL},
+  {"output_file", 'o', "Also write all blocks, in columnar format, to this file", "S1023", output_file, NULL, NULL},
+  {"debug_tags", 'T', "Colon-Separated Debug Tags", "S1023", error_tags, NULL, NULL},
+  HELP_ARGUMENT_DESCRIPTION(),
+  VERSION_ARGUMENT_DESCRIPTION()
+};
+
+static const char *USAGE_LINE =
+  "Usage: " PROGRAM_NAME " [-w filter] [-g symbol] [-s symbol] [-b time] [-e time] [-l limit] [-c] [-o file] file ...";
+
+/*-------------------------------------------------------------------------
+  Predicates
+
+  A filter is a ';' separated list of "symbol OP value" terms, which all
+  have to match.  OP is one of =, !=, <, <=, >, >= or ~ (substring).
+  Relational operators compare numerically, also for string columns.
+  -------------------------------------------------------------------------*/
+
+enum QueryOp
+{
+  OP_EQ,
+  OP_NE,
+  OP_LT,
+  OP_LE,
+  OP_GT,
+  OP_GE,
+  OP_CONTAINS
+};
+
+struct QueryPredicate
+{
+  string symbol;
+  QueryOp op;
+  string value;
+  bool numeric;                 // value parses as a number
+  double dval;
+  int64_t ival;
+};
+
+static vector<QueryPredicate> predicates;
+
+static bool
+parse_predicate(const char *term, QueryPredicate & pred)
+{
+  const char *op = strpbrk(term, "!=<>~");
+
+  if (op == NULL || op == term) {
+    return false;
+  }
+
+  pred.symbol.assign(term, op - term);
+  switch (*op) {
+  case '=':
+    pred.op = OP_EQ;
+    break;
+  case '~':
+    pred.op = OP_CONTAINS;
+    break;
+  case '!':
+    if (op[1] != '=')
+      return false;
+    pred.op = OP_NE;
+    ++op;
+    break;
+  case '<':
+    pred.op = (op[1] == '=') ? OP_LE : OP_LT;
+    op += (op[1] == '=');
+    break;
+  case '>':
+    pred.op = (op[1] == '=') ? OP_GE : OP_GT;
+    op += (op[1] == '=');
+    break;
+  }
+  pred.value = op + 1;
+
+  char *end;
+  pred.dval = strtod(pred.value.c_str(), &end);
+  pred.numeric = !pred.value.empty() && *end == '\0';
+  pred.ival = (int64_t) pred.dval;
+
+  if ((pred.op != OP_EQ && pred.op != OP_NE && pred.op != OP_CONTAINS) && !pred.numeric) {
+    return false;
+  }
+  return true;
+}
+
+static bool
+parse_where(char *where)
+{
+  char *saveptr;
+
+  for (char *term = strtok_r(where, ";", &saveptr); term; term = strtok_r(NULL, ";", &saveptr)) {
+    QueryPredicate pred;
+
+    if (!parse_predicate(term, pred)) {
+      fprintf(stderr, "Invalid filter term: %s\n", term);
+      return false;
+    }
+    predicates.push_back(pred);
+  }
+  return true;
+}
+
+// Evaluate a predicate against a single string value; for dictionary
+// columns this runs once per distinct value rather than once per row.
+static bool
+match_string(const QueryPredicate & pred, const char *str)
+{
+  switch (pred.op) {
+  case OP_EQ:
+    return pred.value == str;
+  case OP_NE:
+    return pred.value != str;
+  case OP_CONTAINS:
+    return strstr(str, pred.value.c_str()) != NULL;
+  default:
+    break;
+  }
+
+  char *end;
+  double v = strtod(str, &end);
+
+  if (end == str) {
+    return false;
+  }
+  switch (pred.op) {
+  case OP_LT:
+    return v < pred.dval;
+  case OP_LE:
+    return v <= pred.dval;
+  case OP_GT:
+    return v > pred.dval;
+  case OP_GE:
+    return v >= pred.dval;
+  default:
+    return false;
+  }
+}
+
+// The loops below are written so the compiler can vectorize them: no
+// early exits, and the selection vector is updated with plain ANDs.
+static void
+filter_ints(const QueryPredicate & pred, const int64_t * values, uint8_t * sel, unsigned n)
+{
+  const int64_t k = pred.ival;
+
+  if (!pred.numeric) {
+    // a non-numeric value never equals an integer column
+    uint8_t r = (pred.op == OP_NE);
+    for (unsigned i = 0; i < n; ++i)
+      sel[i] &= r;
+    return;
+  }
+
+  switch (pred.op) {
+  case OP_EQ:
+    for (unsigned i = 0; i < n; ++i)
+      sel[i] &= (values[i] == k);
+    break;
+  case OP_NE:
+    for (unsigned i = 0; i < n; ++i)
+      sel[i] &= (values[i] != k);
+    break;
+  case OP_LT:
+    for (unsigned i = 0; i < n; ++i)
+      sel[i] &= (values[i] < k);
+    break;
+  case OP_LE:
+    for (unsigned i = 0; i < n; ++i)
+      sel[i] &= (values[i] <= k);
+    break;
+  case OP_GT:
+    for (unsigned i = 0; i < n; ++i)
+      sel[i] &= (values[i] > k);
+    break;
+  case OP_GE:
+    for (unsigned i = 0; i < n; ++i)
+      sel[i] &= (values[i] >= k);
+    break;
+  case OP_CONTAINS:
+    {
+      char buf[32];
+      for (unsigned i = 0; i < n; ++i) {
+        if (sel[i]) {
+          snprintf(buf, sizeof(buf), "%" PRId64, values[i]);
+          sel[i] = strstr(buf, pred.value.c_str()) != NULL;
+        }
+      }
+    }
+    break;
+  }
+}
+
+/*-------------------------------------------------------------------------
+  Aggregation state
+  -------------------------------------------------------------------------*/
+
+struct QueryAggregate
+{
+  int64_t count;
+  double sum;
+
+  QueryAggregate() : count(0), sum(0) { }
+};
+
+typedef map<string, QueryAggregate> GroupMap;
+
+static QueryAggregate totals;
+static GroupMap groups;
+
+// Scratch space reused across blocks.
+struct QueryScratch
+{
+  vector<uint8_t> sel;
+  vector<int64_t> ints;
+  vector<uint32_t> indexes;
+  vector<const char *> dict;
+  vector<uint8_t> dict_match;
+  vector<double> sums;
+  vector<int64_t> group_ints;
+  vector<uint32_t> group_indexes;
+  vector<const char *> group_dict;
+};
+
+static QueryScratch scratch;
+
+// Returns false if the block is corrupt.
+static bool
+decode_numeric(LogColumnBlock & block, int col, vector<double> & out)
+{
+  unsigned n = block.entry_count();
+
+  out.resize(n);
+  if (block.column_type(col) == LOG_COLUMN_DICT) {
+    unsigned nd = block.dict_count(col);
+    vector<double> dict_values(nd);
+
+    scratch.dict.resize(nd);
+    scratch.indexes.resize(n);
+    if (block.decode_dict(col, &scratch.dict[0], &scratch.indexes[0]) < 0)
+      return false;
+    for (unsigned k = 0; k < nd; ++k)
+      dict_values[k] = strtod(scratch.dict[k], NULL);
+    for (unsigned i = 0; i < n; ++i)
+      out[i] = dict_values[scratch.indexes[i]];
+  } else {
+    scratch.ints.resize(n);
+    if (block.decode_ints(col, &scratch.ints[0]) < 0)
+      return false;
+    for (unsigned i = 0; i < n; ++i)
+      out[i] = (double) scratch.ints[i];
+  }
+  return true;
+}
+
+static bool
+process_block(LogColumnBlock & block)
+{
+  LogColumnBlockHeader *header = block.header();
+  unsigned n = block.entry_count();
+
+  if (n == 0)
+    return true;
+  if ((begin_time && header->high_timestamp < begin_time) || (end_time && header->low_timestamp > end_time))
+    return true;
+
+  vector<uint8_t> & sel = scratch.sel;
+  sel.assign(n, 1);
+
+  if (begin_time || end_time) {
+    const int64_t lo = begin_time, hi = end_time ? end_time : INT64_MAX;
+
+    scratch.ints.resize(n);
+    if (block.decode_timestamps(&scratch.ints[0], NULL) < 0)
+      return false;
+    for (unsigned i = 0; i < n; ++i)
+      sel[i] &= (scratch.ints[i] >= lo) & (scratch.ints[i] <= hi);
+  }
+
+  for (unsigned p = 0; p < predicates.size(); ++p) {
+    const QueryPredicate & pred = predicates[p];
+    int col = block.find_column(pred.symbol.c_str());
+
+    if (col < 0) {
+      // the field isn't logged in this block, nothing can match
+      return true;
+    }
+
+    if (block.column_type(col) == LOG_COLUMN_DICT) {
+      unsigned nd = block.dict_count(col);
+
+      scratch.dict.resize(nd);
+      scratch.dict_match.resize(nd);
+      scratch.indexes.resize(n);
+      if (block.decode_dict(col, &scratch.dict[0], &scratch.indexes[0]) < 0)
+        return false;
+      for (unsigned k = 0; k < nd; ++k)
+        scratch.dict_match[k] = match_string(pred, scratch.dict[k]);
+      for (unsigned i = 0; i < n; ++i)
+        sel[i] &= scratch.dict_match[scratch.indexes[i]];
+    } else {
+      scratch.ints.resize(n);
+      if (block.decode_ints(col, &scratch.ints[0]) < 0)
+        return false;
+      filter_ints(pred, &scratch.ints[0], &sel[0], n);
+    }
+  }
+
+  bool have_sum = false;
+  if (sum_symbol[0]) {
+    int col = block.find_column(sum_symbol);
+    if (col >= 0) {
+      if (!decode_numeric(block, col, scratch.sums))
+        return false;
+      have_sum = true;
+    }
+  }
+
+  unsigned selected = 0;
+  double sum = 0;
+  for (unsigned i = 0; i < n; ++i)
+    selected += sel[i];
+  if (have_sum) {
+    for (unsigned i = 0; i < n; ++i)
+      sum += sel[i] ? scratch.sums[i] : 0.0;
+  }
+  totals.count += selected;
+  totals.sum += sum;
+
+  if (group_symbol[0] == 0 || selected == 0)
+    return true;
+
+  int gcol = block.find_column(group_symbol);
+  if (gcol < 0) {
+    QueryAggregate & agg = groups["-"];
+    agg.count += selected;
+    agg.sum += sum;
+    return true;
+  }
+
+  if (block.column_type(gcol) == LOG_COLUMN_DICT) {
+    // aggregate per dictionary index first, then merge by value
+    unsigned nd = block.dict_count(gcol);
+    vector<QueryAggregate> local(nd);
+
+    scratch.group_dict.resize(nd);
+    scratch.group_indexes.resize(n);
+    if (block.decode_dict(gcol, &scratch.group_dict[0], &scratch.group_indexes[0]) < 0)
+      return false;
+    for (unsigned i = 0; i < n; ++i) {
+      QueryAggregate & agg = local[scratch.group_indexes[i]];
+      agg.count += sel[i];
+      if (have_sum && sel[i])
+        agg.sum += scratch.sums[i];
+    }
+    for (unsigned k = 0; k < nd; ++k) {
+      if (local[k].count) {
+        QueryAggregate & agg = groups[scratch.group_dict[k]];
+        agg.count += local[k].count;
+        agg.sum += local[k].sum;
+      }
+    }
+  } else {
+    map<int64_t, QueryAggregate> local;
+
+    scratch.group_ints.resize(n);
+    if (block.decode_ints(gcol, &scratch.group_ints[0]) < 0)
+      return false;
+    for (unsigned i = 0; i < n; ++i) {
+      if (sel[i]) {
+        QueryAggregate & agg = local[scratch.group_ints[i]];
+        agg.count += 1;
+        if (have_sum)
+          agg.sum += scratch.sums[i];
+      }
+    }
+    for (map<int64_t, QueryAggregate>::iterator it = local.begin(); it != local.end(); ++it) {
+      char key[32];
+      snprintf(key, sizeof(key), "%" PRId64, it->first);
+      QueryAggregate & agg = groups[key];
+      agg.count += it->second.count;
+      agg.sum += it->second.sum;
+    }
+  }
+
+  return true;
+}
+
+static const char *
+column_type_name(LogColumnType type)
+{
+  switch (type) {
+  case LOG_COLUMN_TIMESTAMP:
+    return "timestamp";
+  case LOG_COLUMN_INT:
+    return "int";
+  case LOG_COLUMN_DICT:
+    return "dict";
+  case LOG_COLUMN_ENTRY_TIME:
+    return "entry_time";
+  }
+  return "unknown";
+}
+
+static void
+show_columns(LogColumnBlock & block)
+{
+  const char *p = block.header()->fmt_fieldlist();
+
+  printf("%-24s %s\n", "(entry timestamp)", column_type_name(block.column_type(0)));
+  for (unsigned col = 1; col < block.column_count(); ++col) {
+    while (*p == ',')
+      ++p;
+    const char *end = strchr(p, ',');
+    int len = end ? (int) (end - p) : (int) strlen(p);
+    printf("%-24.*s %s\n", len, p, column_type_name(block.column_type(col)));
+    p += len;
+  }
+}
+
+/*-------------------------------------------------------------------------
+  process_file
+
+  The file is mapped and walked one block at a time.  Binary (.blog)
+  buffers are converted to column blocks on the fly, so the same queries
+  work against older logs.
+  -------------------------------------------------------------------------*/
+
+static int
+process_file(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+
+  if (fd < 0) {
+    fprintf(stderr, "Error opening input file %s: %s\n", path, strerror(errno));
+    return 1;
+  }
+  if (fstat(fd, &st) < 0) {
+    fprintf(stderr, "Error accessing input file %s: %s\n", path, strerror(errno));
+    close(fd);
+    return 1;
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+
+  char *base = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    fprintf(stderr, "Error mapping input file %s: %s\n", path, strerror(errno));
+    return 1;
+  }
+  ats_madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+  int error = 0;
+  off_t offset = 0;
+
+  while (offset + (off_t) sizeof(uint32_t) * 2 <= st.st_size) {
+    uint32_t cookie = *(uint32_t *) (base + offset);
+    char *converted = NULL;
+    LogColumnBlockHeader *header = NULL;
+    uint32_t byte_count = 0;
+
+    if (cookie == LOG_COLUMN_BLOCK_COOKIE && offset + (off_t) sizeof(LogColumnBlockHeader) <= st.st_size) {
+      header = (LogColumnBlockHeader *) (base + offset);
+      byte_count = header->byte_count;
+    } else if (cookie == LOG_SEGMENT_COOKIE && offset + (off_t) sizeof(LogBufferHeader) <= st.st_size) {
+      LogBufferHeader *buffer_header = (LogBufferHeader *) (base + offset);
+
+      byte_count = buffer_header->byte_count;
+      if (byte_count >= sizeof(LogBufferHeader) && offset + byte_count <= st.st_size &&
+          LogColumnEncoder::encode(buffer_header, &converted) >= 0) {
+        header = (LogColumnBlockHeader *) converted;
+      } else if (byte_count >= sizeof(LogBufferHeader) && offset + byte_count <= st.st_size) {
+        // a buffer we can't decode (e.g. unknown fields), skip it
+        offset += byte_count;
+        continue;
+      }
+    }
+
+    if (header == NULL || byte_count < sizeof(uint32_t) * 2 || offset + byte_count > st.st_size) {
+      fprintf(stderr, "Bad log block at offset %" PRId64 " in %s\n", (int64_t) offset, path);
+      error = 1;
+      break;
+    }
+
+    LogColumnBlock block(header);
+    if (!block.valid()) {
+      fprintf(stderr, "Bad log block at offset %" PRId64 " in %s\n", (int64_t) offset, path);
+      ats_free(converted);
+      error = 1;
+      break;
+    }
+
+    if (columns_flag) {
+      show_columns(block);
+      ats_free(converted);
+      break;
+    }
+
+    if (output_fd >= 0 && write(output_fd, header, header->byte_count) != (ssize_t) header->byte_count) {
+      fprintf(stderr, "Error writing output file %s: %s\n", output_file, strerror(errno));
+      output_fd = -1;
+      error = 1;
+    }
+
+    if (!process_block(block)) {
+      fprintf(stderr, "Corrupt column data at offset %" PRId64 " in %s\n", (int64_t) offset, path);
+      error = 1;
+    }
+    ats_free(converted);
+    offset += byte_count;
+  }
+
+  munmap(base, st.st_size);
+  return error;
+}
+
+static bool
+compare_groups(const GroupMap::value_type * a, const GroupMap::value_type * b)
+{
+  if (a->second.count != b->second.count)
+    return a->second.count > b->second.count;
+  return a->first < b->first;
+}
+
+static void
+print_results()
+{
+  if (group_symbol[0] == 0) {
+    printf("count\t%" PRId64 "\n", totals.count);
+    if (sum_symbol[0])
+      printf("sum\t%.0f\n", totals.sum);
+    return;
+  }
+
+  vector<const GroupMap::value_type *> sorted;
+  for (GroupMap::const_iterator it = groups.begin(); it != groups.end(); ++it)
+    sorted.push_back(&*it);
+  sort(sorted.begin(), sorted.end(), compare_groups);
+
+  unsigned n = sorted.size();
+  if (limit > 0 && (unsigned) limit < n)
+    n = limit;
+
+  printf(sum_symbol[0] ? "count\tsum\t%s\n" : "count\t%s\n", group_symbol);
+  for (unsigned i = 0; i < n; ++i) {
+    if (sum_symbol[0])
+      printf("%" PRId64 "\t%.0f\t%s\n", sorted[i]->second.count, sorted[i]->second.sum, sorted[i]->first.c_str());
+    else
+      printf("%" PRId64 "\t%s\n", sorted[i]->second.count, sorted[i]->first.c_str());
+  }
+}
+
+/*-------------------------------------------------------------------------
+  main
+  -------------------------------------------------------------------------*/
+
+int
+main(int /* argc ATS_UNUSED */, char *argv[])
+{
+  enum
+  {
+    NO_ERROR = 0,
+    CMD_LINE_OPTION_ERROR = 1,
+    DATA_PROCESSING_ERROR = 2
+  };
+
+  // build the application information structure
+  //
+  appVersionInfo.setup(PACKAGE_NAME,PROGRAM_NAME, PACKAGE_VERSION, __DATE__,
+                       __TIME__, BUILD_MACHINE, BUILD_PERSON, "");
+
+  // Before accessing file system initialize Layout engine
+  Layout::create();
+  process_args(&appVersionInfo, argument_descriptions, countof(argument_descriptions), argv, USAGE_LINE);
+
+  if (n_file_arguments == 0) {
+    fprintf(stderr, "%s\n", USAGE_LINE);
+    _exit(CMD_LINE_OPTION_ERROR);
+  }
+  if (where_str[0] && !parse_where(where_str)) {
+    _exit(CMD_LINE_OPTION_ERROR);
+  }
+
+  // initialize this application for standalone logging operation; the
+  // field list is needed to convert binary buffers
+  //
+  init_log_standalone_basic(PROGRAM_NAME);
+
+  Log::init(Log::NO_REMOTE_MANAGEMENT | Log::LOGCAT);
+
+  if (output_file[0] != 0) {
+    output_fd = open(output_file, O_WRONLY | O_TRUNC | O_CREAT, 0640);
+    if (output_fd < 0) {
+      fprintf(stderr, "Error while opening output file %s: %s\n", output_file, strerror(errno));
+      _exit(DATA_PROCESSING_ERROR);
+    }
+  }
+
+  int error = NO_ERROR;
+
+  for (unsigned i = 0; i < n_file_arguments; ++i) {
+    if (process_file(file_arguments[i]) != 0) {
+      error = DATA_PROCESSING_ERROR;
+    }
+  }
+
+  if (!columns_flag) {
+    print_results();
+  }
+
+  _exit(error);
+}
@@ -380,6 +380,7 @@ rehash(T& container, N size) {
 
 // LRU class for the URL data
 void  update_elapsed(ElapsedStats &stat, const int elapsed, const StatsCounter &counter);
+void  init_elapsed(OriginStats *stats);
 
 class UrlLru
 {
@@ -617,6 +618,30 @@ static OriginStorage origins;
 static OriginSet *origin_set;
 static UrlLru *urls;
 static int parse_errors;
+static LogFieldList *fieldlist;
+
+// Per thread stats, each parser thread aggregates a contiguous range of
+// LogBuffers into its own shard, which are merged into the globals above
+// once all threads are done.
+struct ParseShard
+{
+  OriginStats totals;
+  OriginStorage origins;
+  int parse_errors;
+
+  // The LogBuffers this shard is responsible for.
+  LogBufferHeader **buffers;
+  int num_buffers;
+  unsigned max_age;
+  int ret;
+
+  ParseShard()
+    : parse_errors(0), buffers(NULL), num_buffers(0), max_age(0), ret(0)
+  {
+    memset(&totals, 0, sizeof(totals));
+    init_elapsed(&totals);
+  }
+};
 
 // Command line arguments (parsing)
 struct CommandLineArgs
@@ -637,10 +662,11 @@ struct CommandLineArgs
   int urls;			// Produce JSON output of URL stats, arg is LRU size
   int show_urls;		// Max URLs to show
   int as_object;		// Show the URL stats as a single JSON object (not array)
+  int threads;			// Number of parser threads, 0 means one per CPU
 
   CommandLineArgs()
     : max_origins(0), min_hits(0), max_age(0), line_len(DEFAULT_LINE_LEN), incremental(0),
-      tail(0), summary(0), json(0), cgi(0), urls(0), show_urls(0), as_object(0)
+      tail(0), summary(0), json(0), cgi(0), urls(0), show_urls(0), as_object(0), threads(0)
   {
     log_file[0] = '\0';
     origin_file[0] = '\0';
@@ -670,6 +696,7 @@ static ArgumentDescription argument_descriptions[] = {
   {"min_hits", 'm', "Minimum total hits for an Origin", "L", &cl.min_hits, NULL, NULL},
   {"max_age", 'a', "Max age for log entries to be considered", "I", &cl.max_age, NULL, NULL},
   {"line_len", 'l', "Output line length", "I", &cl.line_len, NULL, NULL},
+  {"threads", 'n', "Number of parser threads (0 = one per CPU)", "I", &cl.threads, NULL, NULL},
   {"debug_tags", 'T', "Colon-Separated Debug Tags", "S1023", &error_tags, NULL, NULL},
   HELP_ARGUMENT_DESCRIPTION(),
   VERSION_ARGUMENT_DESCRIPTION()
@@ -1184,13 +1211,120 @@ update_schemes(OriginStats * stat, int scheme, int size)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Merge the elapsed stats of two disjoint sets of records, the counts are
+// those of the StatsCounter that update_elapsed() used for each of them.
+inline void
+merge_elapsed(ElapsedStats &stat, int64_t count, const ElapsedStats &other, int64_t other_count)
+{
+  int64_t newcount = count + other_count;
+  double delta, sum_of_squares;
+
+  if (-1 == other.min)
+    return;
+  if ((-1 == stat.min) || (stat.min > other.min))
+    stat.min = other.min;
+  if (stat.max < other.max)
+    stat.max = other.max;
+
+  if (0 == count) {
+    stat.avg = other.avg;
+    stat.stddev = other.stddev;
+    return;
+  }
+
+  // Combine the sums of squares of both sets around the new average.
+  delta = other.avg - stat.avg;
+  sum_of_squares = (double)stat.stddev * stat.stddev * count + (double)other.stddev * other.stddev * other_count
+    + delta * delta * count * other_count / newcount;
+
+  stat.avg = ((double)stat.avg * count + (double)other.avg * other_count) / newcount;
+  stat.stddev = sqrt(sum_of_squares / newcount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Merge the stats from one Origin (or the totals) into another
+void
+merge_origin_stats(OriginStats * stat, const OriginStats * other)
+{
+  // The elapsed stats must be merged before the counters they belong to.
+  merge_elapsed(stat->elapsed.hits.hit, stat->results.hits.hit.count,
+                other->elapsed.hits.hit, other->results.hits.hit.count);
+  merge_elapsed(stat->elapsed.hits.ims, stat->results.hits.ims.count,
+                other->elapsed.hits.ims, other->results.hits.ims.count);
+  merge_elapsed(stat->elapsed.hits.refresh, stat->results.hits.refresh.count,
+                other->elapsed.hits.refresh, other->results.hits.refresh.count);
+  merge_elapsed(stat->elapsed.hits.other, stat->results.hits.other.count,
+                other->elapsed.hits.other, other->results.hits.other.count);
+  merge_elapsed(stat->elapsed.hits.total, stat->results.hits.total.count,
+                other->elapsed.hits.total, other->results.hits.total.count);
+  merge_elapsed(stat->elapsed.misses.miss, stat->results.misses.miss.count,
+                other->elapsed.misses.miss, other->results.misses.miss.count);
+  merge_elapsed(stat->elapsed.misses.ims, stat->results.misses.ims.count,
+                other->elapsed.misses.ims, other->results.misses.ims.count);
+  merge_elapsed(stat->elapsed.misses.refresh, stat->results.misses.refresh.count,
+                other->elapsed.misses.refresh, other->results.misses.refresh.count);
+  merge_elapsed(stat->elapsed.misses.other, stat->results.misses.other.count,
+                other->elapsed.misses.other, other->results.misses.other.count);
+  merge_elapsed(stat->elapsed.misses.total, stat->results.misses.total.count,
+                other->elapsed.misses.total, other->results.misses.total.count);
+
+  stat->total.count += other->total.count;
+  stat->total.bytes += other->total.bytes;
+
+  // Everything from the "results" onwards is a StatsCounter.
+  StatsCounter *dst = reinterpret_cast<StatsCounter *>(&stat->results);
+  const StatsCounter *src = reinterpret_cast<const StatsCounter *>(&other->results);
+  const int num_counters = (sizeof(OriginStats) - offsetof(OriginStats, results)) / sizeof(StatsCounter);
+
+  for (int i = 0; i < num_counters; ++i) {
+    dst[i].count += src[i].count;
+    dst[i].bytes += src[i].bytes;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Merge a parser thread's shard into the global stats, and release it
+void
+merge_shard(ParseShard * shard)
+{
+  merge_origin_stats(&totals, &shard->totals);
+  parse_errors += shard->parse_errors;
+
+  for (OriginStorage::iterator i = shard->origins.begin(); i != shard->origins.end(); ++i) {
+    OriginStorage::iterator o_iter = origins.find(i->first);
+
+    if (origins.end() == o_iter) {
+      origins[i->first] = i->second;
+    } else {
+      merge_origin_stats(o_iter->second, i->second);
+      ats_free(const_cast<char *>(i->second->server));
+      ats_free(i->second);
+    }
+  }
+  shard->origins.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Setup the field list from the first log buffer. This has to happen before
+// any parser threads are started, they all share this list.
+void
+init_fieldlist(LogBufferHeader * buf_header)
+{
+  if (!fieldlist) {
+    fieldlist = new LogFieldList;
+    ink_assert(fieldlist != NULL);
+    bool agg = false;
+    LogFormat::parse_symbol_string(buf_header->fmt_fieldlist(), fieldlist, &agg);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Parse a log buffer
 int
-parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
+parse_log_buff(LogBufferHeader * buf_header, ParseShard * shard, bool summary = false)
 {
-  static LogFieldList *fieldlist = NULL;
-
   LogEntryHeader *entry;
   LogBufferIterator buf_iter(buf_header);
   LogField *field;
@@ -1210,12 +1344,7 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
   HTTPMethod method;
   URLScheme scheme;
 
-  if (!fieldlist) {
-    fieldlist = new LogFieldList;
-    ink_assert(fieldlist != NULL);
-    bool agg = false;
-    LogFormat::parse_symbol_string(buf_header->fmt_fieldlist(), fieldlist, &agg);
-  }
+  init_fieldlist(buf_header);
   // Loop over all entries
   while ((entry = buf_iter.next())) {
     read_from = (char *) entry + sizeof(LogEntryHeader);
@@ -1359,15 +1488,15 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
             // TODO: If we save state (struct) for a run, we probably need to always
             // update the origin data, no matter what the origin_set is.
             if (origin_set->empty() || (origin_set->find(tok) != origin_set->end())) {
-              o_iter = origins.find(tok);
-              if (origins.end() == o_iter) {
+              o_iter = shard->origins.find(tok);
+              if (shard->origins.end() == o_iter) {
                 o_stats = (OriginStats *)ats_malloc(sizeof(OriginStats));
                 memset(o_stats, 0, sizeof(OriginStats));
                 init_elapsed(o_stats);
                 o_server = ats_strdup(tok);
                 if (o_stats && o_server) {
                   o_stats->server = o_server;
-                  origins[o_server] = o_stats;
+                  shard->origins[o_server] = o_stats;
                 }
               } else
                 o_stats = o_iter->second;
@@ -1382,11 +1511,11 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
         read_from += LogAccess::round_strlen(tok_len + 1);
 
         // Update the stats so far, since now we have the Origin (maybe)
-        update_results_elapsed(&totals, result, elapsed, size);
-        update_codes(&totals, http_code, size);
-        update_methods(&totals, method, size);
-        update_schemes(&totals, scheme, size);
-        update_counter(totals.total, size);
+        update_results_elapsed(&shard->totals, result, elapsed, size);
+        update_codes(&shard->totals, http_code, size);
+        update_methods(&shard->totals, method, size);
+        update_schemes(&shard->totals, scheme, size);
+        update_counter(shard->totals.total, size);
         if (o_stats != NULL) {
           update_results_elapsed(o_stats, result, elapsed, size);
           update_codes(o_stats, http_code, size);
@@ -1409,37 +1538,37 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
         hier = *((int64_t *) (read_from));
         switch (hier) {
         case SQUID_HIER_NONE:
-          update_counter(totals.hierarchies.none, size);
+          update_counter(shard->totals.hierarchies.none, size);
           if (o_stats != NULL)
             update_counter(o_stats->hierarchies.none, size);
           break;
         case SQUID_HIER_DIRECT:
-          update_counter(totals.hierarchies.direct, size);
+          update_counter(shard->totals.hierarchies.direct, size);
           if (o_stats != NULL)
             update_counter(o_stats->hierarchies.direct, size);
           break;
         case SQUID_HIER_SIBLING_HIT:
-          update_counter(totals.hierarchies.sibling, size);
+          update_counter(shard->totals.hierarchies.sibling, size);
           if (o_stats != NULL)
             update_counter(o_stats->hierarchies.sibling, size);
           break;
         case SQUID_HIER_PARENT_HIT:
-          update_counter(totals.hierarchies.parent, size);
+          update_counter(shard->totals.hierarchies.parent, size);
           if (o_stats != NULL)
             update_counter(o_stats->hierarchies.direct, size);
           break;
         case SQUID_HIER_EMPTY:
-          update_counter(totals.hierarchies.empty, size);
+          update_counter(shard->totals.hierarchies.empty, size);
           if (o_stats != NULL)
             update_counter(o_stats->hierarchies.empty, size);
           break;
         default:
           if ((hier >= SQUID_HIER_EMPTY) && (hier < SQUID_HIER_INVALID_ASSIGNED_CODE)) {
-            update_counter(totals.hierarchies.other, size);
+            update_counter(shard->totals.hierarchies.other, size);
             if (o_stats != NULL)
               update_counter(o_stats->hierarchies.other, size);
           } else {
-            update_counter(totals.hierarchies.invalid, size);
+            update_counter(shard->totals.hierarchies.invalid, size);
             if (o_stats != NULL)
               update_counter(o_stats->hierarchies.invalid, size);
           }
@@ -1459,128 +1588,128 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
       case P_STATE_TYPE:
         state = P_STATE_END;
         if (IMAG_AS_INT == *reinterpret_cast <int*>(read_from)) {
-          update_counter(totals.content.image.total, size);
+          update_counter(shard->totals.content.image.total, size);
           if (o_stats != NULL)
             update_counter(o_stats->content.image.total, size);
           tok = read_from + 6;
           switch (*reinterpret_cast <int*>(tok)) {
           case JPEG_AS_INT:
             tok_len = 10;
-            update_counter(totals.content.image.jpeg, size);
+            update_counter(shard->totals.content.image.jpeg, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.image.jpeg, size);
             break;
           case JPG_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.image.jpeg, size);
+            update_counter(shard->totals.content.image.jpeg, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.image.jpeg, size);
             break;
           case GIF_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.image.gif, size);
+            update_counter(shard->totals.content.image.gif, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.image.gif, size);
             break;
           case PNG_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.image.png, size);
+            update_counter(shard->totals.content.image.png, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.image.png, size);
             break;
           case BMP_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.image.bmp, size);
+            update_counter(shard->totals.content.image.bmp, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.image.bmp, size);
             break;
           default:
             tok_len = 6 + strlen(tok);
-            update_counter(totals.content.image.other, size);
+            update_counter(shard->totals.content.image.other, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.image.other, size);
             break;
           }
         } else if (TEXT_AS_INT == *reinterpret_cast <int*>(read_from)) {
           tok = read_from + 5;
-          update_counter(totals.content.text.total, size);
+          update_counter(shard->totals.content.text.total, size);
           if (o_stats != NULL)
             update_counter(o_stats->content.text.total, size);
           switch (*reinterpret_cast <int*>(tok)) {
           case JAVA_AS_INT:
             // TODO verify if really "javascript"
             tok_len = 15;
-            update_counter(totals.content.text.javascript, size);
+            update_counter(shard->totals.content.text.javascript, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.text.javascript, size);
             break;
           case CSS_AS_INT:
             tok_len = 8;
-            update_counter(totals.content.text.css, size);
+            update_counter(shard->totals.content.text.css, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.text.css, size);
             break;
           case XML_AS_INT:
             tok_len = 8;
-            update_counter(totals.content.text.xml, size);
+            update_counter(shard->totals.content.text.xml, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.text.xml, size);
             break;
           case HTML_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.text.html, size);
+            update_counter(shard->totals.content.text.html, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.text.html, size);
             break;
           case PLAI_AS_INT:
             tok_len = 10;
-            update_counter(totals.content.text.plain, size);
+            update_counter(shard->totals.content.text.plain, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.text.plain, size);
             break;
           default:
             tok_len = 5 + strlen(tok);;
-            update_counter(totals.content.text.other, size);
+            update_counter(shard->totals.content.text.other, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.text.other, size);
             break;
           }
         } else if (0 == strncmp(read_from, "application", 11)) {
           tok = read_from + 12;
-          update_counter(totals.content.application.total, size);
+          update_counter(shard->totals.content.application.total, size);
           if (o_stats != NULL)
             update_counter(o_stats->content.application.total, size);
           switch (*reinterpret_cast <int*>(tok)) {
           case ZIP_AS_INT:
             tok_len = 15;
-            update_counter(totals.content.application.zip, size);
+            update_counter(shard->totals.content.application.zip, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.application.zip, size);
             break;
           case JAVA_AS_INT:
-            update_counter(totals.content.application.javascript, size);
+            update_counter(shard->totals.content.application.javascript, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.application.javascript, size);
           case X_JA_AS_INT:
             tok_len = 24;
-            update_counter(totals.content.application.javascript, size);
+            update_counter(shard->totals.content.application.javascript, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.application.javascript, size);
             break;
           case RSSp_AS_INT:
             if (0 == strcmp(tok+4, "xml")) {
               tok_len = 19;
-              update_counter(totals.content.application.rss_xml, size);
+              update_counter(shard->totals.content.application.rss_xml, size);
               if (o_stats != NULL)
                 update_counter(o_stats->content.application.rss_xml, size);
             } else if (0 == strcmp(tok+4,"atom")) {
               tok_len = 20;
-              update_counter(totals.content.application.rss_atom, size);
+              update_counter(shard->totals.content.application.rss_atom, size);
               if (o_stats != NULL)
                 update_counter(o_stats->content.application.rss_atom, size);
             } else {
               tok_len = 12 + strlen(tok);
-              update_counter(totals.content.application.rss_other, size);
+              update_counter(shard->totals.content.application.rss_other, size);
               if (o_stats != NULL)
                 update_counter(o_stats->content.application.rss_other, size);
             }
@@ -1588,17 +1717,17 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
           default:
             if (0 == strcmp(tok, "x-shockwave-flash")) {
               tok_len = 29;
-              update_counter(totals.content.application.shockwave_flash, size);
+              update_counter(shard->totals.content.application.shockwave_flash, size);
               if (o_stats != NULL)
                 update_counter(o_stats->content.application.shockwave_flash, size);
             } else if (0 == strcmp(tok, "x-quicktimeplayer")) {
               tok_len = 29;
-              update_counter(totals.content.application.quicktime, size);
+              update_counter(shard->totals.content.application.quicktime, size);
               if (o_stats != NULL)
                 update_counter(o_stats->content.application.quicktime, size);
             } else {
               tok_len = 12 + strlen(tok);
-              update_counter(totals.content.application.other, size);
+              update_counter(shard->totals.content.application.other, size);
               if (o_stats != NULL)
                 update_counter(o_stats->content.application.other, size);
             }
@@ -1606,30 +1735,30 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
         } else if (0 == strncmp(read_from, "audio", 5)) {
           tok = read_from + 6;
           tok_len = 6 + strlen(tok);
-          update_counter(totals.content.audio.total, size);
+          update_counter(shard->totals.content.audio.total, size);
           if (o_stats != NULL)
             update_counter(o_stats->content.audio.total, size);
           if ((0 == strcmp(tok, "x-wav")) || (0 == strcmp(tok, "wav"))) {
-            update_counter(totals.content.audio.wav, size);
+            update_counter(shard->totals.content.audio.wav, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.audio.wav, size);
           } else if ((0 == strcmp(tok, "x-mpeg")) || (0 == strcmp(tok, "mpeg"))) {
-            update_counter(totals.content.audio.mpeg, size);
+            update_counter(shard->totals.content.audio.mpeg, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.audio.mpeg, size);
           } else {
-            update_counter(totals.content.audio.other, size);
+            update_counter(shard->totals.content.audio.other, size);
             if (o_stats != NULL)
               update_counter(o_stats->content.audio.other, size);
           }
         } else if ('-' == *read_from) {
           tok_len = 1;
-          update_counter(totals.content.none, size);
+          update_counter(shard->totals.content.none, size);
           if (o_stats != NULL)
             update_counter(o_stats->content.none, size);
         } else {
           tok_len = strlen(read_from);
-          update_counter(totals.content.other, size);
+          update_counter(shard->totals.content.other, size);
           if (o_stats != NULL)
             update_counter(o_stats->content.other, size);
         }
@@ -1640,7 +1769,7 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
       case P_STATE_END:
         // Nothing to do really
         if (flag) {
-          parse_errors++;
+          shard->parse_errors++;
         }
         break;
       }
@@ -1653,9 +1782,10 @@ parse_log_buff(LogBufferHeader * buf_header, bool summary = false)
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Process a file (FD)
+// Process a file (FD) with read(), this is used for whatever can't be
+// mmap'ed, and for a partial LogBuffer at the end of a mapped file.
 int
-process_file(int in_fd, off_t offset, unsigned max_age)
+process_stream(int in_fd, off_t offset, unsigned max_age, ParseShard * shard)
 {
   char buffer[MAX_LOGBUFFER_SIZE];
   int nread, buffer_bytes;
@@ -1757,7 +1887,7 @@ process_file(int in_fd, off_t offset, unsigned max_age)
 
     // Possibly skip too old entries (the entire buffer is skipped)
     if (header->high_timestamp >= max_age) {
-      if (parse_log_buff(header, cl.summary != 0) != 0) {
+      if (parse_log_buff(header, shard, cl.summary != 0) != 0) {
         Debug("logstats", "Failed to parse log buffer.");
         return 1;
       }
@@ -1770,6 +1900,142 @@ process_file(int in_fd, off_t offset, unsigned max_age)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Parser thread, parses a range of LogBuffers into its shard
+void *
+parse_shard(void *arg)
+{
+  ParseShard *shard = static_cast<ParseShard *>(arg);
+
+  for (int i = 0; i < shard->num_buffers; ++i) {
+    LogBufferHeader *header = shard->buffers[i];
+
+    // Possibly skip too old entries (the entire buffer is skipped)
+    if (header->high_timestamp >= shard->max_age) {
+      if (parse_log_buff(header, shard, cl.summary != 0) != 0) {
+        Debug("logstats", "Failed to parse log buffer.");
+        shard->ret = 1;
+        break;
+      }
+    } else {
+      Debug("logstats", "Skipping old buffer (age=%d, max=%d)", header->high_timestamp, shard->max_age);
+    }
+  }
+
+  return NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Process a file (FD). Regular files are mmap'ed and split on LogBuffer
+// boundaries, each parser thread gets a contiguous range of LogBuffers
+// which it aggregates into its own shard. The shards are merged once all
+// threads are done, so the output is the same regardless of the number of
+// threads. Whatever is left after the last complete LogBuffer is handed to
+// process_stream(), which also leaves the FD at the end of what was parsed.
+int
+process_file(int in_fd, off_t offset, unsigned max_age)
+{
+  struct stat stat_buf;
+  char *base = (char *)MAP_FAILED;
+  off_t pos;
+  int ret = 0;
+  std::vector<LogBufferHeader *> buffers;
+
+  Debug("logstats", "Processing file [offset=%" PRId64 "].", (int64_t)offset);
+  // Without an offset, we continue from the current position (e.g. --tail)
+  pos = (offset > 0) ? offset : lseek(in_fd, 0, SEEK_CUR);
+  if ((pos >= 0) && (fstat(in_fd, &stat_buf) == 0) && S_ISREG(stat_buf.st_mode) && (stat_buf.st_size > pos))
+    base = (char *)mmap(NULL, stat_buf.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, in_fd, 0);
+
+  if (MAP_FAILED == base) {
+    ParseShard shard;
+
+    ret = process_stream(in_fd, offset, max_age, &shard);
+    merge_shard(&shard);
+    return ret;
+  }
+  ats_madvise(base, stat_buf.st_size, MADV_SEQUENTIAL);
+
+  // Find the next log header, aligning us properly.
+  if (offset > 0) {
+    Debug("logstats", "Re-aligning file read.");
+    while ((pos + (off_t)sizeof(uint32_t) <= stat_buf.st_size) && (LOG_SEGMENT_COOKIE != *(uint32_t *)(base + pos)))
+      ++pos;
+    if (pos + (off_t)sizeof(uint32_t) > stat_buf.st_size)
+      pos = stat_buf.st_size;
+  }
+
+  // Collect all the complete LogBuffers, anything unexpected is left for
+  // process_stream() to deal with (or complain about).
+  while (pos + (off_t)sizeof(LogBufferHeader) <= stat_buf.st_size) {
+    LogBufferHeader *header = (LogBufferHeader *)(base + pos);
+
+    if ((LOG_SEGMENT_COOKIE != header->cookie) || (LOG_SEGMENT_VERSION != header->version) ||
+        (header->byte_count > (unsigned)MAX_LOGBUFFER_SIZE) || (header->byte_count <= sizeof(LogBufferHeader)) ||
+        (pos + header->byte_count > stat_buf.st_size))
+      break;
+    buffers.push_back(header);
+    pos += header->byte_count;
+  }
+
+  if (!buffers.empty()) {
+    int num_threads = (cl.threads > 0) ? cl.threads : ink_number_of_processors();
+    int per_thread, extra, next = 0;
+
+    // The URL LRU depends on the order of the log entries, so it can only
+    // be maintained by a single parser.
+    if (urls || (num_threads < 1))
+      num_threads = 1;
+    if (num_threads > (int)buffers.size())
+      num_threads = buffers.size();
+
+    ParseShard *shards = new ParseShard[num_threads];
+    ink_thread *threads = new ink_thread[num_threads];
+
+    init_fieldlist(buffers[0]);
+    per_thread = buffers.size() / num_threads;
+    extra = buffers.size() % num_threads;
+    for (int i = 0; i < num_threads; ++i) {
+      shards[i].buffers = &buffers[next];
+      shards[i].num_buffers = per_thread + (i < extra ? 1 : 0);
+      shards[i].max_age = max_age;
+      next += shards[i].num_buffers;
+    }
+
+    Debug("logstats", "Parsing %d log buffers on %d threads.", (int)buffers.size(), num_threads);
+    for (int i = 1; i < num_threads; ++i)
+      threads[i] = ink_thread_create(parse_shard, &shards[i]);
+    parse_shard(&shards[0]);
+
+    // Merge in order.
+    for (int i = 0; i < num_threads; ++i) {
+      if (i > 0)
+        ink_thread_join(threads[i]);
+      merge_shard(&shards[i]);
+      ret |= shards[i].ret;
+    }
+
+    delete[] threads;
+    delete[] shards;
+  }
+  munmap(base, stat_buf.st_size);
+
+  if (0 == ret) {
+    ParseShard shard;
+
+    if (lseek(in_fd, pos, SEEK_SET) < 0) {
+      Debug("logstats", "Internal seek failed (offset=%"  PRId64 ").", (int64_t)pos);
+      return 1;
+    }
+    ret = process_stream(in_fd, 0, max_age, &shard);
+    merge_shard(&shard);
+  }
+
+  return ret;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Determine if this "stat" (Origin Server) is worthwhile to produce a
 // report for.